@@ -0,0 +1,89 @@
+#ifndef CPP_BOUNDED_QUEUE_HH
+#define CPP_BOUNDED_QUEUE_HH
+
+#include <boost/optional.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+namespace tl
+{
+
+/**
+ * @brief Queue passing items between threads with a limited number of
+ *      buffered items.
+ * @details push() blocks while the queue is full and pop() blocks while it is
+ *      empty. After close() the remaining items can still be popped, further
+ *      pushes are dropped.
+ */
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(std::size_t capacity)
+        : _capacity(capacity > 0 ? capacity : 1)
+    {
+    }
+
+    /**
+     * @brief Append an item, waiting for free space.
+     * @return false if the queue was closed and the item was dropped
+     */
+    bool push(T item)
+    {
+        auto lock = std::unique_lock<std::mutex>{_mutex};
+        _not_full.wait(lock,
+                       [this] { return _closed || _items.size() < _capacity; });
+        if(_closed)
+        {
+            return false;
+        }
+        _items.push_back(std::move(item));
+        _not_empty.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Remove the first item, waiting for one to arrive.
+     * @return The item or none if the queue is closed and empty
+     */
+    boost::optional<T> pop()
+    {
+        auto lock = std::unique_lock<std::mutex>{_mutex};
+        _not_empty.wait(lock, [this] { return _closed || !_items.empty(); });
+        if(_items.empty())
+        {
+            return boost::none;
+        }
+        auto item = std::move(_items.front());
+        _items.pop_front();
+        _not_full.notify_one();
+        return item;
+    }
+
+    /**
+     * Signal that no more items will be pushed.
+     */
+    void close()
+    {
+        auto lock = std::lock_guard<std::mutex>{_mutex};
+        _closed = true;
+        _not_empty.notify_all();
+        _not_full.notify_all();
+    }
+
+private:
+    std::size_t _capacity;
+    bool _closed = false;
+    std::deque<T> _items;
+    std::mutex _mutex;
+    std::condition_variable _not_empty;
+    std::condition_variable _not_full;
+};
+
+} // namespace tl
+
+#endif
@@ -0,0 +1,224 @@
+#include "CandidateCache.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+using namespace tl;
+
+// Identifies the file format, increased on incompatible changes
+constexpr char magic[8] = {'T', 'L', 'C', 'A', 'N', 'D', '0', '1'};
+
+
+template <typename T>
+void write(std::ostream& out, const T& value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+
+void write(std::ostream& out, const Vec3d& v)
+{
+    out.write(reinterpret_cast<const char*>(v.data()), 3 * sizeof(double));
+}
+
+
+/**
+ * Reads values from the contents of a file and checks the bounds
+ */
+struct Reader
+{
+    std::vector<char> data;
+    std::size_t pos = 0;
+
+    bool read(void* dest, std::size_t size)
+    {
+        if(size > data.size() - pos)
+        {
+            return false;
+        }
+        std::copy_n(data.data() + pos, size, static_cast<char*>(dest));
+        pos += size;
+        return true;
+    }
+
+    template <typename T>
+    bool read(T& value)
+    {
+        return read(&value, sizeof(T));
+    }
+
+    bool read(Vec3d& v)
+    {
+        return read(v.data(), 3 * sizeof(double));
+    }
+
+    /// Check that @a count items of @a size bytes can still be read before
+    /// allocating memory for them
+    bool fits(uint64_t count, std::size_t size) const
+    {
+        return count <= (data.size() - pos) / size;
+    }
+};
+} // namespace
+
+
+namespace tl
+{
+
+boost::optional<std::string> fileDigest(const std::string& file_name)
+{
+    auto in = std::ifstream{file_name, std::ios::binary};
+    if(!in)
+    {
+        return boost::none;
+    }
+
+    auto hash = uint64_t{14695981039346656037ull};
+    auto buffer = std::vector<char>(1 << 16);
+    while(in)
+    {
+        in.read(buffer.data(), std::streamsize(buffer.size()));
+        for(auto i = std::streamsize{0}; i < in.gcount(); ++i)
+        {
+            hash ^= static_cast<unsigned char>(buffer[std::size_t(i)]);
+            hash *= 1099511628211ull;
+        }
+    }
+    if(in.bad())
+    {
+        return boost::none;
+    }
+
+    auto digest = std::ostringstream{};
+    digest << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return digest.str();
+}
+
+
+void writeCandidates(const std::string& file_name,
+                     const std::string& key,
+                     const std::vector<TLCandidates>& faces)
+{
+    auto out = std::ofstream{file_name, std::ios::binary | std::ios::trunc};
+    if(!out)
+    {
+        throw std::runtime_error("Could not open " + file_name
+                                 + " for writing");
+    }
+
+    out.write(magic, sizeof(magic));
+    write(out, uint64_t(key.size()));
+    out.write(key.data(), std::streamsize(key.size()));
+    write(out, uint64_t(faces.size()));
+    for(const auto& face : faces)
+    {
+        write(out, face.num_splits);
+        write(out, face.max_level);
+        write(out, uint64_t(face.cells.size()));
+        for(const auto& cell : face.cells)
+        {
+            for(const auto& v : cell.pos_tri)
+            {
+                write(out, v);
+            }
+            for(const auto& v : cell.dir_tri)
+            {
+                write(out, v);
+            }
+            write(out, cell.error);
+        }
+        write(out, uint64_t(face.non_line_dirs.size()));
+        for(const auto& dir : face.non_line_dirs)
+        {
+            write(out, dir);
+        }
+    }
+
+    if(!out.flush())
+    {
+        throw std::runtime_error("Could not write " + file_name);
+    }
+}
+
+
+boost::optional<std::vector<TLCandidates>>
+readCandidates(const std::string& file_name, const std::string& key)
+{
+    auto in = std::ifstream{file_name, std::ios::binary};
+    if(!in)
+    {
+        return boost::none;
+    }
+    auto reader = Reader{{std::istreambuf_iterator<char>(in),
+                          std::istreambuf_iterator<char>()}};
+
+    auto file_magic = std::array<char, sizeof(magic)>{};
+    auto key_size = uint64_t{0};
+    if(!reader.read(file_magic.data(), sizeof(magic))
+       || !std::equal(file_magic.begin(), file_magic.end(), magic)
+       || !reader.read(key_size) || key_size != key.size())
+    {
+        return boost::none;
+    }
+    auto file_key = std::string(key.size(), '\0');
+    if(!reader.read(&file_key[0], key.size()) || file_key != key)
+    {
+        return boost::none;
+    }
+
+    // Sizes of a face without cells and directions, a cell, and a direction
+    constexpr auto face_size = 4 * sizeof(uint64_t);
+    constexpr auto cell_size = 19 * sizeof(double);
+    constexpr auto dir_size = 3 * sizeof(double);
+
+    auto num_faces = uint64_t{0};
+    if(!reader.read(num_faces) || !reader.fits(num_faces, face_size))
+    {
+        return boost::none;
+    }
+    auto faces = std::vector<TLCandidates>(num_faces);
+    for(auto& face : faces)
+    {
+        auto num_cells = uint64_t{0};
+        if(!reader.read(face.num_splits) || !reader.read(face.max_level)
+           || !reader.read(num_cells) || !reader.fits(num_cells, cell_size))
+        {
+            return boost::none;
+        }
+        face.cells.resize(num_cells);
+        for(auto& cell : face.cells)
+        {
+            for(auto& v : cell.pos_tri)
+            {
+                reader.read(v);
+            }
+            for(auto& v : cell.dir_tri)
+            {
+                reader.read(v);
+            }
+            reader.read(cell.error);
+        }
+
+        auto num_dirs = uint64_t{0};
+        if(!reader.read(num_dirs) || !reader.fits(num_dirs, dir_size))
+        {
+            return boost::none;
+        }
+        face.non_line_dirs.resize(num_dirs);
+        for(auto& dir : face.non_line_dirs)
+        {
+            reader.read(dir);
+        }
+    }
+    return faces;
+}
+
+} // namespace tl
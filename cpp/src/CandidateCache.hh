@@ -0,0 +1,55 @@
+#ifndef CPP_CANDIDATE_CACHE_HH
+#define CPP_CANDIDATE_CACHE_HH
+
+#include "TensorLines.hh"
+
+#include <boost/optional.hpp>
+
+#include <string>
+#include <vector>
+
+namespace tl
+{
+
+/**
+ * @brief Compute a digest of the contents of a file.
+ * @details Used to key the candidate cache by the input file (64 bit FNV-1a,
+ *      which detects changes but is not collision resistant against
+ *      deliberate modifications).
+ *
+ * @param file_name Name of the file
+ * @return The digest as a hexadecimal string or boost::none if the file could
+ *      not be read
+ */
+boost::optional<std::string> fileDigest(const std::string& file_name);
+
+
+/**
+ * @brief Write the unclustered candidates of all faces to a binary file.
+ * @details The file starts with the key, so that readCandidates() only accepts
+ *      it for the same input and search options. Throws std::runtime_error if
+ *      the file can not be written.
+ *
+ * @param file_name Name of the cache file
+ * @param key Description of everything the candidates depend on
+ * @param faces The candidates of each face
+ */
+void writeCandidates(const std::string& file_name,
+                     const std::string& key,
+                     const std::vector<TLCandidates>& faces);
+
+
+/**
+ * Read the candidates written by writeCandidates().
+ *
+ * @param file_name Name of the cache file
+ * @param key Description of everything the candidates depend on
+ * @return The candidates of each face or boost::none if the file does not
+ *      exist, is damaged, or was written for a different key
+ */
+boost::optional<std::vector<TLCandidates>>
+readCandidates(const std::string& file_name, const std::string& key);
+
+} // namespace tl
+
+#endif
@@ -75,7 +75,10 @@ enum class Result
 {
     Accept,
     Discard,
-    Split
+    Split,
+    /// The decision requires coefficients of higher precision. Only returned
+    /// by evaluators with reduced precision.
+    Promote
 };
 
 
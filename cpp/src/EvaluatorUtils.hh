@@ -3,8 +3,12 @@
 
 #include "Evaluator.hh"
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <iterator>
+#include <limits>
+#include <utility>
 
 #include <boost/range/adaptor/transformed.hpp>
 #include <boost/range/algorithm/max_element.hpp>
@@ -50,6 +54,25 @@ auto derivatives(
 }
 
 
+/**
+ * Convert an array of polynomials to a different coefficient type (see
+ * TensorProductBezierTriangleBase::cast()).
+ *
+ * @tparam Real New type of the coefficients and coordinates
+ */
+template <typename Real, typename TPBT, std::size_t N>
+auto cast_all(const std::array<TPBT, N>& polys)
+{
+    using Poly = decltype(polys[0].template cast<Real>());
+    auto result = std::array<Poly, N>{};
+    for(auto i: cpp_utils::range(N))
+    {
+        result[i] = polys[i].template cast<Real>();
+    }
+    return result;
+}
+
+
 /**
  * @brief Compute an upper bound for the magnitude of the function value.
  * @details Finds the coefficient with the maximum absolute value.
@@ -64,7 +87,7 @@ template <typename TPBT,
 double abs_upper_bound(
         const TensorProductBezierTriangleBase<TPBT, T, C, Degrees...>& poly)
 {
-    return boost::accumulate(poly.coefficients(), 0., MaxAbs{});
+    return boost::accumulate(poly.coefficients(), T{0}, MaxAbs{});
 }
 
 
@@ -90,6 +113,412 @@ double abs_max_upper_bound(const TPBTSeq& polys)
 }
 
 
+/**
+ * @brief Compute bounds for the range of the polynomial.
+ * @details By the convex hull property of the Bernstein basis, the function
+ *      values lie between the smallest and the largest coefficient.
+ *
+ * @param poly The polynomial
+ * @return Lower and upper bound for poly(x) on the triangles
+ */
+template <typename TPBT,
+          typename T,
+          typename C,
+          std::size_t... Degrees>
+std::pair<double, double> bernstein_range(
+        const TensorProductBezierTriangleBase<TPBT, T, C, Degrees...>& poly)
+{
+    return poly.range();
+}
+
+
+/**
+ * Compute bernstein_range() for all polynomials of an array.
+ */
+template <typename TPBT, std::size_t N>
+std::array<std::pair<double, double>, N>
+bernstein_ranges(const std::array<TPBT, N>& polys)
+{
+    auto result = std::array<std::pair<double, double>, N>{};
+    for(auto i: cpp_utils::range(N))
+    {
+        result[i] = bernstein_range(polys[i]);
+    }
+    return result;
+}
+
+
+/**
+ * @brief Split all polynomials of an array in the same way (see
+ *      TensorProductBezierTriangleBase::split()).
+ * @details Computes the Bernstein range of each new polynomial right after
+ *      its coefficients, while they are still in registers or cache, so that
+ *      evaluating the result does not need another pass over the
+ *      coefficients.
+ *
+ * @param polys The polynomials
+ * @param part Index of the sub-triangle of the split (0-3)
+ * @param ranges Output parameter for the Bernstein ranges of the new
+ *      polynomials
+ * @tparam D Space in which to split
+ * @return The polynomials on the sub-triangle
+ */
+template <std::size_t D, typename TPBT, std::size_t N>
+std::array<TPBT, N> split_all(const std::array<TPBT, N>& polys,
+                              std::size_t part,
+                              std::array<std::pair<double, double>, N>& ranges)
+{
+    auto result = std::array<TPBT, N>{};
+    for(auto i: cpp_utils::range(N))
+    {
+        result[i] = polys[i].template split<D>(part);
+        ranges[i] = bernstein_range(result[i]);
+    }
+    return result;
+}
+
+
+#ifdef TL_HAS_VECTOR_TYPES
+/**
+ * Coefficient type for processing W polynomials of the same type at once.
+ * Lane i of each coefficient belongs to the i-th polynomial.
+ */
+template <typename Real, std::size_t W>
+struct LanesType
+{
+    static_assert((W & (W - 1)) == 0, "W must be a power of two");
+    using type [[gnu::vector_size(W * sizeof(Real))]] = Real;
+};
+
+template <typename Real, std::size_t W>
+using Lanes = typename LanesType<Real, W>::type;
+
+
+/**
+ * Polynomial type holding the coefficients of W polynomials of type @a TPBT
+ * in lanes (see Lanes).
+ */
+template <typename TPBT, std::size_t W>
+using LanePolynomial = decltype(std::declval<TPBT>().template cast<
+                                Lanes<typename TPBT::Coeffs::value_type, W>,
+                                typename TPBT::Coords::Scalar>());
+
+
+/**
+ * Store an array of polynomials in one lane of an array of lane polynomials.
+ *
+ * @param lanes The lane polynomials
+ * @param lane Index of the lane
+ * @param polys The polynomials to store
+ */
+template <typename LanePoly, typename TPBT, std::size_t N>
+void set_lane(std::array<LanePoly, N>& lanes,
+              std::size_t lane,
+              const std::array<TPBT, N>& polys)
+{
+    for(auto i: cpp_utils::range(N))
+    {
+        for(auto j: cpp_utils::range(TPBT::NCoeffs))
+        {
+            lanes[i][j][lane] = polys[i][j];
+        }
+    }
+}
+
+
+/**
+ * Extract an array of polynomials from one lane of an array of lane
+ * polynomials.
+ *
+ * @param lanes The lane polynomials
+ * @param lane Index of the lane
+ * @tparam TPBT Type of the extracted polynomials
+ * @return The polynomials stored in the lane
+ */
+template <typename TPBT, typename LanePoly, std::size_t N>
+std::array<TPBT, N> get_lane(const std::array<LanePoly, N>& lanes,
+                             std::size_t lane)
+{
+    auto result = std::array<TPBT, N>{};
+    for(auto i: cpp_utils::range(N))
+    {
+        for(auto j: cpp_utils::range(TPBT::NCoeffs))
+        {
+            result[i][j] = lanes[i][j][lane];
+        }
+    }
+    return result;
+}
+
+
+/**
+ * @brief Apply the sign test of range_bound() to all lanes of an array of
+ *      lane polynomials.
+ * @details Computes the Bernstein range of all polynomials in all lanes at
+ *      once without branches. The mask is updated in place, since passing
+ *      vector types by value depends on the enabled instruction sets.
+ *
+ * @param lanes The lane polynomials
+ * @param has_root Mask of the lanes (-1 for true and 0 for false). Cleared
+ *      for the lanes where one of the polynomials can not have a root on the
+ *      triangles.
+ */
+template <typename LanePoly, std::size_t N, typename Mask>
+void lanes_have_root(const std::array<LanePoly, N>& lanes, Mask& has_root)
+{
+    for(const auto& poly: lanes)
+    {
+        const auto& coeffs = poly.coefficients();
+        auto lo = coeffs[0];
+        auto hi = coeffs[0];
+        for(const auto& c: coeffs)
+        {
+            lo = c < lo ? c : lo;
+            hi = hi < c ? c : hi;
+        }
+        has_root &= ~((lo > 0) | (hi < 0));
+    }
+}
+#endif
+
+
+/**
+ * Result of checking a sequence of polynomials with range_max_upper_bound()
+ * or range_bound()
+ */
+struct RangeBound
+{
+    /// False if one of the polynomials can not become zero on the triangles
+    bool has_root;
+    /// True if the sign test of one of the polynomials can not be decided
+    /// because of the rounding error of the coefficients
+    bool ambiguous;
+    /// Upper bound for the magnitude of all polynomials on the triangles
+    double abs_max;
+};
+
+
+/**
+ * @brief Combine the Bernstein ranges of a number of polynomials.
+ * @details Evaluates the sign test and the magnitude bound of all
+ *      polynomials. The magnitude bound is only meaningful if @c has_root is
+ *      true.
+ *
+ * @param ranges A sequence (range) of lower and upper bounds of polynomials
+ *      (see bernstein_range())
+ * @param rounding_error Bound for the absolute error of the coefficients.
+ *      Polynomials are only excluded if the sign test holds with this margin.
+ * @return Whether all polynomials can have a root on the triangles and an
+ *      upper bound for std::abs(poly(x)) over all polynomials
+ */
+template <typename RangeSeq>
+RangeBound range_bound(const RangeSeq& ranges, double rounding_error = 0.)
+{
+    auto ambiguous = false;
+    auto abs_max = 0.;
+    for(const auto& range: ranges)
+    {
+        if(range.first > rounding_error || range.second < -rounding_error)
+        {
+            return {false, false, abs_max};
+        }
+        ambiguous = ambiguous || range.first > -rounding_error
+                    || range.second < rounding_error;
+        abs_max = std::max({abs_max, -range.first, range.second});
+    }
+    return {true, ambiguous && rounding_error > 0, abs_max};
+}
+
+
+/**
+ * @brief Compute the Bernstein range of a number of polynomials.
+ * @details Combines the sign test and the magnitude bound of all polynomials
+ *      in one pass over the coefficients (see range_bound()).
+ *
+ * @param polys A sequence (range) of polynomials
+ * @param rounding_error Bound for the absolute error of the coefficients.
+ *      Polynomials are only excluded if the sign test holds with this margin.
+ * @return Whether all polynomials can have a root on the triangles and an
+ *      upper bound for std::abs(poly(x)) over all polynomials
+ */
+template <typename TPBTSeq>
+RangeBound range_max_upper_bound(const TPBTSeq& polys,
+                                 double rounding_error = 0.)
+{
+    using namespace boost::adaptors;
+    return range_bound(polys | transformed([](const auto& f) {
+                           return bernstein_range(f);
+                       }),
+                       rounding_error);
+}
+
+
+/**
+ * @brief Check if two polynomials can have a common root.
+ * @details Projects the control net of the vector valued polynomial (f, g)
+ *      onto the plane and checks whether all control points lie strictly
+ *      inside an open half-plane bounded by a line through the origin. In
+ *      that case there are weights u and v such that all coefficients of
+ *      u*f + v*g are positive. By the convex hull property of the Bernstein
+ *      basis, the linear combination is positive on the whole triangle, so f
+ *      and g can not vanish at the same point.
+ *
+ *      The test is done incrementally by maintaining the cone spanned by the
+ *      control points seen so far (counter-clockwise from @c r to @c l).
+ *
+ * @param f The first polynomial
+ * @param g The second polynomial (must be of the same type as @a f)
+ * @param margin Optional output parameter for storing the smallest distance
+ *      of a control point from the bisecting line of the cone, if f and g have
+ *      no common root
+ * @return False if f and g certainly have no common root on the triangles
+ */
+template <typename TPBT,
+          typename T,
+          typename C,
+          std::size_t... Degrees>
+bool has_common_root(
+        const TensorProductBezierTriangleBase<TPBT, T, C, Degrees...>& f,
+        const TensorProductBezierTriangleBase<TPBT, T, C, Degrees...>& g,
+        double* margin = nullptr)
+{
+    const auto& a = f.coefficients();
+    const auto& b = g.coefficients();
+
+    auto cross = [](double x1, double y1, double x2, double y2) {
+        return x1 * y2 - y1 * x2;
+    };
+
+    double rx = a[0], ry = b[0];
+    double lx = a[0], ly = b[0];
+    for(auto i: cpp_utils::range(a.size()))
+    {
+        double px = a[i], py = b[i];
+        auto cr = cross(rx, ry, px, py);
+        auto cl = cross(px, py, lx, ly);
+        // Point inside the current cone
+        if(cr >= 0 && cl >= 0
+           && (rx * px + ry * py > 0 || lx * px + ly * py > 0))
+        {
+            continue;
+        }
+        // Widen the cone clockwise or counter-clockwise if its opening angle
+        // stays below pi
+        if(cr < 0 && cl > 0)
+        {
+            rx = px;
+            ry = py;
+        }
+        else if(cr > 0 && cl < 0)
+        {
+            lx = px;
+            ly = py;
+        }
+        else
+        {
+            return true;
+        }
+    }
+
+    if(margin)
+    {
+        // Distance along the normalized bisector of the cone
+        auto rn = std::hypot(rx, ry);
+        auto ln = std::hypot(lx, ly);
+        auto nx = rx / rn + lx / ln;
+        auto ny = ry / rn + ly / ln;
+        auto nn = std::hypot(nx, ny);
+        *margin = std::numeric_limits<double>::max();
+        for(auto i: cpp_utils::range(a.size()))
+        {
+            *margin = std::min(*margin, (nx * a[i] + ny * b[i]) / nn);
+        }
+    }
+    return false;
+}
+
+
+/**
+ * @brief Check if all polynomials of a sequence can have a common root.
+ * @details Applies has_common_root() to all pairs of polynomials.
+ *
+ * @param polys A sequence (range) of polynomials of the same type
+ * @return False if two polynomials certainly have no common root on the
+ *      triangles
+ */
+template <typename TPBTSeq>
+bool pairwise_common_root(const TPBTSeq& polys)
+{
+    for(auto it = std::begin(polys); it != std::end(polys); ++it)
+    {
+        for(auto jt = std::next(it); jt != std::end(polys); ++jt)
+        {
+            if(!has_common_root(*it, *jt))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+
+/**
+ * Result of pairwise_exclusion()
+ */
+enum class Exclusion
+{
+    /// Two polynomials certainly have no common root
+    Excluded,
+    /// A pair of polynomials is only separated by less than the rounding
+    /// error of the coefficients
+    Ambiguous,
+    /// All polynomials might have a common root
+    Possible
+};
+
+
+/**
+ * @brief Check if all polynomials of a sequence can have a common root when
+ *      the coefficients carry a rounding error.
+ * @details Like pairwise_common_root(), but a pair of polynomials is only
+ *      excluded if every control point keeps its distance from the separating
+ *      line when each coefficient is perturbed by up to @a rounding_error.
+ *
+ * @param polys A sequence (range) of polynomials of the same type
+ * @param rounding_error Bound for the absolute error of the coefficients
+ * @return The outcome of the test
+ */
+template <typename TPBTSeq>
+Exclusion pairwise_exclusion(const TPBTSeq& polys, double rounding_error)
+{
+    if(rounding_error <= 0)
+    {
+        return pairwise_common_root(polys) ? Exclusion::Possible
+                                           : Exclusion::Excluded;
+    }
+    auto result = Exclusion::Possible;
+    for(auto it = std::begin(polys); it != std::end(polys); ++it)
+    {
+        for(auto jt = std::next(it); jt != std::end(polys); ++jt)
+        {
+            auto margin = 0.;
+            if(!has_common_root(*it, *jt, &margin))
+            {
+                // A perturbation of both coordinates moves a point by at most
+                // sqrt(2) * rounding_error
+                if(margin > std::sqrt(2.) * rounding_error)
+                {
+                    return Exclusion::Excluded;
+                }
+                result = Exclusion::Ambiguous;
+            }
+        }
+    }
+    return result;
+}
+
+
 /**
  * @brief Compute an upper bound for the gradient magnitude of the polynomial in
  *      the space indicated by @a D.
@@ -0,0 +1,548 @@
+#include "LineWriter.hh"
+
+#include <Eigen/Geometry>
+
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+using namespace tl;
+
+template <typename T>
+void write(std::ostream& out, const T& value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+
+void write(std::ostream& out, const Vec3d& v)
+{
+    out.write(reinterpret_cast<const char*>(v.data()), 3 * sizeof(double));
+}
+
+
+/// Point attribute written to a column
+struct Attribute
+{
+    // Key used to select the attribute and in .npy file names
+    const char* key;
+    // Name of the array in vtkTensorLines' output
+    const char* name;
+    const char* type;
+    int components;
+    void (*write)(std::ostream&, const TLPoint&);
+};
+
+
+// The points followed by the point data arrays of vtkTensorLines' output
+const Attribute attributes[] = {
+        {"pos",
+         "Points",
+         "Float64",
+         3,
+         [](std::ostream& out, const TLPoint& p) { write(out, p.pos); }},
+        {"rank1",
+         "Rank1",
+         "Float64",
+         1,
+         [](std::ostream& out, const TLPoint& p) {
+             write(out, double(p.s_rank));
+         }},
+        {"rank2",
+         "Rank2",
+         "Float64",
+         1,
+         [](std::ostream& out, const TLPoint& p) {
+             write(out, double(p.t_rank));
+         }},
+        {"eigenvalue1",
+         "Eigenvalue 1",
+         "Float64",
+         1,
+         [](std::ostream& out, const TLPoint& p) { write(out, p.s_eival); }},
+        {"eigenvalue2",
+         "Eigenvalue 2",
+         "Float64",
+         1,
+         [](std::ostream& out, const TLPoint& p) { write(out, p.t_eival); }},
+        {"eivec",
+         "Eigenvector",
+         "Float64",
+         3,
+         [](std::ostream& out, const TLPoint& p) { write(out, p.eivec); }},
+        {"imaginary1",
+         "Imaginary 1",
+         "Float64",
+         1,
+         [](std::ostream& out, const TLPoint& p) {
+             write(out, p.s_has_imaginary ? 1. : 0.);
+         }},
+        {"imaginary2",
+         "Imaginary 2",
+         "Float64",
+         1,
+         [](std::ostream& out, const TLPoint& p) {
+             write(out, p.t_has_imaginary ? 1. : 0.);
+         }},
+        {"cluster_size",
+         "Cluster Size",
+         "UInt64",
+         1,
+         [](std::ostream& out, const TLPoint& p) {
+             write(out, uint64_t(p.cluster_size));
+         }},
+        {"pos_uncertainty",
+         "Position Uncertainty",
+         "Float64",
+         1,
+         [](std::ostream& out, const TLPoint& p) {
+             write(out, p.pos_uncertainty);
+         }},
+        {"dir_uncertainty",
+         "Direction Uncertainty",
+         "Float64",
+         1,
+         [](std::ostream& out, const TLPoint& p) {
+             write(out, p.dir_uncertainty);
+         }},
+        {"line_stability",
+         "Line Stability",
+         "Float64",
+         1,
+         [](std::ostream& out, const TLPoint& p) {
+             write(out, p.line_stability);
+         }}};
+
+
+bool littleEndian()
+{
+    const auto one = uint16_t{1};
+    return *reinterpret_cast<const uint8_t*>(&one) == 1;
+}
+
+
+// Size of the .npy headers, which are written before the number of points is
+// known and completed by finish()
+constexpr std::size_t npy_header_size = 128;
+
+
+/**
+ * @brief Header of a NumPy array file (format version 1.0).
+ *
+ * @param type VTK name of the value type
+ * @param rows Number of rows
+ * @param components Number of columns, 1 for a one-dimensional array
+ * @return The header, padded to npy_header_size bytes
+ */
+std::string npyHeader(const std::string& type, uint64_t rows, int components)
+{
+    auto dict = std::ostringstream{};
+    dict << "{'descr': '" << (littleEndian() ? '<' : '>')
+         << (type == "Float64" ? 'f' : type == "UInt64" ? 'u' : 'i')
+         << "8', 'fortran_order': False, 'shape': (" << rows;
+    if(components == 1)
+    {
+        dict << ",), }";
+    }
+    else
+    {
+        dict << ", " << components << "), }";
+    }
+
+    auto header = std::string{"\x93NUMPY\x01\x00", 8};
+    const auto length = npy_header_size - 10;
+    header += char(length & 0xff);
+    header += char(length >> 8);
+    header += dict.str();
+    header.resize(npy_header_size - 1, ' ');
+    header += '\n';
+    return header;
+}
+
+
+/// Append an array with its size in front, as in VTK's appended raw data
+void writeArray(std::ostream& out, const std::vector<int64_t>& values)
+{
+    write(out, uint64_t(values.size() * sizeof(int64_t)));
+    out.write(reinterpret_cast<const char*>(values.data()),
+              std::streamsize(values.size() * sizeof(int64_t)));
+}
+
+
+/// Write point indices to a .npy file
+void writeNpy(const std::string& file_name,
+              const std::vector<int64_t>& values,
+              int components)
+{
+    auto out = std::ofstream{file_name, std::ios::binary | std::ios::trunc};
+    out << npyHeader("Int64", values.size() / std::size_t(components),
+                     components);
+    out.write(reinterpret_cast<const char*>(values.data()),
+              std::streamsize(values.size() * sizeof(int64_t)));
+    if(!out.flush())
+    {
+        throw std::runtime_error("Could not write " + file_name);
+    }
+}
+} // namespace
+
+
+namespace tl
+{
+
+struct StreamingLineWriter::Column
+{
+    const Attribute* attribute;
+    std::string file_name;
+    std::ofstream out;
+};
+
+
+CellConnections connectCellPoints(const std::vector<Vec3d>& eivecs)
+{
+    using Matrix3X = Eigen::Matrix3Xd;
+    using MatrixX = Eigen::MatrixXd;
+
+    auto connections = CellConnections{};
+    const auto npoints = eivecs.size();
+    if(npoints == 2)
+    {
+        connections.lines.push_back({0, 1});
+        return connections;
+    }
+
+    // Compute pairwise vector deviations
+    const auto n = Matrix3X::Index(npoints);
+    auto dist = MatrixX::Ones(n, n).eval();
+    for(auto i = Matrix3X::Index{0}; i < n; ++i)
+    {
+        for(auto j = i + 1; j < n; ++j)
+        {
+            dist(i, j) = eivecs[std::size_t(i)]
+                                 .cross(eivecs[std::size_t(j)])
+                                 .squaredNorm();
+        }
+    }
+
+    // Greedily find closest two vectors and connect
+    auto unlinked = std::vector<bool>(npoints, true);
+    if(npoints < 10)
+    {
+        while(dist.sum() < double(npoints * npoints))
+        {
+            auto row = Matrix3X::Index{};
+            auto col = Matrix3X::Index{};
+            dist.minCoeff(&row, &col);
+            connections.lines.push_back({std::size_t(row), std::size_t(col)});
+            dist.col(col).setOnes();
+            dist.col(row).setOnes();
+            dist.row(col).setOnes();
+            dist.row(row).setOnes();
+            unlinked[std::size_t(row)] = false;
+            unlinked[std::size_t(col)] = false;
+        }
+    }
+
+    for(auto i = std::size_t{0}; i < npoints; ++i)
+    {
+        if(unlinked[i])
+        {
+            connections.vertices.push_back(i);
+        }
+    }
+    return connections;
+}
+
+
+std::vector<std::string> lineAttributeKeys()
+{
+    auto keys = std::vector<std::string>{};
+    for(const auto& attribute : attributes)
+    {
+        keys.push_back(attribute.key);
+    }
+    return keys;
+}
+
+
+std::string lineAttributeName(const std::string& key)
+{
+    for(const auto& attribute : attributes)
+    {
+        if(key == attribute.key)
+        {
+            return attribute.name;
+        }
+    }
+    throw std::invalid_argument("Unknown point attribute " + key);
+}
+
+
+StreamingLineWriter::StreamingLineWriter(
+        const std::string& file_name,
+        LineFileFormat format,
+        const std::vector<std::string>& selected)
+    : _file_name(file_name), _format(format)
+{
+    for(const auto& key : selected)
+    {
+        lineAttributeName(key);
+    }
+
+    for(const auto& attribute : attributes)
+    {
+        // VTK files always need the points
+        const auto is_points = &attribute == std::begin(attributes);
+        if(std::find(selected.begin(), selected.end(), attribute.key)
+                      == selected.end()
+           && !(is_points && format == LineFileFormat::VtkXml))
+        {
+            continue;
+        }
+
+        // .npy columns are written in place, VTK columns are copied into the
+        // output behind the header
+        auto column = std::unique_ptr<Column>(new Column{
+                &attribute,
+                format == LineFileFormat::Npy
+                        ? file_name + '.' + attribute.key + ".npy"
+                        : file_name + ".column"
+                                  + std::to_string(_columns.size()),
+                {}});
+        column->out.open(column->file_name,
+                         std::ios::binary | std::ios::trunc);
+        if(format == LineFileFormat::Npy)
+        {
+            column->out << npyHeader(attribute.type, 0, attribute.components);
+        }
+        if(!column->out)
+        {
+            throw std::runtime_error("Could not open " + column->file_name
+                                     + " for writing");
+        }
+        _columns.push_back(std::move(column));
+    }
+}
+
+
+StreamingLineWriter::~StreamingLineWriter()
+{
+    for(auto& column : _columns)
+    {
+        column->out.close();
+        // Remove the temporary columns, and incomplete .npy files
+        if(_format == LineFileFormat::VtkXml || !_finished)
+        {
+            std::remove(column->file_name.c_str());
+        }
+    }
+}
+
+
+void StreamingLineWriter::addPoints(uint64_t cell_id, const PointList& points)
+{
+    for(const auto& p : points)
+    {
+        for(auto& column : _columns)
+        {
+            column->attribute->write(column->out, p);
+        }
+        _point_cells.emplace_back(cell_id, _num_points++);
+        _eivecs.push_back(p.eivec);
+    }
+    if(!points.empty() && !_columns.empty() && !_columns.back()->out)
+    {
+        throw std::runtime_error("Could not write the points of "
+                                 + _file_name);
+    }
+}
+
+
+void StreamingLineWriter::finish()
+{
+    for(auto& column : _columns)
+    {
+        if(_format == LineFileFormat::Npy)
+        {
+            // Complete the header with the number of points
+            column->out.seekp(0);
+            column->out << npyHeader(column->attribute->type,
+                                     _num_points,
+                                     column->attribute->components);
+        }
+        column->out.close();
+        if(!column->out)
+        {
+            throw std::runtime_error("Could not write " + column->file_name);
+        }
+    }
+
+    // Group the points by cell, keeping the order in which they were added
+    std::sort(_point_cells.begin(), _point_cells.end());
+    auto line_ids = std::vector<int64_t>{};
+    auto vertex_ids = std::vector<int64_t>{};
+    auto cell_points = std::vector<uint64_t>{};
+    auto cell_eivecs = std::vector<Vec3d>{};
+    for(auto begin = std::size_t{0}; begin < _point_cells.size();)
+    {
+        auto end = begin;
+        cell_points.clear();
+        cell_eivecs.clear();
+        while(end < _point_cells.size()
+              && _point_cells[end].first == _point_cells[begin].first)
+        {
+            cell_points.push_back(_point_cells[end].second);
+            cell_eivecs.push_back(_eivecs[_point_cells[end].second]);
+            ++end;
+        }
+        const auto connections = connectCellPoints(cell_eivecs);
+        for(const auto& line : connections.lines)
+        {
+            line_ids.push_back(int64_t(cell_points[line[0]]));
+            line_ids.push_back(int64_t(cell_points[line[1]]));
+        }
+        for(auto v : connections.vertices)
+        {
+            vertex_ids.push_back(int64_t(cell_points[v]));
+        }
+        begin = end;
+    }
+    _point_cells = {};
+    _eivecs = {};
+
+    if(_format == LineFileFormat::Npy)
+    {
+        writeNpy(_file_name + ".segments.npy", line_ids, 2);
+        writeNpy(_file_name + ".vertices.npy", vertex_ids, 1);
+    }
+    else
+    {
+        writeVtkXml(line_ids, vertex_ids);
+    }
+    _finished = true;
+}
+
+
+void StreamingLineWriter::writeVtkXml(const std::vector<int64_t>& line_ids,
+                                      const std::vector<int64_t>& vertex_ids)
+{
+    auto vertex_offsets = std::vector<int64_t>(vertex_ids.size());
+    for(auto i = std::size_t{0}; i < vertex_offsets.size(); ++i)
+    {
+        vertex_offsets[i] = int64_t(i + 1);
+    }
+    auto line_offsets = std::vector<int64_t>(line_ids.size() / 2);
+    for(auto i = std::size_t{0}; i < line_offsets.size(); ++i)
+    {
+        line_offsets[i] = int64_t(2 * (i + 1));
+    }
+
+    // Every array is preceded by its size in bytes
+    auto offset = uint64_t{0};
+    auto data_array = [&](const char* name,
+                          const char* type,
+                          int components,
+                          uint64_t size) {
+        auto xml = std::ostringstream{};
+        xml << "        <DataArray type=\"" << type << "\" Name=\"" << name
+            << "\" NumberOfComponents=\"" << components
+            << "\" format=\"appended\" offset=\"" << offset << "\"/>\n";
+        offset += sizeof(uint64_t) + size;
+        return xml.str();
+    };
+    auto column_array = [&](const Column& column) {
+        const auto* attribute = column.attribute;
+        return data_array(attribute->name,
+                          attribute->type,
+                          attribute->components,
+                          _num_points * uint64_t(attribute->components) * 8);
+    };
+    auto cell_arrays = [&](const std::vector<int64_t>& ids,
+                           const std::vector<int64_t>& offsets) {
+        auto xml = data_array("connectivity", "Int64", 1, ids.size() * 8);
+        return xml + data_array("offsets", "Int64", 1, offsets.size() * 8);
+    };
+
+    // The points are the first column, the others are point data
+    const auto has_eivecs =
+            std::any_of(_columns.begin(), _columns.end(), [](const auto& c) {
+                return std::string{c->attribute->key} == "eivec";
+            });
+    auto header = std::ostringstream{};
+    header << "<?xml version=\"1.0\"?>\n"
+           << "<VTKFile type=\"PolyData\" version=\"1.0\" byte_order=\""
+           << (littleEndian() ? "LittleEndian" : "BigEndian")
+           << "\" header_type=\"UInt64\">\n"
+           << "  <PolyData>\n"
+           << "    <Piece NumberOfPoints=\"" << _num_points
+           << "\" NumberOfVerts=\"" << vertex_offsets.size()
+           << "\" NumberOfLines=\"" << line_offsets.size()
+           << "\" NumberOfStrips=\"0\" NumberOfPolys=\"0\">\n"
+           << "      <PointData"
+           << (has_eivecs ? " Vectors=\"Eigenvector\">\n" : ">\n");
+    for(auto i = std::size_t{1}; i < _columns.size(); ++i)
+    {
+        header << column_array(*_columns[i]);
+    }
+    header << "      </PointData>\n"
+           << "      <Points>\n"
+           << column_array(*_columns.front()) << "      </Points>\n"
+           << "      <Verts>\n"
+           << cell_arrays(vertex_ids, vertex_offsets) << "      </Verts>\n"
+           << "      <Lines>\n"
+           << cell_arrays(line_ids, line_offsets) << "      </Lines>\n"
+           << "    </Piece>\n"
+           << "  </PolyData>\n"
+           << "  <AppendedData encoding=\"raw\">\n"
+           << "   _";
+
+    auto out = std::ofstream{_file_name, std::ios::binary | std::ios::trunc};
+    if(!out)
+    {
+        throw std::runtime_error("Could not open " + _file_name
+                                 + " for writing");
+    }
+    out << header.str();
+
+    // Copy the columns in the order of the header
+    auto buffer = std::vector<char>(1 << 20);
+    auto copy_column = [&](const Column& column) {
+        auto in = std::ifstream{column.file_name,
+                                std::ios::binary | std::ios::ate};
+        if(!in)
+        {
+            throw std::runtime_error("Could not read " + column.file_name);
+        }
+        write(out, uint64_t(in.tellg()));
+        in.seekg(0);
+        while(in)
+        {
+            in.read(buffer.data(), std::streamsize(buffer.size()));
+            out.write(buffer.data(), in.gcount());
+        }
+        if(in.bad())
+        {
+            throw std::runtime_error("Could not read " + column.file_name);
+        }
+    };
+    for(auto i = std::size_t{1}; i < _columns.size(); ++i)
+    {
+        copy_column(*_columns[i]);
+    }
+    copy_column(*_columns.front());
+    writeArray(out, vertex_ids);
+    writeArray(out, vertex_offsets);
+    writeArray(out, line_ids);
+    writeArray(out, line_offsets);
+    out << "\n  </AppendedData>\n</VTKFile>\n";
+
+    if(!out.flush())
+    {
+        throw std::runtime_error("Could not write " + _file_name);
+    }
+}
+
+} // namespace tl
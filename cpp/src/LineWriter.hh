@@ -0,0 +1,143 @@
+#ifndef CPP_LINE_WRITER_HH
+#define CPP_LINE_WRITER_HH
+
+#include "TensorLines.hh"
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tl
+{
+
+/**
+ * Line segments and single points connecting the points found on the faces of
+ * one cell, as indices into the list of points of the cell.
+ */
+struct CellConnections
+{
+    std::vector<std::array<std::size_t, 2>> lines;
+    std::vector<std::size_t> vertices;
+};
+
+
+/**
+ * @brief Connect the points found on the faces of a cell to line segments.
+ * @details Two points are connected directly. Otherwise, the pairs of points
+ *      with the most similar eigenvector directions are connected greedily (for
+ *      fewer than 10 points). All points left over are returned as vertices,
+ *      in ascending order.
+ *
+ * @param eivecs Eigenvector directions of the points of the cell
+ * @return The connections
+ */
+CellConnections connectCellPoints(const std::vector<Vec3d>& eivecs);
+
+
+/// File formats of StreamingLineWriter
+enum class LineFileFormat : int
+{
+    /// VTK XML poly data file (.vtp) with raw appended data
+    VtkXml = 0,
+    /// One NumPy array file (.npy) per point attribute, plus the segments and
+    /// single points
+    Npy = 1
+};
+
+
+/**
+ * Keys of the point attributes StreamingLineWriter can write: pos, rank1,
+ * rank2, eigenvalue1, eigenvalue2, eivec, imaginary1, imaginary2, cluster_size,
+ * pos_uncertainty, dir_uncertainty and line_stability.
+ */
+std::vector<std::string> lineAttributeKeys();
+
+
+/**
+ * @brief Name of the array of a point attribute in vtkTensorLines' output.
+ * @throws std::invalid_argument for unknown keys
+ */
+std::string lineAttributeName(const std::string& key);
+
+
+/**
+ * @brief Writes tensor line points and their connections to files without
+ *      building the dataset in memory.
+ * @details Each point attribute is appended to a column file as the points are
+ *      added, keeping only the cell and eigenvector of each point in memory.
+ *      finish() connects the points of each cell and completes the output.
+ *
+ *      As a VTK XML poly data file, the columns are temporary files next to
+ *      the output, which are copied behind the XML header. The file has the
+ *      same points, point data and cells as the output of vtkTensorLines.
+ *
+ *      In the .npy format, the file name is a prefix. Each attribute is written
+ *      to <prefix>.<key>.npy in native byte order, with one row per point. The
+ *      point indices of the line segments are written to <prefix>.segments.npy
+ *      (one row of two per segment), those of points without a partner to
+ *      <prefix>.vertices.npy.
+ */
+class StreamingLineWriter
+{
+public:
+    /**
+     * @brief Create the column files.
+     *
+     * @param file_name Name of the output file, or prefix of the .npy files
+     * @param format Format of the output
+     * @param attributes Keys of the point attributes to write. VTK files
+     *      always contain the points.
+     * @throws std::invalid_argument for unknown attributes
+     * @throws std::runtime_error if a file can not be opened
+     */
+    StreamingLineWriter(const std::string& file_name,
+                        LineFileFormat format = LineFileFormat::VtkXml,
+                        const std::vector<std::string>& attributes =
+                                lineAttributeKeys());
+
+    /// Removes temporary and incomplete column files
+    ~StreamingLineWriter();
+
+    StreamingLineWriter(const StreamingLineWriter&) = delete;
+    StreamingLineWriter& operator=(const StreamingLineWriter&) = delete;
+
+    /**
+     * @brief Append the points found on a face of a cell.
+     * @throws std::runtime_error if a column can not be written
+     */
+    void addPoints(uint64_t cell_id, const PointList& points);
+
+    /**
+     * @brief Connect the points and complete the output files.
+     * @throws std::runtime_error if a file can not be written
+     */
+    void finish();
+
+    uint64_t numPoints() const
+    {
+        return _num_points;
+    }
+
+private:
+    struct Column;
+
+    void writeVtkXml(const std::vector<int64_t>& line_ids,
+                     const std::vector<int64_t>& vertex_ids);
+
+    std::string _file_name;
+    LineFileFormat _format;
+    std::vector<std::unique_ptr<Column>> _columns;
+    // Cell and index of each point
+    std::vector<std::pair<uint64_t, uint64_t>> _point_cells;
+    std::vector<Vec3d> _eivecs;
+    uint64_t _num_points = 0;
+    bool _finished = false;
+};
+
+} // namespace tl
+
+#endif
@@ -0,0 +1,280 @@
+#include "NumaScheduling.hh"
+
+#include <fstream>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace
+{
+using namespace tl;
+
+/**
+ * Parse a Linux CPU or node list like "0-3,8,10-11"
+ */
+std::vector<std::size_t> parseList(const std::string& list)
+{
+    auto result = std::vector<std::size_t>{};
+    auto in = std::istringstream{list};
+    auto item = std::string{};
+    while(std::getline(in, item, ','))
+    {
+        const auto dash = item.find('-');
+        try
+        {
+            const auto first = std::stoul(item.substr(0, dash));
+            const auto last = dash == std::string::npos
+                                      ? first
+                                      : std::stoul(item.substr(dash + 1));
+            for(auto i = first; i <= last; ++i)
+            {
+                result.push_back(i);
+            }
+        }
+        catch(const std::exception&)
+        {
+            return {};
+        }
+    }
+    return result;
+}
+
+
+std::string readLine(const std::string& file_name)
+{
+    auto in = std::ifstream{file_name};
+    auto line = std::string{};
+    std::getline(in, line);
+    return line;
+}
+
+
+/**
+ * Nodes of the machine, the index of the node of each CPU and the CPUs of
+ * each node
+ */
+struct NumaTopology
+{
+    std::size_t num_nodes = 1;
+    std::vector<std::size_t> cpu_nodes;
+    std::vector<std::vector<std::size_t>> node_cpus;
+};
+
+
+NumaTopology readTopology()
+{
+    auto topology = NumaTopology{};
+    const auto dir = std::string{"/sys/devices/system/node/"};
+    const auto nodes = parseList(readLine(dir + "online"));
+    if(nodes.empty())
+    {
+        return topology;
+    }
+
+    topology.num_nodes = nodes.size();
+    for(auto n = std::size_t{0}; n < nodes.size(); ++n)
+    {
+        const auto cpus = parseList(
+                readLine(dir + "node" + std::to_string(nodes[n]) + "/cpulist"));
+        for(auto cpu : cpus)
+        {
+            if(cpu >= topology.cpu_nodes.size())
+            {
+                topology.cpu_nodes.resize(cpu + 1, 0);
+            }
+            topology.cpu_nodes[cpu] = n;
+        }
+        topology.node_cpus.push_back(cpus);
+    }
+    return topology;
+}
+
+
+const NumaTopology& topology()
+{
+    static const auto topology = readTopology();
+    return topology;
+}
+
+
+#ifdef __linux__
+bool setAffinity(const std::vector<std::size_t>& cpus)
+{
+    auto mask = cpu_set_t{};
+    CPU_ZERO(&mask);
+    for(auto cpu : cpus)
+    {
+        CPU_SET(cpu, &mask);
+    }
+    return sched_setaffinity(0, sizeof(mask), &mask) == 0;
+}
+#endif
+
+} // namespace
+
+
+namespace tl
+{
+
+std::size_t numNumaNodes()
+{
+    return topology().num_nodes;
+}
+
+
+std::size_t currentNumaNode()
+{
+#ifdef __linux__
+    const auto cpu = sched_getcpu();
+    const auto& cpu_nodes = topology().cpu_nodes;
+    if(cpu >= 0 && std::size_t(cpu) < cpu_nodes.size())
+    {
+        return cpu_nodes[std::size_t(cpu)];
+    }
+#endif
+    return 0;
+}
+
+
+bool numaPinningAvailable()
+{
+#ifdef __linux__
+    return topology().node_cpus.size() > 1;
+#else
+    return false;
+#endif
+}
+
+
+std::size_t threadNumaNode(std::size_t thread, std::size_t num_threads)
+{
+    const auto& node_cpus = topology().node_cpus;
+    auto num_cpus = std::size_t{0};
+    for(const auto& cpus : node_cpus)
+    {
+        num_cpus += cpus.size();
+    }
+    if(num_cpus == 0 || num_threads == 0)
+    {
+        return 0;
+    }
+
+    const auto pos = thread * num_cpus / num_threads;
+    auto end = std::size_t{0};
+    for(auto node = std::size_t{0}; node < node_cpus.size(); ++node)
+    {
+        end += node_cpus[node].size();
+        if(pos < end)
+        {
+            return node;
+        }
+    }
+    return node_cpus.size() - 1;
+}
+
+
+NumaNodePin::NumaNodePin(std::size_t node)
+{
+#ifdef __linux__
+    const auto& node_cpus = topology().node_cpus;
+    auto previous = cpu_set_t{};
+    if(node >= node_cpus.size()
+       || sched_getaffinity(0, sizeof(previous), &previous) != 0)
+    {
+        return;
+    }
+    auto cpus = std::vector<std::size_t>{};
+    for(auto cpu : node_cpus[node])
+    {
+        if(cpu < CPU_SETSIZE && CPU_ISSET(cpu, &previous))
+        {
+            cpus.push_back(cpu);
+        }
+    }
+    if(cpus.empty() || !setAffinity(cpus))
+    {
+        return;
+    }
+    for(auto cpu = std::size_t{0}; cpu < CPU_SETSIZE; ++cpu)
+    {
+        if(CPU_ISSET(cpu, &previous))
+        {
+            _previous_cpus.push_back(cpu);
+        }
+    }
+    _pinned = true;
+#else
+    static_cast<void>(node);
+#endif
+}
+
+
+NumaNodePin::~NumaNodePin()
+{
+#ifdef __linux__
+    if(_pinned)
+    {
+        setAffinity(_previous_cpus);
+    }
+#endif
+}
+
+
+NumaFaceQueues::NumaFaceQueues(const std::vector<std::size_t>& order,
+                               const std::vector<std::size_t>& node_threads)
+    : _ranges(node_threads.size()),
+      _queues(node_threads.size()),
+      _next(new std::atomic<std::size_t>[node_threads.size()])
+{
+    const auto num_faces = order.size();
+    const auto num_threads = std::max<std::size_t>(
+            std::accumulate(node_threads.begin(), node_threads.end(),
+                            std::size_t{0}),
+            1);
+    auto threads = std::size_t{0};
+    auto ends = std::vector<std::size_t>{};
+    for(auto node = std::size_t{0}; node < node_threads.size(); ++node)
+    {
+        const auto begin = num_faces * threads / num_threads;
+        threads += node_threads[node];
+        _ranges[node] = {begin, num_faces * threads / num_threads};
+        ends.push_back(_ranges[node].second);
+        _next[node] = 0;
+    }
+
+    for(auto face : order)
+    {
+        const auto node = std::upper_bound(ends.begin(), ends.end(), face)
+                          - ends.begin();
+        _queues[std::size_t(node)].push_back(face);
+    }
+}
+
+
+bool NumaFaceQueues::next(std::size_t node, std::size_t& face)
+{
+    const auto num_nodes = _queues.size();
+    for(auto k = std::size_t{0}; k < num_nodes; ++k)
+    {
+        const auto n = (node + k) % num_nodes;
+        const auto& queue = _queues[n];
+        if(_next[n].load(std::memory_order_relaxed) >= queue.size())
+        {
+            continue;
+        }
+        const auto pos = _next[n].fetch_add(1, std::memory_order_relaxed);
+        if(pos < queue.size())
+        {
+            face = queue[pos];
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace tl
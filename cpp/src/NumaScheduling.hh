@@ -0,0 +1,228 @@
+#ifndef CPP_NUMA_SCHEDULING_HH
+#define CPP_NUMA_SCHEDULING_HH
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace tl
+{
+
+/**
+ * @brief Number of NUMA nodes of the machine.
+ * @details Read from /sys/devices/system/node on Linux, 1 elsewhere or if it
+ *      can not be read.
+ */
+std::size_t numNumaNodes();
+
+
+/**
+ * @brief Index of the NUMA node of the CPU the calling thread runs on, in
+ *      [0, numNumaNodes()), or 0 if unknown.
+ * @details Only stays valid while the thread is pinned to the node.
+ */
+std::size_t currentNumaNode();
+
+
+/**
+ * @brief Whether threads can be pinned to NUMA nodes, which needs Linux and a
+ *      known topology of several nodes.
+ */
+bool numaPinningAvailable();
+
+
+/**
+ * @brief NUMA node a thread is pinned to.
+ * @details The threads are assigned to the nodes in contiguous groups sized
+ *      by the number of CPUs of each node, so that consecutive threads share a
+ *      node.
+ *
+ * @param thread Index of the thread
+ * @param num_threads Number of threads
+ */
+std::size_t threadNumaNode(std::size_t thread, std::size_t num_threads);
+
+
+/**
+ * @brief Pins the calling thread to the CPUs of a NUMA node with
+ *      sched_setaffinity() and restores its previous affinity when destroyed.
+ * @details Only the CPUs of the node the thread is allowed to run on are
+ *      used. If there are none, or on other systems than Linux, the thread is
+ *      not pinned.
+ */
+class NumaNodePin
+{
+public:
+    explicit NumaNodePin(std::size_t node);
+    ~NumaNodePin();
+
+    NumaNodePin(const NumaNodePin&) = delete;
+    NumaNodePin& operator=(const NumaNodePin&) = delete;
+
+    bool pinned() const
+    {
+        return _pinned;
+    }
+
+private:
+    bool _pinned = false;
+    // CPUs the thread was allowed to run on before
+    std::vector<std::size_t> _previous_cpus;
+};
+
+
+/**
+ * @brief Queues of faces for the threads of each NUMA node.
+ * @details The face indices are split into contiguous ranges, one per node,
+ *      sized by the number of threads on the node. The threads of a node take
+ *      the faces of its range in the given order and then take faces from the
+ *      queues of the other nodes. next() may be called concurrently.
+ */
+class NumaFaceQueues
+{
+public:
+    /**
+     * @param order Indices of the faces in the order to take them
+     * @param node_threads Number of threads on each node
+     */
+    NumaFaceQueues(const std::vector<std::size_t>& order,
+                   const std::vector<std::size_t>& node_threads);
+
+    /**
+     * Get the range of face indices owned by a node
+     */
+    std::pair<std::size_t, std::size_t> faceRange(std::size_t node) const
+    {
+        return _ranges[node];
+    }
+
+    /**
+     * @brief Take the next face, from the queue of the node first.
+     * @return false if all faces were taken
+     */
+    bool next(std::size_t node, std::size_t& face);
+
+private:
+    std::vector<std::pair<std::size_t, std::size_t>> _ranges;
+    std::vector<std::vector<std::size_t>> _queues;
+    std::unique_ptr<std::atomic<std::size_t>[]> _next;
+};
+
+
+namespace detail
+{
+#ifdef _OPENMP
+template <typename Gather, typename Search>
+void numaLocalForEachFace(const std::vector<std::size_t>& order,
+                          Gather gather,
+                          Search search)
+{
+    using Input = decltype(gather(std::size_t{0}));
+    // Not value-initialized, so that each page is first touched by the thread
+    // gathering into it
+    auto inputs = std::unique_ptr<Input[]>{new Input[order.size()]};
+    auto thread_nodes = std::vector<std::size_t>{};
+    auto queues = std::unique_ptr<NumaFaceQueues>{};
+
+#pragma omp parallel
+    {
+        const auto thread = std::size_t(omp_get_thread_num());
+        const auto num_threads = std::size_t(omp_get_num_threads());
+#pragma omp single
+        thread_nodes.assign(num_threads, 0);
+        // Pinned until the end of the region, so that the thread searches the
+        // faces whose input it placed on its node
+        const auto pin = NumaNodePin{threadNumaNode(thread, num_threads)};
+        thread_nodes[thread] = currentNumaNode();
+#pragma omp barrier
+#pragma omp single
+        {
+            auto node_threads = std::vector<std::size_t>(numNumaNodes(), 0);
+            for(auto node : thread_nodes)
+            {
+                ++node_threads[node];
+            }
+            queues.reset(new NumaFaceQueues{order, node_threads});
+        }
+
+        // Split the gathering of the faces of the node among its threads
+        const auto node = thread_nodes[thread];
+        const auto first = thread_nodes.begin();
+        const auto rank = std::size_t(
+                std::count(first, first + std::ptrdiff_t(thread), node));
+        const auto count =
+                std::size_t(std::count(first, thread_nodes.end(), node));
+        const auto range = queues->faceRange(node);
+        const auto size = range.second - range.first;
+        const auto end = range.first + size * (rank + 1) / count;
+        for(auto i = range.first + size * rank / count; i < end; ++i)
+        {
+            inputs[i] = gather(i);
+        }
+#pragma omp barrier
+
+        auto face = std::size_t{0};
+        while(queues->next(node, face))
+        {
+            search(face, inputs[face]);
+        }
+    }
+}
+#endif
+} // namespace detail
+
+
+/**
+ * @brief Gather the input of each face and search the faces in parallel.
+ * @details By default the faces are searched in the given order with dynamic
+ *      scheduling, each gathering its input right before the search.
+ *
+ *      With numa_local, each thread is pinned to the CPUs of a NUMA node
+ *      (see threadNumaNode() and NumaNodePin) and each node owns a contiguous
+ *      range of faces (see NumaFaceQueues). The threads of a node first gather
+ *      the input of its faces, placing the pages on the node, and then search
+ *      them, taking faces of the other nodes when done. This holds the input
+ *      of all faces in memory at once. If the threads can not be pinned (see
+ *      numaPinningAvailable()), numa_local is ignored. Without OpenMP, the
+ *      faces are searched in order.
+ *
+ * @param order Indices of the faces in search order
+ * @param numa_local Whether to partition the faces by NUMA node
+ * @param gather Function returning the input of a face given its index. The
+ *      type of the input must be default constructible.
+ * @param search Function searching a face given its index and input
+ */
+template <typename Gather, typename Search>
+void forEachFace(const std::vector<std::size_t>& order,
+                 bool numa_local,
+                 Gather gather,
+                 Search search)
+{
+#ifdef _OPENMP
+    if(numa_local && numaPinningAvailable())
+    {
+        detail::numaLocalForEachFace(order, gather, search);
+        return;
+    }
+#else
+    static_cast<void>(numa_local);
+#endif
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for(auto k = std::size_t{0}; k < order.size(); ++k)
+    {
+        const auto i = order[k];
+        search(i, gather(i));
+    }
+}
+
+} // namespace tl
+
+#endif
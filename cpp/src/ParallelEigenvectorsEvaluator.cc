@@ -2,7 +2,6 @@
 
 #include <Eigen/Geometry>
 
-#include <boost/algorithm/cxx11/any_of.hpp>
 #include <boost/range/algorithm/min_element.hpp>
 #include <boost/range/algorithm/max_element.hpp>
 
@@ -21,101 +20,204 @@ parallelEigenvectorsCoeffs(const TensorInterp& s,
                            const TensorInterp& t,
                            const Triangle& r)
 {
-    using Coords = TPBT<double, 1, 2>::Coords;
+    // The tensors are linear in the position space, the direction is linear
+    // in the direction space
+    const auto rv = TPBT<Vec3d, 0, 1>{r.coefficients()};
+    const auto cross = [](const Vec3d& a, const Vec3d& b) -> Vec3d {
+        return a.cross(b);
+    };
 
     // (T * r) x r
-    auto eval_ev =
-            [&](const Coords& coords, const TensorInterp& t, int i) -> double {
-        auto rv = r(coords.tail<3>());
-        auto tv = t(coords.head<3>());
-        return (tv * rv).cross(rv)[i];
+    auto ev = [&](const TensorInterp& t) {
+        const auto tv = TPBT<Mat3d, 1, 0>{t.coefficients()};
+        return product<Vec3d>(product<Vec3d>(tv, rv), rv, cross);
+    };
+    auto component = [](const TPBT<Vec3d, 1, 2>& f, int i) {
+        return mapCoefficients<double>(f,
+                                       [i](const Vec3d& v) { return v[i]; });
     };
 
-    auto eval1 = [&](const Coords& coords) { return eval_ev(coords, s, 0); };
-    auto eval2 = [&](const Coords& coords) { return eval_ev(coords, s, 1); };
-    auto eval3 = [&](const Coords& coords) { return eval_ev(coords, s, 2); };
+    const auto fs = ev(s);
+    const auto ft = ev(t);
+    return {component(fs, 0),
+            component(fs, 1),
+            component(fs, 2),
+            component(ft, 0),
+            component(ft, 1),
+            component(ft, 2)};
+}
+
+
+namespace
+{
+template <typename Real>
+using TargetFuncs =
+        std::array<TensorProductBezierTriangle<Real, Real, 1, 2>, 6>;
+using FuncRanges = std::array<std::pair<double, double>, 6>;
+
+// The subdivision kernels are compiled for several instruction sets with
+// runtime dispatch (see TL_TARGET_CLONES). This requires non-template
+// functions, hence the overloads for each coefficient type.
+
+TL_TARGET_CLONES
+TargetFuncs<double> splitFuncs(const TargetFuncs<double>& funcs,
+                               bool space,
+                               std::size_t part,
+                               FuncRanges& ranges)
+{
+    return space ? split_all<1>(funcs, part, ranges)
+                 : split_all<0>(funcs, part, ranges);
+}
 
-    auto eval4 = [&](const Coords& coords) { return eval_ev(coords, t, 0); };
-    auto eval5 = [&](const Coords& coords) { return eval_ev(coords, t, 1); };
-    auto eval6 = [&](const Coords& coords) { return eval_ev(coords, t, 2); };
 
-    return {TPBT<double, 1, 2>{eval1},
-            TPBT<double, 1, 2>{eval2},
-            TPBT<double, 1, 2>{eval3},
-            TPBT<double, 1, 2>{eval4},
-            TPBT<double, 1, 2>{eval5},
-            TPBT<double, 1, 2>{eval6}};
+TL_TARGET_CLONES
+TargetFuncs<float> splitFuncs(const TargetFuncs<float>& funcs,
+                              bool space,
+                              std::size_t part,
+                              FuncRanges& ranges)
+{
+    return space ? split_all<1>(funcs, part, ranges)
+                 : split_all<0>(funcs, part, ranges);
 }
+} // namespace
 
 
-using PEVE = ParallelEigenvectorsEvaluator;
+template <typename Real>
+using PEVE = BasicParallelEigenvectorsEvaluator<Real>;
 
-PEVE::ParallelEigenvectorsEvaluator(const DoubleTri& tri,
-                                    const TensorInterp& s,
-                                    const TensorInterp& t,
-                                    const Options& opts)
+template <typename Real>
+BasicParallelEigenvectorsEvaluator<Real>::BasicParallelEigenvectorsEvaluator(
+        const DoubleTri& tri,
+        const TensorInterp& s,
+        const TensorInterp& t,
+        const Options& opts)
         : _tri(tri),
-          _target_funcs(parallelEigenvectorsCoeffs(s, t, tri.dir_tri)),
+          _target_funcs(cast_all<Real>(
+                  parallelEigenvectorsCoeffs(s, t, tri.dir_tri))),
+          _ranges(bernstein_ranges(_target_funcs)),
+          _opts(opts)
+{
+}
+
+
+template <typename Real>
+BasicParallelEigenvectorsEvaluator<Real>::BasicParallelEigenvectorsEvaluator(
+        const Triangle& pos_tri,
+        const StartPatch& patch,
+        const TensorInterp& s,
+        const TensorInterp& t,
+        const Options& opts)
+        : _tri{pos_tri, patch.triangle()},
           _opts(opts)
 {
+    auto ev_s = start_patch_ev_coeffs(s, patch);
+    auto ev_t = start_patch_ev_coeffs(t, patch);
+    _target_funcs = cast_all<Real>(
+            std::array<TensorProductBezierTriangle<double, double, 1, 2>, 6>{
+                    ev_s[0], ev_s[1], ev_s[2], ev_t[0], ev_t[1], ev_t[2]});
+    _ranges = bernstein_ranges(_target_funcs);
 }
 
 
-std::array<PEVE, 4> PEVE::split() const
+template <typename Real>
+std::array<PEVE<Real>, 4>
+BasicParallelEigenvectorsEvaluator<Real>::split() const
 {
-    if(_last_split_dir)
-    {
-        return split<0>();
-    }
-    return split<1>();
+    return {split(0), split(1), split(2), split(3)};
+}
+
+
+template <typename Real>
+PEVE<Real>
+BasicParallelEigenvectorsEvaluator<Real>::split(std::size_t part) const
+{
+    // Alternate between splitting in position and direction space
+    auto space = !_last_split_dir;
+    auto ranges = FuncRanges{};
+    auto funcs = splitFuncs(_target_funcs, space, part, ranges);
+    return Self(space ? _tri.split<1>(part) : _tri.split<0>(part),
+                funcs,
+                ranges,
+                space,
+                _split_level + 1,
+                _opts);
 }
 
 
-Result PEVE::eval()
+template <typename Real>
+Result BasicParallelEigenvectorsEvaluator<Real>::eval()
 {
+    // Coefficients computed in reduced precision are only trusted up to the
+    // rounding error accumulated during subdivision, plus the error they
+    // carried when the evaluator was created
+    auto rounding_error = _opts.rounding_error * double(_split_level + 1)
+                          + _opts.coefficient_error;
+
     // Check if any of the error components can not become zero in the
-    // current subdivision triangles
-    auto has_nonzero = boost::algorithm::any_of(
-            _target_funcs,
-            [](const auto& c) { return sameSign(c.coefficients()) != 0; });
+    // current subdivision triangles and compute upper bound for target
+    // functions from the Bernstein ranges computed during the split
+    auto range = range_bound(_ranges, rounding_error);
 
     // Discard triangles if no roots can occur inside
-    if(has_nonzero)
+    if(!range.has_root)
     {
         return Result::Discard;
     }
 
-    // Compute upper bound for target function
-    auto max_error = abs_max_upper_bound(_target_funcs);
+    if(range.abs_max < _opts.tolerance + rounding_error)
+    {
+        return _opts.rounding_error > 0 ? Result::Promote : Result::Accept;
+    }
+
+    if(range.ambiguous)
+    {
+        return Result::Promote;
+    }
 
-    if(max_error < _opts.tolerance)
+    // Discard triangles if two error components can not become zero at the
+    // same position
+    switch(pairwise_exclusion(_target_funcs, rounding_error))
     {
-        return Result::Accept;
+        case Exclusion::Excluded:
+            return Result::Discard;
+        case Exclusion::Ambiguous:
+            return Result::Promote;
+        case Exclusion::Possible:
+            break;
     }
 
     return Result::Split;
 }
 
 
-double PEVE::error() const
+template <typename Real>
+double BasicParallelEigenvectorsEvaluator<Real>::error() const
 {
     return upper_bound_norm(_target_funcs);
 }
 
 
-double PEVE::condition() const
+template <typename Real>
+double BasicParallelEigenvectorsEvaluator<Real>::coefficientBound() const
+{
+    return abs_max_upper_bound(_target_funcs);
+}
+
+
+template <typename Real>
+double BasicParallelEigenvectorsEvaluator<Real>::condition() const
 {
     auto gradients = std::vector<Eigen::Vector4d>{};
     gradients.reserve(_target_funcs.size());
 
     auto min_cos = 0.;
 
-    auto center0 = (TensorProductDerivativeType_t<0, double, double, 1, 2>::
+    auto center0 = (TensorProductDerivativeType_t<0, Real, Real, 1, 2>::
                             Coords::Ones()
-                    / 3.).eval();
-    auto center1 = (TensorProductDerivativeType_t<1, double, double, 1, 2>::
+                    / Real(3.)).eval();
+    auto center1 = (TensorProductDerivativeType_t<1, Real, Real, 1, 2>::
                             Coords::Ones()
-                    / 3.).eval();
+                    / Real(3.)).eval();
 
     for(const auto& poly: _target_funcs)
     {
@@ -138,23 +240,7 @@ double PEVE::condition() const
 }
 
 
-double distance(const PEVE& t1, const PEVE& t2)
-{
-    return distance(t1.tris(), t2.tris());
-}
-
-
-bool operator==(const PEVE& t1, const PEVE& t2)
-{
-    return t1._tri == t2._tri && t1._target_funcs == t2._target_funcs
-           && t1._last_split_dir == t2._last_split_dir
-           && t1._split_level == t2._split_level && t1._opts == t2._opts;
-}
-
-
-bool operator!=(const PEVE& t1, const PEVE& t2)
-{
-    return !(t1 == t2);
-}
+template class BasicParallelEigenvectorsEvaluator<double>;
+template class BasicParallelEigenvectorsEvaluator<float>;
 
 }// namespace tl
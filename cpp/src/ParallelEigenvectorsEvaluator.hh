@@ -2,26 +2,47 @@
 #define CPP_PARALLEL_EIGENVECTORS_EVALUATOR_HH
 
 #include "EvaluatorUtils.hh"
+#include "StartPatches.hh"
 
 #include <array>
 
 namespace tl
 {
-class ParallelEigenvectorsEvaluator
+/**
+ * Evaluator for the parallel eigenvectors operator.
+ *
+ * @tparam Real Type of the coefficients of the target functions
+ */
+template <typename Real>
+class BasicParallelEigenvectorsEvaluator
 {
-    using Self = ParallelEigenvectorsEvaluator;
+    using Self = BasicParallelEigenvectorsEvaluator<Real>;
     template <typename T, std::size_t... Degrees>
-    using TPBT = TensorProductBezierTriangle<T, double, Degrees...>;
+    using TPBT = TensorProductBezierTriangle<T, Real, Degrees...>;
 
 public:
+    /// Type of the coefficients of the target functions
+    using Scalar = Real;
 
     struct Options
     {
         double tolerance = 1e-6;
+        /// Bound for the absolute rounding error of the coefficients that is
+        /// introduced per subdivision level. Must be set for single precision
+        /// evaluators, which return Result::Promote instead of deciding
+        /// within this bound.
+        double rounding_error = 0.;
+        /// Bound for the absolute error the coefficients already carry when
+        /// the evaluator is created, e.g. by conversion from a single
+        /// precision evaluator. It does not grow with further splits, and
+        /// triangles are accepted within this bound of the tolerance.
+        double coefficient_error = 0.;
 
         friend bool operator==(const Options& o1, const Options& o2)
         {
-            return o1.tolerance == o2.tolerance;
+            return o1.tolerance == o2.tolerance
+                   && o1.rounding_error == o2.rounding_error
+                   && o1.coefficient_error == o2.coefficient_error;
         }
 
         friend bool operator!=(const Options& o1, const Options& o2)
@@ -30,23 +51,52 @@ public:
         }
     };
 
-    ParallelEigenvectorsEvaluator() = default;
+    BasicParallelEigenvectorsEvaluator() = default;
 
-    ParallelEigenvectorsEvaluator(const DoubleTri& tri,
-                                  const TensorInterp& s,
-                                  const TensorInterp& t,
-                                  const Options& opts);
+    BasicParallelEigenvectorsEvaluator(const DoubleTri& tri,
+                                       const TensorInterp& s,
+                                       const TensorInterp& t,
+                                       const Options& opts);
 
-    ParallelEigenvectorsEvaluator(
+    /**
+     * Create an evaluator for one of the direction triangles the search
+     * starts with from the precomputed direction space weights of the patch.
+     */
+    BasicParallelEigenvectorsEvaluator(const Triangle& pos_tri,
+                                       const StartPatch& patch,
+                                       const TensorInterp& s,
+                                       const TensorInterp& t,
+                                       const Options& opts);
+
+    BasicParallelEigenvectorsEvaluator(
             const DoubleTri& tri,
-            const std::array<TPBT<double, 1, 2>, 6>& target_funcs,
+            const std::array<TPBT<Real, 1, 2>, 6>& target_funcs,
             bool last_split_dir,
             uint64_t split_level,
             const Options& opts)
-            : _tri(tri),
-              _target_funcs(target_funcs),
-              _last_split_dir(last_split_dir),
-              _split_level(split_level),
+            : BasicParallelEigenvectorsEvaluator(
+                    tri,
+                    target_funcs,
+                    bernstein_ranges(target_funcs),
+                    last_split_dir,
+                    split_level,
+                    opts)
+    {
+    }
+
+    /**
+     * Create an evaluator with a different coefficient type from another one
+     * by converting the coefficients.
+     */
+    template <typename Other>
+    BasicParallelEigenvectorsEvaluator(
+            const BasicParallelEigenvectorsEvaluator<Other>& other,
+            const Options& opts)
+            : _tri(other.tris()),
+              _target_funcs(cast_all<Real>(other.targetFunctions())),
+              _ranges(bernstein_ranges(_target_funcs)),
+              _last_split_dir(other.lastSplitDir()),
+              _split_level(other.splitLevel()),
               _opts(opts)
     {
     }
@@ -65,6 +115,27 @@ public:
      */
     std::array<Self, 4> split() const;
 
+    /**
+     * Equivalent to `split()[part]`
+     */
+    Self split(std::size_t part) const;
+
+    /**
+     * Get the target functions
+     */
+    const std::array<TPBT<Real, 1, 2>, 6>& targetFunctions() const
+    {
+        return _target_funcs;
+    }
+
+    /**
+     * Get the space of the last split (0: position, 1: direction)
+     */
+    bool lastSplitDir() const
+    {
+        return _last_split_dir;
+    }
+
     /**
      * Get the current subdivision level
      */
@@ -80,7 +151,11 @@ public:
      *          direction_epsilon and ev_epsilon; returns Result::Discard if no
      *          solution can be found by subdividing further, and returns
      *          Result::Split if further subdivision is necessary to find a
-     *          solution.
+     *          solution. If the coefficients carry a rounding error (see
+     *          Options::rounding_error), returns Result::Promote if the
+     *          decision can not be made reliably. A coefficient error (see
+     *          Options::coefficient_error) widens the same bounds, but
+     *          triangles within it are accepted.
      */
     Result eval();
 
@@ -89,6 +164,12 @@ public:
      */
     double error() const;
 
+    /**
+     * Get the largest absolute value of all coefficients, which bounds the
+     * target functions on all subdivisions of the evaluator
+     */
+    double coefficientBound() const;
+
     /**
      * Get an estimate of the condition of the problem.
      *
@@ -97,51 +178,67 @@ public:
      */
     double condition() const;
 
-    friend bool operator==(const Self& t1, const Self& t2);
+    friend bool operator==(const Self& t1, const Self& t2)
+    {
+        return t1._tri == t2._tri && t1._target_funcs == t2._target_funcs
+               && t1._last_split_dir == t2._last_split_dir
+               && t1._split_level == t2._split_level && t1._opts == t2._opts;
+    }
 
-    friend bool operator!=(const Self& t1, const Self& t2);
+    friend bool operator!=(const Self& t1, const Self& t2)
+    {
+        return !(t1 == t2);
+    }
 
 
 private:
     DoubleTri _tri = DoubleTri{};
 
-    std::array<TPBT<double, 1, 2>, 6> _target_funcs =
-            std::array<TPBT<double, 1, 2>, 6>{};
+    std::array<TPBT<Real, 1, 2>, 6> _target_funcs =
+            std::array<TPBT<Real, 1, 2>, 6>{};
+
+    // Bernstein ranges of the target functions, computed together with the
+    // coefficients
+    std::array<std::pair<double, double>, 6> _ranges =
+            std::array<std::pair<double, double>, 6>{};
 
     bool _last_split_dir = false;
     uint64_t _split_level = 0;
 
     Options _opts = Options{};
 
-    template <std::size_t D>
-    std::array<Self, 4> split() const
+    BasicParallelEigenvectorsEvaluator(
+            const DoubleTri& tri,
+            const std::array<TPBT<Real, 1, 2>, 6>& target_funcs,
+            const std::array<std::pair<double, double>, 6>& ranges,
+            bool last_split_dir,
+            uint64_t split_level,
+            const Options& opts)
+            : _tri(tri),
+              _target_funcs(target_funcs),
+              _ranges(ranges),
+              _last_split_dir(last_split_dir),
+              _split_level(split_level),
+              _opts(opts)
     {
-        static_assert(D >= 0 && D < 2,
-                      "Split space must be 0 (position) or 1 (direction)");
-
-        auto part = [&](std::size_t i) {
-            return ParallelEigenvectorsEvaluator(
-                    _tri.split<D>(i),
-                    {_target_funcs[0].split<D>(i),
-                     _target_funcs[1].split<D>(i),
-                     _target_funcs[2].split<D>(i),
-                     _target_funcs[3].split<D>(i),
-                     _target_funcs[4].split<D>(i),
-                     _target_funcs[5].split<D>(i)},
-                    D == 1,
-                    _split_level + 1,
-                    _opts);
-        };
-
-        return {part(0), part(1), part(2), part(3)};
     }
 };
 
-double distance(const ParallelEigenvectorsEvaluator& t1,
-                const ParallelEigenvectorsEvaluator& t2);
+template <typename Real>
+double distance(const BasicParallelEigenvectorsEvaluator<Real>& t1,
+                const BasicParallelEigenvectorsEvaluator<Real>& t2)
+{
+    return distance(t1.tris(), t2.tris());
+}
+
+using ParallelEigenvectorsEvaluator =
+        BasicParallelEigenvectorsEvaluator<double>;
 
 static_assert(is_evaluator<ParallelEigenvectorsEvaluator>::value,
               "ParallelEigenvectorsEvaluator is not a valid evaluator!");
+static_assert(is_evaluator<BasicParallelEigenvectorsEvaluator<float>>::value,
+              "BasicParallelEigenvectorsEvaluator<float> is not a valid "
+              "evaluator!");
 }
 
 #endif
@@ -0,0 +1,423 @@
+#ifndef CPP_START_PATCHES_HH
+#define CPP_START_PATCHES_HH
+
+#include "EvaluatorUtils.hh"
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace tl
+{
+
+namespace detail
+{
+using Corner = std::array<double, 3>;
+using Corners = std::array<Corner, 3>;
+using StartPatchWeights = std::array<std::array<double, 18>, 9>;
+
+constexpr Corner midpoint(const Corner& a, const Corner& b)
+{
+    return {(a[0] + b[0]) / 2, (a[1] + b[1]) / 2, (a[2] + b[2]) / 2};
+}
+
+
+constexpr Corner cross(const Corner& a, const Corner& b)
+{
+    return {a[1] * b[2] - a[2] * b[1],
+            a[2] * b[0] - a[0] * b[2],
+            a[0] * b[1] - a[1] * b[0]};
+}
+
+
+constexpr double dot(const Corner& a, const Corner& b)
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+
+/**
+ * Split a triangle into four in the order of
+ * TensorProductBezierTriangleBase::split().
+ */
+constexpr std::array<Corners, 4> splitCorners(const Corners& c)
+{
+    const auto ab = midpoint(c[0], c[1]);
+    const auto bc = midpoint(c[1], c[2]);
+    const auto ac = midpoint(c[0], c[2]);
+    return {Corners{c[0], ab, ac},
+            Corners{ab, c[1], bc},
+            Corners{ac, bc, c[2]},
+            Corners{ab, bc, ac}};
+}
+
+
+/// The four octant triangles covering the upper hemisphere
+constexpr std::array<Corners, 4> octantCorners()
+{
+    return {Corners{Corner{1, 0, 0}, Corner{0, 1, 0}, Corner{0, 0, 1}},
+            Corners{Corner{0, 1, 0}, Corner{-1, 0, 0}, Corner{0, 0, 1}},
+            Corners{Corner{-1, 0, 0}, Corner{0, -1, 0}, Corner{0, 0, 1}},
+            Corners{Corner{0, -1, 0}, Corner{1, 0, 0}, Corner{0, 0, 1}}};
+}
+
+
+/**
+ * @brief Weights of the tensor entries in the direction space coefficients of
+ *      (T * r) x r on a direction triangle.
+ * @details With r linear on the triangle, (T * r) x r is quadratic in the
+ *      direction space. Its k-th coefficient in component c is the sum of
+ *      `T(a, b) * weights[a + 3 * b][3 * k + c]` over all entries of T, i.e.
+ *      the entries are indexed in the column-major order of Mat3d.
+ */
+constexpr StartPatchWeights startPatchWeights(const Corners& r)
+{
+    using Table = BernsteinProductTable<std::index_sequence<1>,
+                                        std::index_sequence<1>>;
+    constexpr auto table = Table::make();
+    constexpr auto unit = std::array<Corner, 3>{
+            Corner{1, 0, 0}, Corner{0, 1, 0}, Corner{0, 0, 1}};
+
+    auto weights = StartPatchWeights{};
+    for(auto i = std::size_t{0}; i < Table::NA; ++i)
+    {
+        for(auto j = std::size_t{0}; j < Table::NB; ++j)
+        {
+            const auto& entry = table[i * Table::NB + j];
+            // (T * r_i) x r_j = sum_ab T(a, b) r_i[b] (e_a x r_j)
+            for(auto a = std::size_t{0}; a < 3; ++a)
+            {
+                const auto axis = cross(unit[a], r[j]);
+                for(auto b = std::size_t{0}; b < 3; ++b)
+                {
+                    for(auto c = std::size_t{0}; c < 3; ++c)
+                    {
+                        weights[a + 3 * b][3 * entry.index + c] +=
+                                entry.weight * r[i][b] * axis[c];
+                    }
+                }
+            }
+        }
+    }
+    return weights;
+}
+} // namespace detail
+
+
+/**
+ * Direction triangle the searches start with, together with the direction
+ * space weights of (T * r) x r on it (see detail::startPatchWeights()).
+ */
+struct StartPatch
+{
+    detail::Corners corners = {};
+    detail::StartPatchWeights weights = {};
+
+    constexpr StartPatch() = default;
+
+    constexpr explicit StartPatch(const detail::Corners& corners)
+            : corners(corners), weights(detail::startPatchWeights(corners))
+    {
+    }
+
+    /**
+     * Get the direction triangle of the patch
+     */
+    Triangle triangle() const
+    {
+        const auto& c = corners;
+        return Triangle{{Vec3d{c[0][0], c[0][1], c[0][2]},
+                         Vec3d{c[1][0], c[1][1], c[1][2]},
+                         Vec3d{c[2][0], c[2][1], c[2][2]}}};
+    }
+};
+
+
+namespace detail
+{
+constexpr std::array<StartPatch, 16> makeOctantStartPatches()
+{
+    auto result = std::array<StartPatch, 16>{};
+    auto n = std::size_t{0};
+    for(const auto& octant : octantCorners())
+    {
+        for(const auto& corners : splitCorners(octant))
+        {
+            result[n++] = StartPatch{corners};
+        }
+    }
+    return result;
+}
+
+
+inline Corner normalized(const Corner& a)
+{
+    const auto norm = std::sqrt(dot(a, a));
+    return {a[0] / norm, a[1] / norm, a[2] / norm};
+}
+
+
+/**
+ * @brief Ten faces of an icosahedron, one of each pair of antipodal faces.
+ * @details Picks the faces whose centers lie in the upper hemisphere, breaking
+ *      ties on the equator by the y and then the x coordinate. The corners
+ *      lie on the unit sphere and are ordered counter-clockwise as seen from
+ *      outside.
+ */
+inline std::vector<Corners> icosahedronCorners()
+{
+    const auto phi = (1. + std::sqrt(5.)) / 2.;
+    auto vertices = std::vector<Corner>{};
+    for(auto a : {-1., 1.})
+    {
+        for(auto b : {-phi, phi})
+        {
+            vertices.push_back(Corner{0, a, b});
+            vertices.push_back(Corner{a, b, 0});
+            vertices.push_back(Corner{b, 0, a});
+        }
+    }
+
+    // Neighboring vertices have a distance of 2
+    auto is_edge = [&](std::size_t i, std::size_t j) {
+        const auto& u = vertices[i];
+        const auto& v = vertices[j];
+        const auto d = Corner{u[0] - v[0], u[1] - v[1], u[2] - v[2]};
+        return std::abs(dot(d, d) - 4.) < 1e-9;
+    };
+    auto is_upper = [](const Corner& center) {
+        for(auto i : {2, 1, 0})
+        {
+            if(std::abs(center[i]) > 1e-9)
+            {
+                return center[i] > 0;
+            }
+        }
+        return false;
+    };
+
+    auto result = std::vector<Corners>{};
+    for(auto i = std::size_t{0}; i < vertices.size(); ++i)
+    {
+        for(auto j = i + 1; j < vertices.size(); ++j)
+        {
+            for(auto k = j + 1; k < vertices.size(); ++k)
+            {
+                if(!is_edge(i, j) || !is_edge(j, k) || !is_edge(i, k))
+                {
+                    continue;
+                }
+                auto face = Corners{normalized(vertices[i]),
+                                    normalized(vertices[j]),
+                                    normalized(vertices[k])};
+                const auto center = Corner{
+                        face[0][0] + face[1][0] + face[2][0],
+                        face[0][1] + face[1][1] + face[2][1],
+                        face[0][2] + face[1][2] + face[2][2]};
+                if(!is_upper(center))
+                {
+                    continue;
+                }
+                const auto e1 = Corner{face[1][0] - face[0][0],
+                                       face[1][1] - face[0][1],
+                                       face[1][2] - face[0][2]};
+                const auto e2 = Corner{face[2][0] - face[0][0],
+                                       face[2][1] - face[0][1],
+                                       face[2][2] - face[0][2]};
+                if(dot(cross(e1, e2), center) < 0)
+                {
+                    std::swap(face[1], face[2]);
+                }
+                result.push_back(face);
+            }
+        }
+    }
+    return result;
+}
+} // namespace detail
+
+
+/// Start patches of the default start mesh (the octants split once),
+/// computed at compile time
+inline constexpr auto octant_start_patches = detail::makeOctantStartPatches();
+
+
+/**
+ * @brief Create the direction triangles the searches start with.
+ * @details The number of patches is 4 * 4^level for the octants and the
+ *      octahedron and 10 * 4^level for the icosahedron.
+ *
+ * @param mesh Base mesh covering the hemisphere
+ * @param level Number of times each triangle of the base mesh is split
+ * @return The start patches
+ */
+inline std::vector<StartPatch> make_start_patches(StartMesh mesh,
+                                                  std::size_t level)
+{
+    auto corners = std::vector<detail::Corners>{};
+    if(mesh == StartMesh::Icosahedron)
+    {
+        corners = detail::icosahedronCorners();
+    }
+    else
+    {
+        const auto octants = detail::octantCorners();
+        corners.assign(octants.begin(), octants.end());
+    }
+
+    for(auto i = std::size_t{0}; i < level; ++i)
+    {
+        auto split = std::vector<detail::Corners>{};
+        split.reserve(4 * corners.size());
+        for(const auto& c : corners)
+        {
+            for(auto part : detail::splitCorners(c))
+            {
+                // Geodesic refinement moves the new corners onto the sphere,
+                // the triangles still cover the same directions
+                if(mesh != StartMesh::Octants)
+                {
+                    for(auto& corner : part)
+                    {
+                        corner = detail::normalized(corner);
+                    }
+                }
+                split.push_back(part);
+            }
+        }
+        corners = std::move(split);
+    }
+
+    auto result = std::vector<StartPatch>{};
+    result.reserve(corners.size());
+    for(const auto& c : corners)
+    {
+        result.emplace_back(c);
+    }
+    return result;
+}
+
+
+/**
+ * @brief Compute the coefficients of the components of (T * r) x r with r on
+ *      a start patch.
+ * @details Contracts the tensors at the corners of the position triangle
+ *      against the precomputed direction space weights, which is equivalent
+ *      to, but cheaper than, multiplying the polynomials.
+ *
+ * @param t Tensor field (linear on the position triangle)
+ * @param patch The start patch
+ * @return Polynomials of degree 1 in position and 2 in direction space
+ */
+inline std::array<TensorProductBezierTriangle<double, double, 1, 2>, 3>
+start_patch_ev_coeffs(const TensorInterp& t, const StartPatch& patch)
+{
+    const auto& weights = patch.weights;
+
+    auto result = std::array<TensorProductBezierTriangle<double, double, 1, 2>,
+                             3>{};
+    for(auto p = std::size_t{0}; p < 3; ++p)
+    {
+        // Coefficients ordered by direction space index, then component
+        auto values = std::array<double, 18>{};
+        const auto* entries = t[p].data();
+        for(auto entry = std::size_t{0}; entry < 9; ++entry)
+        {
+            for(auto i = std::size_t{0}; i < values.size(); ++i)
+            {
+                values[i] += entries[entry] * weights[entry][i];
+            }
+        }
+        for(auto k = std::size_t{0}; k < 6; ++k)
+        {
+            for(auto c = std::size_t{0}; c < 3; ++c)
+            {
+                result[c][6 * p + k] = values[3 * k + c];
+            }
+        }
+    }
+    return result;
+}
+
+
+/**
+ * @brief Check if a plane through the origin separates a vector valued
+ *      polynomial from zero.
+ * @details The polynomial is positive along a normal u on its whole domain if
+ *      the dot products of u with all coefficients are. The coefficients are
+ *      split into consecutive groups of equal size (e.g. by the vertices of
+ *      the position triangle). The normals tried are the sums of the
+ *      coefficients of each group, which approximate the values at the center
+ *      of the domain, and the sum of their normalized directions.
+ *
+ * @param funcs The components of the polynomial
+ * @param groups Number of groups of coefficients
+ * @return true if the polynomial has no root on its domain
+ */
+template <typename Poly>
+bool separated_from_zero(const std::array<Poly, 3>& funcs, std::size_t groups)
+{
+    const auto n = funcs[0].coefficients().size();
+    auto coefficient = [&](std::size_t k) {
+        return Vec3d{funcs[0][k], funcs[1][k], funcs[2][k]};
+    };
+    auto separates = [&](const Vec3d& normal) {
+        for(auto k = std::size_t{0}; k < n; ++k)
+        {
+            if(!(normal.dot(coefficient(k)) > 0))
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    const auto group_size = n / groups;
+    auto sum = Vec3d{Vec3d::Zero()};
+    for(auto g = std::size_t{0}; g < groups; ++g)
+    {
+        auto normal = Vec3d{Vec3d::Zero()};
+        for(auto k = g * group_size; k < (g + 1) * group_size; ++k)
+        {
+            normal += coefficient(k);
+        }
+        if(separates(normal))
+        {
+            return true;
+        }
+        const auto norm = normal.norm();
+        if(norm > 0)
+        {
+            sum += normal / norm;
+        }
+    }
+    return groups > 1 && separates(sum);
+}
+
+
+/**
+ * @brief Check if a start patch may contain a real eigenvector of a tensor
+ *      field that is linear on the position triangle.
+ * @details r is an eigenvector of t(x) = sum_v x_v T_v if and only if
+ *      (t(x) r) x r = 0, i.e. zero lies in the convex hull of the residuals
+ *      (T_v r) x r of the vertex tensors, which vanish on the real
+ *      eigenvectors of T_v. The patch is excluded if a plane aligned with the
+ *      residuals separates them from zero (see separated_from_zero()). The
+ *      search itself only tests the planes normal to the coordinate axes.
+ *
+ * @param t Tensor field (linear on the position triangle)
+ * @param patch The start patch
+ * @return false if no direction of the patch is an eigenvector of the tensor
+ *      field anywhere on the position triangle
+ */
+inline bool may_contain_eigenvector(const TensorInterp& t,
+                                    const StartPatch& patch)
+{
+    return !separated_from_zero(start_patch_ev_coeffs(t, patch), 3);
+}
+
+} // namespace tl
+
+#endif
@@ -2,7 +2,6 @@
 
 #include <Eigen/Geometry>
 
-#include <boost/algorithm/cxx11/any_of.hpp>
 #include <boost/range/algorithm/min_element.hpp>
 #include <boost/range/algorithm/max_element.hpp>
 
@@ -18,137 +17,250 @@ namespace tl
 template <typename T, std::size_t... Degrees>
 using TPBT = TensorProductBezierTriangle<T, double, Degrees...>;
 
+std::array<TPBT<double, 0, 3>, 3>
+tensorCoreLinesDerivCoeffs(const std::array<TensorInterp, 3>& dt,
+                           const Triangle& r)
+{
+    // The direction is linear in the direction space
+    const auto rv = TPBT<Vec3d, 0, 1>{r.coefficients()};
+    const auto cross = [](const Vec3d& a, const Vec3d& b) -> Vec3d {
+        return a.cross(b);
+    };
+
+    // ((\nabla T * r) * r) x r, the derivatives are constant in the position
+    // space and taken at the center of the face
+    const auto center = TensorInterp::Coords::Constant(1. / 3.);
+    const auto txv = dt[0](center);
+    const auto tyv = dt[1](center);
+    const auto tzv = dt[2](center);
+    const auto dtr = mapCoefficients<Mat3d>(rv, [&](const Vec3d& v) {
+        return Mat3d{txv * v[0] + tyv * v[1] + tzv * v[2]};
+    });
+    const auto deriv_ev = product<Vec3d>(product<Vec3d>(dtr, rv), rv, cross);
+
+    auto component = [&](int i) {
+        return mapCoefficients<double>(deriv_ev,
+                                       [i](const Vec3d& v) { return v[i]; });
+    };
+    return {component(0), component(1), component(2)};
+}
+
+
 std::pair<std::array<TPBT<double, 1, 2>, 3>, std::array<TPBT<double, 0, 3>, 3>>
 tensorCoreLinesCoeffs(const TensorInterp& t,
                       const std::array<TensorInterp, 3>& dt,
                       const Triangle& r)
 {
-    using Coords1 = TPBT<double, 1, 2>::Coords;
-    using Coords2 = TPBT<double, 0, 3>::Coords;
+    // The tensor is linear in the position space, the direction is linear in
+    // the direction space
+    const auto rv = TPBT<Vec3d, 0, 1>{r.coefficients()};
+    const auto cross = [](const Vec3d& a, const Vec3d& b) -> Vec3d {
+        return a.cross(b);
+    };
 
     // (T * r) x r
-    auto eval_ev =
-            [&](const Coords1& coords, const TensorInterp& t, int i) -> double {
-        auto rv = r(coords.tail<3>());
-        auto tv = t(coords.head<3>());
-        return (tv * rv).cross(rv)[i];
+    const auto tv = TPBT<Mat3d, 1, 0>{t.coefficients()};
+    const auto ev = product<Vec3d>(product<Vec3d>(tv, rv), rv, cross);
+
+    auto component = [&](int i) {
+        return mapCoefficients<double>(ev,
+                                       [i](const Vec3d& v) { return v[i]; });
     };
+    return {{component(0), component(1), component(2)},
+            tensorCoreLinesDerivCoeffs(dt, r)};
+}
 
-    // ((\nabla T * r) * r) x r
-    auto eval_deriv_ev = [&](const Coords2& coords,
-                             const std::array<TensorInterp, 3>& dt,
-                             int i) -> double {
-        auto rv = r(coords.tail<3>());
-        auto txv = dt[0](coords.head<3>());
-        auto tyv = dt[1](coords.head<3>());
-        auto tzv = dt[2](coords.head<3>());
 
-        return ((txv * rv[0] + tyv * rv[1] + tzv * rv[2]) * rv).cross(rv)[i];
-    };
+namespace
+{
+template <typename Real>
+using TargetFuncsT =
+        std::array<TensorProductBezierTriangle<Real, Real, 1, 2>, 3>;
+template <typename Real>
+using TargetFuncsDT =
+        std::array<TensorProductBezierTriangle<Real, Real, 0, 3>, 3>;
+using FuncRanges = std::array<std::pair<double, double>, 3>;
+
+// The subdivision kernels are compiled for several instruction sets with
+// runtime dispatch (see TL_TARGET_CLONES). This requires non-template
+// functions, hence the overloads for each coefficient type.
+
+TL_TARGET_CLONES
+TargetFuncsT<double> splitFuncs(const TargetFuncsT<double>& funcs,
+                                bool space,
+                                std::size_t part,
+                                FuncRanges& ranges)
+{
+    return space ? split_all<1>(funcs, part, ranges)
+                 : split_all<0>(funcs, part, ranges);
+}
 
-    auto eval1 = [&](const Coords1& coords) { return eval_ev(coords, t, 0); };
-    auto eval2 = [&](const Coords1& coords) { return eval_ev(coords, t, 1); };
-    auto eval3 = [&](const Coords1& coords) { return eval_ev(coords, t, 2); };
 
-    auto eval4 = [&](const Coords2& coords) {
-        return eval_deriv_ev(coords, dt, 0);
-    };
-    auto eval5 = [&](const Coords2& coords) {
-        return eval_deriv_ev(coords, dt, 1);
-    };
-    auto eval6 = [&](const Coords2& coords) {
-        return eval_deriv_ev(coords, dt, 2);
-    };
+TL_TARGET_CLONES
+TargetFuncsT<float> splitFuncs(const TargetFuncsT<float>& funcs,
+                               bool space,
+                               std::size_t part,
+                               FuncRanges& ranges)
+{
+    return space ? split_all<1>(funcs, part, ranges)
+                 : split_all<0>(funcs, part, ranges);
+}
+
 
-    return {{TPBT<double, 1, 2>{eval1},
-             TPBT<double, 1, 2>{eval2},
-             TPBT<double, 1, 2>{eval3}},
-            {TPBT<double, 0, 3>{eval4},
-             TPBT<double, 0, 3>{eval5},
-             TPBT<double, 0, 3>{eval6}}};
+TL_TARGET_CLONES
+TargetFuncsDT<double> splitFuncs(const TargetFuncsDT<double>& funcs,
+                                 bool space,
+                                 std::size_t part,
+                                 FuncRanges& ranges)
+{
+    return space ? split_all<1>(funcs, part, ranges)
+                 : split_all<0>(funcs, part, ranges);
+}
+
+
+TL_TARGET_CLONES
+TargetFuncsDT<float> splitFuncs(const TargetFuncsDT<float>& funcs,
+                                bool space,
+                                std::size_t part,
+                                FuncRanges& ranges)
+{
+    return space ? split_all<1>(funcs, part, ranges)
+                 : split_all<0>(funcs, part, ranges);
 }
+} // namespace
 
 
-using TSHE = TensorCoreLinesEvaluator;
+template <typename Real>
+using TSHE = BasicTensorCoreLinesEvaluator<Real>;
 
-TSHE::TensorCoreLinesEvaluator(const DoubleTri& tri,
-                               const TensorInterp& t,
-                               const std::array<TensorInterp, 3>& dt,
-                               const Options& opts)
+template <typename Real>
+BasicTensorCoreLinesEvaluator<Real>::BasicTensorCoreLinesEvaluator(
+        const DoubleTri& tri,
+        const TensorInterp& t,
+        const std::array<TensorInterp, 3>& dt,
+        const Options& opts)
         : _tri(tri),
           _opts(opts)
 {
-    std::tie(_target_funcs_t, _target_funcs_dt) =
-            tensorCoreLinesCoeffs(t, dt, tri.dir_tri);
+    auto coeffs = tensorCoreLinesCoeffs(t, dt, tri.dir_tri);
+    _target_funcs_t = cast_all<Real>(coeffs.first);
+    _target_funcs_dt = cast_all<Real>(coeffs.second);
+    _ranges_t = bernstein_ranges(_target_funcs_t);
+    _ranges_dt = bernstein_ranges(_target_funcs_dt);
 }
 
 
-std::array<TSHE, 4> TSHE::split() const
+template <typename Real>
+BasicTensorCoreLinesEvaluator<Real>::BasicTensorCoreLinesEvaluator(
+        const Triangle& pos_tri,
+        const StartPatch& patch,
+        const TensorInterp& t,
+        const std::array<TensorInterp, 3>& dt,
+        const Options& opts)
+        : _tri{pos_tri, patch.triangle()},
+          _opts(opts)
 {
-    if(_last_split_dir)
-    {
-        return split<0>();
-    }
-    return split<1>();
+    _target_funcs_t = cast_all<Real>(start_patch_ev_coeffs(t, patch));
+    _target_funcs_dt =
+            cast_all<Real>(tensorCoreLinesDerivCoeffs(dt, _tri.dir_tri));
+    _ranges_t = bernstein_ranges(_target_funcs_t);
+    _ranges_dt = bernstein_ranges(_target_funcs_dt);
 }
 
 
-Result TSHE::eval()
+template <typename Real>
+std::array<TSHE<Real>, 4> BasicTensorCoreLinesEvaluator<Real>::split() const
 {
+    return {split(0), split(1), split(2), split(3)};
+}
+
+
+template <typename Real>
+TSHE<Real> BasicTensorCoreLinesEvaluator<Real>::split(std::size_t part) const
+{
+    // Alternate between splitting in position and direction space
+    auto space = !_last_split_dir;
+    auto ranges_t = FuncRanges{};
+    auto ranges_dt = FuncRanges{};
+    auto funcs_t = splitFuncs(_target_funcs_t, space, part, ranges_t);
+    auto funcs_dt = splitFuncs(_target_funcs_dt, space, part, ranges_dt);
+    return Self(space ? _tri.split<1>(part) : _tri.split<0>(part),
+                funcs_t,
+                funcs_dt,
+                ranges_t,
+                ranges_dt,
+                space,
+                _split_level + 1,
+                _opts);
+}
+
+
+template <typename Real>
+Result BasicTensorCoreLinesEvaluator<Real>::eval()
+{
+    // Coefficients computed in reduced precision are only trusted up to the
+    // rounding error accumulated during subdivision, plus the error they
+    // carried when the evaluator was created
+    auto rounding_error = _opts.rounding_error * double(_split_level + 1)
+                          + _opts.coefficient_error;
+
     // Check if any of the error components can not become zero in the
-    // current subdivision triangles
-    auto has_nonzero =
-            boost::algorithm::any_of(_target_funcs_t, [](const auto& c) {
-                    return sameSign(c.coefficients()) != 0;
-            })
-            || boost::algorithm::any_of(_target_funcs_dt, [](const auto& c) {
-                   return sameSign(c.coefficients()) != 0;
-               });
+    // current subdivision triangles and compute upper bound for target
+    // functions from the Bernstein ranges computed during the split
+    auto range_t = range_bound(_ranges_t, rounding_error);
+    auto range_dt = range_bound(_ranges_dt, rounding_error);
 
     // Discard triangles if no roots can occur inside
-    if(has_nonzero)
+    if(!range_t.has_root || !range_dt.has_root)
     {
         return Result::Discard;
     }
 
-    // Compute upper bound for target functions
-    auto max_error = std::max(abs_max_upper_bound(_target_funcs_t),
-                              abs_max_upper_bound(_target_funcs_dt));
+    if(std::max(range_t.abs_max, range_dt.abs_max)
+       < _opts.tolerance + rounding_error)
+    {
+        return _opts.rounding_error > 0 ? Result::Promote : Result::Accept;
+    }
 
-    if(max_error < _opts.tolerance)
+    if(range_t.ambiguous || range_dt.ambiguous)
     {
-        return Result::Accept;
+        return Result::Promote;
+    }
+
+    // Discard triangles if two error components can not become zero at the
+    // same position. Only components of the same degree are compared.
+    auto excl_t = pairwise_exclusion(_target_funcs_t, rounding_error);
+    auto excl_dt = pairwise_exclusion(_target_funcs_dt, rounding_error);
+    if(excl_t == Exclusion::Excluded || excl_dt == Exclusion::Excluded)
+    {
+        return Result::Discard;
+    }
+    if(excl_t == Exclusion::Ambiguous || excl_dt == Exclusion::Ambiguous)
+    {
+        return Result::Promote;
     }
 
     return Result::Split;
 }
 
 
-double TSHE::error() const
+template <typename Real>
+double BasicTensorCoreLinesEvaluator<Real>::error() const
 {
     return std::max(upper_bound_norm(_target_funcs_t),
                     upper_bound_norm(_target_funcs_dt));
 }
 
 
-double distance(const TSHE& t1, const TSHE& t2)
+template <typename Real>
+double BasicTensorCoreLinesEvaluator<Real>::coefficientBound() const
 {
-    return distance(t1.tris(), t2.tris());
+    return std::max(abs_max_upper_bound(_target_funcs_t),
+                    abs_max_upper_bound(_target_funcs_dt));
 }
 
 
-bool operator==(const TSHE& t1, const TSHE& t2)
-{
-    return t1._tri == t2._tri && t1._target_funcs_t == t2._target_funcs_t
-           && t1._target_funcs_dt == t2._target_funcs_dt
-           && t1._last_split_dir == t2._last_split_dir
-           && t1._split_level == t2._split_level && t1._opts == t2._opts;
-}
-
-
-bool operator!=(const TSHE& t1, const TSHE& t2)
-{
-    return !(t1 == t2);
-}
+template class BasicTensorCoreLinesEvaluator<double>;
+template class BasicTensorCoreLinesEvaluator<float>;
 
 }
@@ -2,26 +2,47 @@
 #define CPP_TENSOR_CORE_LINES_EVALUATOR_HH
 
 #include "EvaluatorUtils.hh"
+#include "StartPatches.hh"
 
 #include <array>
 
 namespace tl
 {
-class TensorCoreLinesEvaluator
+/**
+ * Evaluator for tensor core lines.
+ *
+ * @tparam Real Type of the coefficients of the target functions
+ */
+template <typename Real>
+class BasicTensorCoreLinesEvaluator
 {
-    using Self = TensorCoreLinesEvaluator;
+    using Self = BasicTensorCoreLinesEvaluator<Real>;
     template <typename T, std::size_t... Degrees>
-    using TPBT = TensorProductBezierTriangle<T, double, Degrees...>;
+    using TPBT = TensorProductBezierTriangle<T, Real, Degrees...>;
 
 public:
+    /// Type of the coefficients of the target functions
+    using Scalar = Real;
 
     struct Options
     {
         double tolerance = 1e-6;
+        /// Bound for the absolute rounding error of the coefficients that is
+        /// introduced per subdivision level. Must be set for single precision
+        /// evaluators, which return Result::Promote instead of deciding
+        /// within this bound.
+        double rounding_error = 0.;
+        /// Bound for the absolute error the coefficients already carry when
+        /// the evaluator is created, e.g. by conversion from a single
+        /// precision evaluator. It does not grow with further splits, and
+        /// triangles are accepted within this bound of the tolerance.
+        double coefficient_error = 0.;
 
         friend bool operator==(const Options& o1, const Options& o2)
         {
-            return o1.tolerance == o2.tolerance;
+            return o1.tolerance == o2.tolerance
+                   && o1.rounding_error == o2.rounding_error
+                   && o1.coefficient_error == o2.coefficient_error;
         }
 
         friend bool operator!=(const Options& o1, const Options& o2)
@@ -30,25 +51,57 @@ public:
         }
     };
 
-    TensorCoreLinesEvaluator() = default;
+    BasicTensorCoreLinesEvaluator() = default;
 
-    TensorCoreLinesEvaluator(const DoubleTri& tri,
-                             const TensorInterp& t,
-                             const std::array<TensorInterp, 3>& dt,
-                             const Options& opts);
+    BasicTensorCoreLinesEvaluator(const DoubleTri& tri,
+                                  const TensorInterp& t,
+                                  const std::array<TensorInterp, 3>& dt,
+                                  const Options& opts);
 
-    TensorCoreLinesEvaluator(
+    /**
+     * Create an evaluator for one of the direction triangles the search
+     * starts with from the precomputed direction space weights of the patch.
+     */
+    BasicTensorCoreLinesEvaluator(const Triangle& pos_tri,
+                                  const StartPatch& patch,
+                                  const TensorInterp& t,
+                                  const std::array<TensorInterp, 3>& dt,
+                                  const Options& opts);
+
+    BasicTensorCoreLinesEvaluator(
             const DoubleTri& tri,
-            const std::array<TPBT<double, 1, 2>, 3>& target_funcs_t,
-            const std::array<TPBT<double, 0, 3>, 3>& target_funcs_dt,
+            const std::array<TPBT<Real, 1, 2>, 3>& target_funcs_t,
+            const std::array<TPBT<Real, 0, 3>, 3>& target_funcs_dt,
             bool last_split_dir,
             uint64_t split_level,
             const Options& opts)
-            : _tri(tri),
-              _target_funcs_t(target_funcs_t),
-              _target_funcs_dt(target_funcs_dt),
-              _last_split_dir(last_split_dir),
-              _split_level(split_level),
+            : BasicTensorCoreLinesEvaluator(
+                    tri,
+                    target_funcs_t,
+                    target_funcs_dt,
+                    bernstein_ranges(target_funcs_t),
+                    bernstein_ranges(target_funcs_dt),
+                    last_split_dir,
+                    split_level,
+                    opts)
+    {
+    }
+
+    /**
+     * Create an evaluator with a different coefficient type from another one
+     * by converting the coefficients.
+     */
+    template <typename Other>
+    BasicTensorCoreLinesEvaluator(
+            const BasicTensorCoreLinesEvaluator<Other>& other,
+            const Options& opts)
+            : _tri(other.tris()),
+              _target_funcs_t(cast_all<Real>(other.targetFunctionsT())),
+              _target_funcs_dt(cast_all<Real>(other.targetFunctionsDT())),
+              _ranges_t(bernstein_ranges(_target_funcs_t)),
+              _ranges_dt(bernstein_ranges(_target_funcs_dt)),
+              _last_split_dir(other.lastSplitDir()),
+              _split_level(other.splitLevel()),
               _opts(opts)
     {
     }
@@ -67,6 +120,35 @@ public:
      */
     std::array<Self, 4> split() const;
 
+    /**
+     * Equivalent to `split()[part]`
+     */
+    Self split(std::size_t part) const;
+
+    /**
+     * Get the target functions depending on the tensor field
+     */
+    const std::array<TPBT<Real, 1, 2>, 3>& targetFunctionsT() const
+    {
+        return _target_funcs_t;
+    }
+
+    /**
+     * Get the target functions depending on the tensor derivatives
+     */
+    const std::array<TPBT<Real, 0, 3>, 3>& targetFunctionsDT() const
+    {
+        return _target_funcs_dt;
+    }
+
+    /**
+     * Get the space of the last split (0: position, 1: direction)
+     */
+    bool lastSplitDir() const
+    {
+        return _last_split_dir;
+    }
+
     /**
      * Get the current subdivision level
      */
@@ -81,7 +163,11 @@ public:
      *          solution is within tolerances of tolerance; returns
      *          Result::Discard if no solution can be found by subdividing
      *          further, and returns Result::Split if further subdivision is
-     *          necessary to find a solution.
+     *          necessary to find a solution. If the coefficients carry a
+     *          rounding error (see Options::rounding_error), returns
+     *          Result::Promote if the decision can not be made reliably. A
+     *          coefficient error (see Options::coefficient_error) widens the
+     *          same bounds, but triangles within it are accepted.
      */
     Result eval();
 
@@ -90,6 +176,12 @@ public:
      */
     double error() const;
 
+    /**
+     * Get the largest absolute value of all coefficients, which bounds the
+     * target functions on all subdivisions of the evaluator
+     */
+    double coefficientBound() const;
+
     /**
      * Get an estimate of the condition of the problem.
      *
@@ -98,52 +190,88 @@ public:
      */
     double condition() const;
 
-    friend bool operator==(const Self& t1, const Self& t2);
+    friend bool operator==(const Self& t1, const Self& t2)
+    {
+        return t1._tri == t2._tri && t1._target_funcs_t == t2._target_funcs_t
+               && t1._target_funcs_dt == t2._target_funcs_dt
+               && t1._last_split_dir == t2._last_split_dir
+               && t1._split_level == t2._split_level && t1._opts == t2._opts;
+    }
 
-    friend bool operator!=(const Self& t1, const Self& t2);
+    friend bool operator!=(const Self& t1, const Self& t2)
+    {
+        return !(t1 == t2);
+    }
 
 private:
     DoubleTri _tri = DoubleTri{};
 
-    std::array<TPBT<double, 1, 2>, 3> _target_funcs_t =
-            std::array<TPBT<double, 1, 2>, 3>{};
+    std::array<TPBT<Real, 1, 2>, 3> _target_funcs_t =
+            std::array<TPBT<Real, 1, 2>, 3>{};
 
-    std::array<TPBT<double, 0, 3>, 3> _target_funcs_dt =
-            std::array<TPBT<double, 0, 3>, 3>{};
+    std::array<TPBT<Real, 0, 3>, 3> _target_funcs_dt =
+            std::array<TPBT<Real, 0, 3>, 3>{};
+
+    // Bernstein ranges of the target functions, computed together with the
+    // coefficients
+    std::array<std::pair<double, double>, 3> _ranges_t =
+            std::array<std::pair<double, double>, 3>{};
+
+    std::array<std::pair<double, double>, 3> _ranges_dt =
+            std::array<std::pair<double, double>, 3>{};
 
     bool _last_split_dir = false;
     uint64_t _split_level = 0;
 
     Options _opts = Options{};
 
-    template <std::size_t D>
-    std::array<Self, 4> split() const
+    BasicTensorCoreLinesEvaluator(
+            const DoubleTri& tri,
+            const std::array<TPBT<Real, 1, 2>, 3>& target_funcs_t,
+            const std::array<TPBT<Real, 0, 3>, 3>& target_funcs_dt,
+            const std::array<std::pair<double, double>, 3>& ranges_t,
+            const std::array<std::pair<double, double>, 3>& ranges_dt,
+            bool last_split_dir,
+            uint64_t split_level,
+            const Options& opts)
+            : _tri(tri),
+              _target_funcs_t(target_funcs_t),
+              _target_funcs_dt(target_funcs_dt),
+              _ranges_t(ranges_t),
+              _ranges_dt(ranges_dt),
+              _last_split_dir(last_split_dir),
+              _split_level(split_level),
+              _opts(opts)
     {
-        static_assert(D >= 0 && D < 2,
-                      "Split space must be 0 (position) or 1 (direction)");
-
-        auto part = [&](std::size_t i) {
-            return TensorCoreLinesEvaluator(
-                    _tri.split<D>(i),
-                    {_target_funcs_t[0].split<D>(i),
-                     _target_funcs_t[1].split<D>(i),
-                     _target_funcs_t[2].split<D>(i)},
-                    {_target_funcs_dt[0].split<D>(i),
-                     _target_funcs_dt[1].split<D>(i),
-                     _target_funcs_dt[2].split<D>(i)},
-                    D == 1,
-                    _split_level + 1,
-                    _opts);
-        };
-        return {part(0), part(1), part(2), part(3)};
     }
 };
 
-double distance(const TensorCoreLinesEvaluator& t1,
-                const TensorCoreLinesEvaluator& t2);
+template <typename Real>
+double distance(const BasicTensorCoreLinesEvaluator<Real>& t1,
+                const BasicTensorCoreLinesEvaluator<Real>& t2)
+{
+    return distance(t1.tris(), t2.tris());
+}
+
+using TensorCoreLinesEvaluator = BasicTensorCoreLinesEvaluator<double>;
 
 static_assert(is_evaluator<TensorCoreLinesEvaluator>::value,
               "TensorCoreLinesEvaluator is not a valid evaluator!");
+static_assert(is_evaluator<BasicTensorCoreLinesEvaluator<float>>::value,
+              "BasicTensorCoreLinesEvaluator<float> is not a valid evaluator!");
+
+/**
+ * @brief Compute the coefficients of the components of
+ *      ((\nabla T * r) * r) x r on a direction triangle.
+ *
+ * @param dt Derivatives of the tensor field (constant on the position
+ *      triangle, taken at its center)
+ * @param r The direction triangle
+ * @return Polynomials of degree 3 in the direction space
+ */
+std::array<TensorProductBezierTriangle<double, double, 0, 3>, 3>
+tensorCoreLinesDerivCoeffs(const std::array<TensorInterp, 3>& dt,
+                           const Triangle& r);
 }
 
 #endif
@@ -3,6 +3,9 @@
 
 #include <Eigen/Core>
 
+#include <cmath>
+#include <utility>
+
 namespace tl
 {
 
@@ -10,6 +13,22 @@ using Vec3d = Eigen::Vector3d;
 using Mat3d = Eigen::Matrix3d;
 
 
+/**
+ * @brief Orthonormal basis of the plane orthogonal to a unit vector.
+ * @details Branch-free construction of Duff et al., "Building an Orthonormal
+ *      Basis, Revisited" (2017). The result depends only on n, and (b1, b2, n)
+ *      is a right-handed orthonormal basis.
+ */
+inline std::pair<Vec3d, Vec3d> orthonormalBasis(const Vec3d& n)
+{
+    const auto sign = std::copysign(1., n[2]);
+    const auto a = -1. / (sign + n[2]);
+    const auto b = n[0] * n[1] * a;
+    return {Vec3d{1. + sign * n[0] * n[0] * a, sign * b, -sign * n[0]},
+            Vec3d{b, sign + n[1] * n[1] * a, -n[1]}};
+}
+
+
 /**
  * Rank/order of an eigenvalue of a 3x3 matrix
  */
@@ -21,6 +40,25 @@ enum class ERank : int
 };
 
 
+/**
+ * @brief Mesh of direction triangles the searches for parallel eigenvectors and
+ *      tensor core lines start with.
+ * @details Only one of each pair of antipodal triangles is used, since r and -r
+ *      describe the same eigenvector. Each triangle of the base mesh is split
+ *      into four a given number of times.
+ */
+enum class StartMesh : int
+{
+    /// Four flat octant triangles of the upper hemisphere
+    Octants = 0,
+    /// Octahedron refined geodesically, i.e. with the new corners projected
+    /// onto the unit sphere
+    Octahedron = 1,
+    /// Ten faces of an icosahedron refined geodesically
+    Icosahedron = 2
+};
+
+
 /**
  * Tensor line solution point.
  */
@@ -8,15 +8,23 @@
 #include <Eigen/Eigenvalues>
 #include <Eigen/LU>
 
+#include <boost/functional/hash.hpp>
 #include <boost/range/algorithm/min_element.hpp>
 #include <boost/range/algorithm_ext/insert.hpp>
 #include <boost/optional.hpp>
 
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <mutex>
 #include <stack>
 #include <queue>
 #include <iterator>
 #include <complex>
+#include <cstring>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 
 using namespace cpp_utils;
 
@@ -27,14 +35,48 @@ using namespace tl;
 /**
  * Representative Solution in a cluster of similar solutions
  */
-template <typename Evaluator>
 struct ClusterRepr
 {
     std::size_t cluster_size;
-    Evaluator eval;
+    TLCandidate candidate;
 };
 
 
+/// Distance of two candidates for clustering, see distance(const DoubleTri&,
+/// const DoubleTri&)
+double distance(const TLCandidate& c1, const TLCandidate& c2)
+{
+    return std::max(distance(Triangle{c1.pos_tri}, Triangle{c2.pos_tri}),
+                    distance(Triangle{c1.dir_tri}, Triangle{c2.dir_tri}));
+}
+
+
+/**
+ * @brief Convert the result of a search to candidates.
+ *
+ * @param tris Solution candidates and rough directions of early termination
+ * @param num_splits Number of split operations performed
+ * @param max_level Maximum subdivision level reached
+ * @return The candidates with their error estimates
+ */
+template <typename Evaluator>
+TLCandidates makeCandidates(
+        const std::pair<std::vector<Evaluator>, std::vector<Vec3d>>& tris,
+        uint64_t num_splits,
+        uint64_t max_level)
+{
+    auto result = TLCandidates{{}, tris.second, num_splits, max_level};
+    result.cells.reserve(tris.first.size());
+    for(const auto& ev : tris.first)
+    {
+        result.cells.push_back({ev.tris().pos_tri.coefficients(),
+                                ev.tris().dir_tri.coefficients(),
+                                ev.error()});
+    }
+    return result;
+}
+
+
 /**
  * Cluster all triangles in a list that are closer than a given distance
  *
@@ -99,17 +141,14 @@ clusterTris(const CandList& cands, double epsilon)
  *      estimate is chosen as a representative. Also returns the number of
  *      elements in the cluster.
  *
- * @param clusters Vector of vectors of Evaluators representing solution
+ * @param clusters Vector of vectors of candidates representing solution
  *     clusters as produced by clusterTris().
  * @return A cluster representative for each input cluster.
  */
-template <typename Evaluator>
-std::vector<ClusterRepr<Evaluator>>
-findRepresentatives(const std::vector<std::vector<Evaluator>>& clusters)
+std::vector<ClusterRepr>
+findRepresentatives(const std::vector<std::vector<TLCandidate>>& clusters)
 {
-    static_assert(is_evaluator_v<Evaluator>,
-                  "findRepresentatives requires a valid Evaluator!");
-    auto result = std::vector<ClusterRepr<Evaluator>>{};
+    auto result = std::vector<ClusterRepr>{};
     for(const auto& c : clusters)
     {
         using namespace boost;
@@ -117,7 +156,7 @@ findRepresentatives(const std::vector<std::vector<Evaluator>>& clusters)
         result.push_back(
                 {c.size(),
                  *min_element(c, [](const auto& c1, const auto& c2) {
-                     return c1.error() < c2.error();
+                     return c1.error < c2.error;
                  })});
     }
     return result;
@@ -130,93 +169,109 @@ findRepresentatives(const std::vector<std::vector<Evaluator>>& clusters)
  *      imaginary eigenvalues, and packs into result list together with point
  *      position, eigenvector direction, eigenvalues.
  *
- * @param representatives TriPairs selected by findRepresentatives()
+ * @param representatives Candidates selected by findRepresentatives()
  * @param s_interp First tensor field on the triangle
  * @param t_interp Second tensor field on the triangle
  * @param tri Spatial triangle
+ * @param opts Options selecting the context info to compute
  * @return List of TLPoints with context info
  */
 PointList
 computeContextInfoPEV(
-        const std::vector<
-            ClusterRepr<ParallelEigenvectorsEvaluator>>& representatives,
+        const std::vector<ClusterRepr>& representatives,
         const TensorInterp& s_interp,
         const TensorInterp& t_interp,
-        const Triangle& tri)
+        const Triangle& tri,
+        const TLOptions& opts)
 {
     auto points = PointList{};
     points.reserve(representatives.size());
 
     for(const auto& r : representatives)
     {
-        const auto& pos_tri = r.eval.tris().pos_tri;
-        const auto& dir_tri = r.eval.tris().dir_tri;
+        const auto pos_tri = Triangle{r.candidate.pos_tri};
+        const auto dir_tri = Triangle{r.candidate.dir_tri};
 
         auto result_center = pos_tri({1. / 3., 1. / 3., 1. / 3.});
         auto result_dir = dir_tri({1. / 3., 1. / 3., 1. / 3.}).normalized();
 
-        // We want to know which eigenvector of each tensor field we have
-        // found (i.e. corresponding to largest, middle, or smallest
-        // eigenvalue)
-        // Therefore we explicitly compute the eigenvalues at the result
-        // position and check which ones the found eigenvector direction
-        // corresponds to.
-        // @todo: make this step optional
-
-        auto s = s_interp(result_center);
-        auto t = t_interp(result_center);
-
-        // Get eigenvalues from our computed direction
-        auto s_real_eigv = (s * result_dir).dot(result_dir);
-        auto t_real_eigv = (t * result_dir).dot(result_dir);
-
-        // Compute all eigenvalues using Eigen
-        auto s_eigvs = s.eigenvalues().eval();
-        auto t_eigvs = t.eigenvalues().eval();
-
-        // Find index of eigenvalue that is closest to the one we computed
-        using Vec3c = decltype(s_eigvs);
-        auto s_closest_index = Vec3d::Index{0};
-        (s_eigvs - Vec3c::Ones() * s_real_eigv)
-                .cwiseAbs()
-                .minCoeff(&s_closest_index);
-
-        auto t_closest_index = Vec3d::Index{0};
-        (t_eigvs - Vec3c::Ones() * t_real_eigv)
-                .cwiseAbs()
-                .minCoeff(&t_closest_index);
-
-        // Find which of the (real) eigenvalues ours is
-        auto count_larger_real = [](double ref,
-                                    const std::complex<double>& val) {
-            if(val.imag() != 0) return 0;
-            if(std::abs(ref) >= std::abs(val.real())) return 0;
-            return 1;
-        };
-        auto s_order = s_eigvs.unaryExpr([&](const std::complex<double>& val) {
-                                  return count_larger_real(
-                                          s_eigvs[s_closest_index].real(), val);
-                              })
-                               .sum();
-        auto t_order = t_eigvs.unaryExpr([&](const std::complex<double>& val) {
-                                  return count_larger_real(
-                                          t_eigvs[t_closest_index].real(), val);
-                              })
-                               .sum();
+        auto point = TLPoint{tri(result_center),
+                             ERank::First,
+                             ERank::First,
+                             result_dir,
+                             0.,
+                             0.,
+                             false,
+                             false,
+                             r.cluster_size,
+                             (pos_tri[1] - pos_tri[0]).norm(),
+                             (dir_tri[1] - dir_tri[0]).norm(),
+                             0.};
+
+        if(opts.compute_eigenvalues || opts.compute_ranks)
+        {
+            auto s = s_interp(result_center);
+            auto t = t_interp(result_center);
+
+            // Get eigenvalues from our computed direction
+            point.s_eival = (s * result_dir).dot(result_dir);
+            point.t_eival = (t * result_dir).dot(result_dir);
+
+            // We want to know which eigenvector of each tensor field we have
+            // found (i.e. corresponding to largest, middle, or smallest
+            // eigenvalue)
+            // Therefore we explicitly compute the eigenvalues at the result
+            // position and check which ones the found eigenvector direction
+            // corresponds to.
+            if(opts.compute_ranks)
+            {
+                // Compute all eigenvalues using Eigen
+                auto s_eigvs = s.eigenvalues().eval();
+                auto t_eigvs = t.eigenvalues().eval();
+
+                // Find index of eigenvalue that is closest to the one we
+                // computed
+                using Vec3c = decltype(s_eigvs);
+                auto s_closest_index = Vec3d::Index{0};
+                (s_eigvs - Vec3c::Ones() * point.s_eival)
+                        .cwiseAbs()
+                        .minCoeff(&s_closest_index);
+
+                auto t_closest_index = Vec3d::Index{0};
+                (t_eigvs - Vec3c::Ones() * point.t_eival)
+                        .cwiseAbs()
+                        .minCoeff(&t_closest_index);
+
+                // Find which of the (real) eigenvalues ours is
+                auto count_larger_real = [](double ref,
+                                            const std::complex<double>& val) {
+                    if(val.imag() != 0) return 0;
+                    if(std::abs(ref) >= std::abs(val.real())) return 0;
+                    return 1;
+                };
+                auto s_order =
+                        s_eigvs.unaryExpr([&](const std::complex<double>& val) {
+                                   return count_larger_real(
+                                           s_eigvs[s_closest_index].real(),
+                                           val);
+                               })
+                                .sum();
+                auto t_order =
+                        t_eigvs.unaryExpr([&](const std::complex<double>& val) {
+                                   return count_larger_real(
+                                           t_eigvs[t_closest_index].real(),
+                                           val);
+                               })
+                                .sum();
+
+                point.s_rank = ERank(s_order);
+                point.t_rank = ERank(t_order);
+                point.s_has_imaginary = s_eigvs.sum().imag() != 0;
+                point.t_has_imaginary = t_eigvs.sum().imag() != 0;
+            }
+        }
 
-        points.push_back(
-                TLPoint{tri(result_center),
-                         ERank(s_order),
-                         ERank(t_order),
-                         result_dir,
-                         s_real_eigv,
-                         t_real_eigv,
-                         s_eigvs.sum().imag() != 0,
-                         t_eigvs.sum().imag() != 0,
-                         r.cluster_size,
-                         (pos_tri[1] - pos_tri[0]).norm(),
-                         (dir_tri[1] - dir_tri[0]).norm(),
-                         0.});
+        points.push_back(point);
     }
     return points;
 }
@@ -224,116 +279,144 @@ computeContextInfoPEV(
 
 PointList
 computeContextInfoTCL(
-        const std::vector<ClusterRepr<TensorCoreLinesEvaluator>>& representatives,
+        const std::vector<ClusterRepr>& representatives,
         const TensorInterp& t_interp,
         const TensorInterp& tx_interp,
         const TensorInterp& ty_interp,
         const TensorInterp& tz_interp,
-        const Triangle& tri)
+        const Triangle& tri,
+        const TLOptions& opts)
 {
     auto points = PointList{};
     points.reserve(representatives.size());
 
     for(const auto& r : representatives)
     {
-        const auto& pos_tri = r.eval.tris().pos_tri;
-        const auto& dir_tri = r.eval.tris().dir_tri;
+        const auto pos_tri = Triangle{r.candidate.pos_tri};
+        const auto dir_tri = Triangle{r.candidate.dir_tri};
 
         auto result_center = pos_tri({1. / 3., 1. / 3., 1. / 3.});
         auto result_dir = dir_tri({1. / 3., 1. / 3., 1. / 3.}).normalized();
 
-        // We want to know which eigenvector of each tensor field we have
-        // found (i.e. corresponding to largest, middle, or smallest
-        // eigenvalue)
-        // Therefore we explicitly compute the eigenvalues at the result
-        // position and check which ones the found eigenvector direction
-        // corresponds to.
-        // @todo: make this step optional
+        auto point = TLPoint{tri(result_center),
+                             ERank::First,
+                             ERank::First,
+                             result_dir,
+                             0.,
+                             0.,
+                             false,
+                             false,
+                             r.cluster_size,
+                             (pos_tri[1] - pos_tri[0]).norm(),
+                             (dir_tri[1] - dir_tri[0]).norm(),
+                             0.};
+
+        if(!opts.compute_eigenvalues && !opts.compute_ranks
+           && !opts.compute_line_stability)
+        {
+            points.push_back(point);
+            continue;
+        }
 
         auto t = t_interp(result_center);
         auto tx = tx_interp(result_center);
         auto ty = ty_interp(result_center);
         auto tz = tz_interp(result_center);
-        auto dt = (tx * result_dir[0] + ty * result_dir[1] + tz * result_dir[2])
-                          .eval();
-
-        // Get eigenvalues from our computed direction
-        auto t_real_eigv = (t * result_dir).dot(result_dir);
-        auto dt_real_eigv = (dt * result_dir).dot(result_dir);
-
-        // Compute all eigenvalues using Eigen
-        auto t_eigvs = t.eigenvalues().eval();
-        auto dt_eigvs = dt.eigenvalues().eval();
-
-        // Find index of eigenvalue that is closest to the one we computed
-        using Vec3c = decltype(t_eigvs);
-        auto t_closest_index = Vec3d::Index{0};
-        (t_eigvs - Vec3c::Ones() * t_real_eigv)
-                .cwiseAbs()
-                .minCoeff(&t_closest_index);
-
-        auto dt_closest_index = Vec3d::Index{0};
-        (dt_eigvs - Vec3c::Ones() * dt_real_eigv)
-                .cwiseAbs()
-                .minCoeff(&dt_closest_index);
-
-        // Find which of the (real) eigenvalues ours is
-        auto count_larger_real = [](double ref,
-                                    const std::complex<double>& val) {
-            if(val.imag() != 0) return 0;
-            if(std::abs(ref) >= std::abs(val.real())) return 0;
-            return 1;
-        };
-        auto t_order = t_eigvs.unaryExpr([&](const std::complex<double>& val) {
-                                  return count_larger_real(
-                                          t_eigvs[t_closest_index].real(), val);
-                              })
-                               .sum();
-        auto dt_order =
-                dt_eigvs.unaryExpr([&](const std::complex<double>& val) {
-                            return count_larger_real(
-                                    dt_eigvs[dt_closest_index].real(), val);
-                        })
-                        .sum();
-
-        // det( (NablaT*R1)*R  ,  (NablaT*R2)*R ,  R )
-        auto r2 = Vec3d::Random().normalized().eval();
-        while(result_dir.cross(r2).norm() < 0.1)
+
+        if(opts.compute_eigenvalues || opts.compute_ranks)
         {
-            r2 = Vec3d::Random().normalized().eval();
+            auto dt = (tx * result_dir[0] + ty * result_dir[1]
+                       + tz * result_dir[2])
+                              .eval();
+
+            // Get eigenvalues from our computed direction
+            point.s_eival = (t * result_dir).dot(result_dir);
+            point.t_eival = (dt * result_dir).dot(result_dir);
+
+            // We want to know which eigenvector of each tensor field we have
+            // found (i.e. corresponding to largest, middle, or smallest
+            // eigenvalue)
+            // Therefore we explicitly compute the eigenvalues at the result
+            // position and check which ones the found eigenvector direction
+            // corresponds to.
+            if(opts.compute_ranks)
+            {
+                // Compute all eigenvalues using Eigen
+                auto t_eigvs = t.eigenvalues().eval();
+                auto dt_eigvs = dt.eigenvalues().eval();
+
+                // Find index of eigenvalue that is closest to the one we
+                // computed
+                using Vec3c = decltype(t_eigvs);
+                auto t_closest_index = Vec3d::Index{0};
+                (t_eigvs - Vec3c::Ones() * point.s_eival)
+                        .cwiseAbs()
+                        .minCoeff(&t_closest_index);
+
+                auto dt_closest_index = Vec3d::Index{0};
+                (dt_eigvs - Vec3c::Ones() * point.t_eival)
+                        .cwiseAbs()
+                        .minCoeff(&dt_closest_index);
+
+                // Find which of the (real) eigenvalues ours is
+                auto count_larger_real = [](double ref,
+                                            const std::complex<double>& val) {
+                    if(val.imag() != 0) return 0;
+                    if(std::abs(ref) >= std::abs(val.real())) return 0;
+                    return 1;
+                };
+                auto t_order =
+                        t_eigvs.unaryExpr([&](const std::complex<double>& val) {
+                                   return count_larger_real(
+                                           t_eigvs[t_closest_index].real(),
+                                           val);
+                               })
+                                .sum();
+                auto dt_order =
+                        dt_eigvs.unaryExpr(
+                                        [&](const std::complex<double>& val) {
+                                            return count_larger_real(
+                                                    dt_eigvs[dt_closest_index]
+                                                            .real(),
+                                                    val);
+                                        })
+                                .sum();
+
+                point.s_rank = ERank(t_order);
+                point.t_rank = ERank(dt_order);
+                point.s_has_imaginary = t_eigvs.sum().imag() != 0;
+                point.t_has_imaginary = dt_eigvs.sum().imag() != 0;
+            }
         }
-        auto r1 = result_dir.cross(r2).normalized().eval();
-        r2 = r1.cross(result_dir).normalized().eval();
-        auto scale = t.operatorNorm();
-        auto stability = std::log(std::abs(
-                (Mat3d{} << ((tx * r1[0] + ty * r1[1] + tz * r1[2])
-                             * result_dir)
-                                    / scale,
-                 ((tx * r2[0] + ty * r2[1] + tz * r2[2]) * result_dir) / scale,
-                 result_dir)
-                        .finished()
-                        .determinant()));
 
-        points.push_back(
-                TLPoint{tri(result_center),
-                         ERank(t_order),
-                         ERank(dt_order),
-                         result_dir,
-                         t_real_eigv,
-                         dt_real_eigv,
-                         t_eigvs.sum().imag() != 0,
-                         dt_eigvs.sum().imag() != 0,
-                         r.cluster_size,
-                         (pos_tri[1] - pos_tri[0]).norm(),
-                         (dir_tri[1] - dir_tri[0]).norm(),
-                         stability});
+        if(opts.compute_line_stability)
+        {
+            // det( (NablaT*R1)*R  ,  (NablaT*R2)*R ,  R )
+            // The determinant is bilinear and alternating in R1 and R2, so any
+            // orthonormal basis of the plane gives the same value up to sign.
+            const auto basis = orthonormalBasis(result_dir);
+            const auto& r1 = basis.first;
+            const auto& r2 = basis.second;
+            auto scale = t.operatorNorm();
+            point.line_stability = std::log(std::abs(
+                    (Mat3d{} << ((tx * r1[0] + ty * r1[1] + tz * r1[2])
+                                 * result_dir)
+                                        / scale,
+                     ((tx * r2[0] + ty * r2[1] + tz * r2[2]) * result_dir)
+                             / scale,
+                     result_dir)
+                            .finished()
+                            .determinant()));
+        }
+
+        points.push_back(point);
     }
     return points;
 }
 
 
 PointList computeContextInfoTopo(
-        const std::vector<ClusterRepr<TensorTopologyEvaluator>>& representatives,
+        const std::vector<ClusterRepr>& representatives,
         const Triangle& tri)
 {
     auto points = PointList{};
@@ -341,7 +424,7 @@ PointList computeContextInfoTopo(
 
     for(const auto& r : representatives)
     {
-        const auto& pos_tri = r.eval.tris().pos_tri;
+        const auto pos_tri = Triangle{r.candidate.pos_tri};
 
         auto result_center = pos_tri({1. / 3., 1. / 3., 1. / 3.});
 
@@ -366,11 +449,11 @@ PointList computeContextInfoTopo(
 /**
  * @brief Perform the recursive root search using an evaluator.
  * @details Performs a breadth-first recursive search for solutions of the
- *      starting evaluator. Terminates when all solutions have been found or
+ *      starting evaluators. Terminates when all solutions have been found or
  *      when more than @a max_candidates are in the queue. In the latter case,
  *      @c boost::none is returned.
  *
- * @param start_ev Starting evaluator
+ * @param start_evs Starting evaluators
  * @param max_candidates Maximum number of triangles produced during subdivision
  *     before early termination
  * @param num_splits Optional output parameter for storing the number of split
@@ -382,7 +465,7 @@ PointList computeContextInfoTopo(
  */
 template <typename Evaluator>
 boost::optional<std::vector<Evaluator>>
-rootSearch(const Evaluator& start_ev,
+rootSearch(const std::vector<Evaluator>& start_evs,
            std::size_t max_candidates,
            uint64_t* num_splits = nullptr,
            uint64_t* max_level = nullptr)
@@ -391,7 +474,10 @@ rootSearch(const Evaluator& start_ev,
                   "rootSearch requires a valid Evaluator!");
 
     auto work_lst = std::queue<Evaluator>{};
-    work_lst.push(start_ev);
+    for(const auto& ev : start_evs)
+    {
+        work_lst.push(ev);
+    }
     auto result = std::vector<Evaluator>{};
 
     while(!work_lst.empty())
@@ -408,6 +494,7 @@ rootSearch(const Evaluator& start_ev,
         switch(ev.eval())
         {
             case Result::Split:
+            case Result::Promote:
                 for(const auto& p : ev.split())
                 {
                     work_lst.push(p);
@@ -425,15 +512,605 @@ rootSearch(const Evaluator& start_ev,
 }
 
 
+/**
+ * Perform the recursive root search starting from a single evaluator.
+ */
+template <typename Evaluator>
+boost::optional<std::vector<Evaluator>>
+rootSearch(const Evaluator& start_ev,
+           std::size_t max_candidates,
+           uint64_t* num_splits = nullptr,
+           uint64_t* max_level = nullptr)
+{
+    return rootSearch(std::vector<Evaluator>{start_ev},
+                      max_candidates,
+                      num_splits,
+                      max_level);
+}
+
+
+/**
+ * Reconstruct a subdivision of an evaluator from the sequence of parts chosen
+ * at each split.
+ *
+ * @param ev Evaluator to subdivide
+ * @param path Parts chosen at each level, two bits per level starting with the
+ *     least significant bits
+ * @param levels Number of splits to perform
+ */
+template <typename Evaluator>
+Evaluator replaySplits(Evaluator ev, uint64_t path, std::size_t levels)
+{
+    for(auto i : range(levels))
+    {
+        ev = ev.split((path >> (2 * i)) & 3u);
+    }
+    return ev;
+}
+
+
+/**
+ * @brief Perform the root search with reduced precision on the coarse levels.
+ * @details Subdivides the first @a coarse_levels levels with a
+ *      CoarseEvaluator (usually using single precision coefficients), which
+ *      discards triangles only where the result is certain despite rounding
+ *      errors. The triangles of the last coarse level are converted to
+ *      Evaluator with their rounding error bound (see
+ *      Options::coefficient_error) and evaluated once more, which discards
+ *      many of them. The remaining triangles are promoted to Evaluator by
+ *      repeating the same splits from @a start_ev in full precision and
+ *      processed by rootSearch(). Since only discarding uses the converted
+ *      coefficients, the found solutions and statistics do not depend on
+ *      @a coarse_levels.
+ *
+ *      Promoting all triangles by conversion instead would accept triangles
+ *      within the error bound of the tolerance. The bound does not shrink
+ *      with the triangles, so the pairwise exclusion stays undecidable in a
+ *      band around the zero sets, which costs more splits than the
+ *      repetition saves.
+ *
+ *      Falls back to rootSearch() if the coefficients of @a start_ev can not
+ *      be represented by the CoarseEvaluator.
+ *
+ * @param start_ev Starting evaluator
+ * @param tolerance Error tolerance for subdivision
+ * @param coarse_levels Number of subdivision levels evaluated in reduced
+ *     precision (at most 32)
+ * @param max_candidates Maximum number of triangles produced during subdivision
+ *     before early termination
+ * @param num_splits Optional output parameter for storing the number of split
+ *     operations performed
+ * @param max_level Optional output parameter for storing the maximum
+ *     subdivision level reached
+ * @return A vector of solution candidates represented by Evaluators at the lowest
+ *      subdivision level, or boost::none if the search was terminated early.
+ */
+template <typename CoarseEvaluator, typename Evaluator>
+boost::optional<std::vector<Evaluator>>
+mixedPrecisionRootSearch(const Evaluator& start_ev,
+                         double tolerance,
+                         std::size_t coarse_levels,
+                         std::size_t max_candidates,
+                         uint64_t* num_splits = nullptr,
+                         uint64_t* max_level = nullptr)
+{
+    static_assert(is_evaluator_v<CoarseEvaluator>,
+                  "mixedPrecisionRootSearch requires a valid Evaluator!");
+    using Real = typename CoarseEvaluator::Scalar;
+
+    // Splitting only forms convex combinations of at most ten coefficients
+    // with exactly representable weights, so every level adds less than 16
+    // units in the last place relative to the largest coefficient
+    auto bound = start_ev.coefficientBound();
+    auto rounding_error = 16 * std::numeric_limits<Real>::epsilon() * bound;
+    if(coarse_levels == 0 || !(bound > std::numeric_limits<Real>::min())
+       || !(16 * bound < std::numeric_limits<Real>::max()))
+    {
+        return rootSearch(start_ev, max_candidates, num_splits, max_level);
+    }
+    coarse_levels = std::min(coarse_levels, std::size_t{32});
+
+    struct Candidate
+    {
+        CoarseEvaluator ev;
+        uint64_t path;
+    };
+
+    auto work_lst = std::queue<Candidate>{};
+    work_lst.push({CoarseEvaluator(start_ev, {tolerance, rounding_error}), 0});
+    auto promoted = std::vector<Evaluator>{};
+
+    while(!work_lst.empty())
+    {
+        if(work_lst.size() + promoted.size() > max_candidates)
+        {
+            return boost::none;
+        }
+        auto cand = work_lst.front();
+        work_lst.pop();
+        auto level = cand.ev.splitLevel() - start_ev.splitLevel();
+
+        auto result = Result::Promote;
+        if(level < coarse_levels)
+        {
+            result = cand.ev.eval();
+        }
+        else
+        {
+            // Evaluate the converted coefficients with the error they carry,
+            // so that triangles which can be discarded already are not
+            // repeated in full precision
+            auto error = rounding_error * double(cand.ev.splitLevel() + 1);
+            auto ev = Evaluator(cand.ev, {tolerance, 0., error});
+            if(ev.eval() == Result::Discard)
+            {
+                result = Result::Discard;
+            }
+        }
+
+        // Accepted and promoted triangles are counted when rootSearch()
+        // evaluates them again in full precision
+        if(result == Result::Split || result == Result::Discard)
+        {
+            if(num_splits) *num_splits += 1;
+            if(max_level && *max_level < cand.ev.splitLevel())
+            {
+                *max_level = cand.ev.splitLevel();
+            }
+        }
+
+        switch(result)
+        {
+            case Result::Split:
+                for(auto i : range(std::size_t{4}))
+                {
+                    work_lst.push({cand.ev.split(i),
+                                   cand.path | (uint64_t{i} << (2 * level))});
+                }
+                break;
+            case Result::Accept:
+            case Result::Promote:
+                promoted.push_back(replaySplits(start_ev, cand.path, level));
+                break;
+            case Result::Discard:
+                break;
+        }
+    }
+
+    return rootSearch(promoted, max_candidates, num_splits, max_level);
+}
+
+
+#ifdef TL_HAS_VECTOR_TYPES
+/// Number of candidates processed at once by lockstepRootSearch(), so that
+/// the lanes of double precision coefficients fill a vector register
+#if defined(__AVX__)
+constexpr std::size_t lockstep_lanes = 4;
+#else
+constexpr std::size_t lockstep_lanes = 2;
+#endif
+
+
+/**
+ * Get the target functions of an evaluator, grouped by polynomial type.
+ */
+template <typename Real>
+auto targetFunctionGroups(const BasicParallelEigenvectorsEvaluator<Real>& ev)
+{
+    return std::tie(ev.targetFunctions());
+}
+
+
+template <typename Real>
+auto targetFunctionGroups(const BasicTensorCoreLinesEvaluator<Real>& ev)
+{
+    return std::tie(ev.targetFunctionsT(), ev.targetFunctionsDT());
+}
+
+
+/**
+ * Get the type of a copy of the target function groups (only used to determine
+ * the type).
+ */
+template <typename... Groups>
+std::tuple<std::decay_t<Groups>...>
+valueGroups(const std::tuple<Groups...>&);
+
+
+/**
+ * Get the type of the target function groups with W polynomials in lanes
+ * (only used to determine the type).
+ */
+template <std::size_t W, typename... Groups>
+std::tuple<std::array<
+        LanePolynomial<typename std::decay_t<Groups>::value_type, W>,
+        std::tuple_size<std::decay_t<Groups>>::value>...>
+laneGroups(const std::tuple<Groups...>&);
+
+
+/**
+ * Call a function with the corresponding elements of two tuples.
+ */
+template <typename Tuple1, typename Tuple2, typename Function, std::size_t... I>
+void forEachPair(Tuple1& t1,
+                 Tuple2& t2,
+                 Function f,
+                 std::index_sequence<I...>)
+{
+    (f(std::get<I>(t1), std::get<I>(t2)), ...);
+}
+
+
+template <typename Tuple1, typename Tuple2, typename Function>
+void forEachPair(Tuple1& t1, Tuple2& t2, Function f)
+{
+    forEachPair(t1,
+                t2,
+                f,
+                std::make_index_sequence<std::tuple_size<
+                        std::remove_const_t<Tuple1>>::value>{});
+}
+
+
+/**
+ * @brief Perform the root search for several starting evaluators in lockstep.
+ * @details All starting evaluators must be at the same subdivision level and
+ *      the candidates of all searches are processed level by level. The
+ *      target functions of up to @a W candidates are interleaved in lanes
+ *      (see Lanes), so that splitting into the four sub-triangles and the sign
+ *      test of the Bernstein ranges are done for all of them at once. Only
+ *      sub-triangles that pass the sign test are turned into evaluators and
+ *      evaluated individually, which also decides about their acceptance.
+ *
+ *      Every search is processed in the same order as by rootSearch(),
+ *      including the early termination if the queue exceeds
+ *      @a max_candidates, so the results and statistics are identical to
+ *      calling rootSearch() for every starting evaluator. The evaluators must
+ *      not carry a rounding error (see Options::rounding_error), since the
+ *      sign test in lanes does not account for it.
+ *
+ * @param start_evs Starting evaluators
+ * @param opts Options of the starting evaluators
+ * @param max_candidates Maximum number of triangles produced during subdivision
+ *     of each starting evaluator before early termination
+ * @param num_splits Optional output parameter for storing the number of split
+ *     operations performed
+ * @param max_level Optional output parameter for storing the maximum
+ *     subdivision level reached
+ * @tparam W Number of lanes
+ * @return For each starting evaluator, the result of rootSearch()
+ */
+template <std::size_t W, typename Evaluator>
+std::vector<boost::optional<std::vector<Evaluator>>>
+lockstepRootSearch(const std::vector<Evaluator>& start_evs,
+                   const typename Evaluator::Options& opts,
+                   std::size_t max_candidates,
+                   uint64_t* num_splits = nullptr,
+                   uint64_t* max_level = nullptr)
+{
+    static_assert(is_evaluator_v<Evaluator>,
+                  "lockstepRootSearch requires a valid Evaluator!");
+    using Groups = decltype(
+            valueGroups(targetFunctionGroups(std::declval<Evaluator>())));
+    using LaneGroups = decltype(
+            laneGroups<W>(targetFunctionGroups(std::declval<Evaluator>())));
+    using Lane = Lanes<typename Evaluator::Scalar, W>;
+    using Mask = decltype(Lane{} == 0);
+
+    // Candidates of the current level, W at a time
+    struct Block
+    {
+        LaneGroups funcs;
+        std::array<DoubleTri, W> tris;
+        std::array<std::size_t, W> starts;
+        std::size_t size = 0;
+    };
+
+    // Emulates the queue of rootSearch() for each starting evaluator
+    struct Search
+    {
+        // Number of candidates of the current level in the queue
+        std::size_t queued = 0;
+        // Number of candidates of the current level taken from the queue
+        std::size_t popped = 0;
+        // Number of candidates of the current level that were split
+        std::size_t splits = 0;
+        bool failed = false;
+        std::vector<Evaluator> result;
+    };
+
+    auto add_candidate = [](std::vector<Block>& blocks,
+                            const Evaluator& ev,
+                            std::size_t start) {
+        if(blocks.empty() || blocks.back().size == W)
+        {
+            blocks.emplace_back();
+        }
+        auto& block = blocks.back();
+        auto groups = targetFunctionGroups(ev);
+        forEachPair(block.funcs, groups, [&](auto& lanes, const auto& polys) {
+            set_lane(lanes, block.size, polys);
+        });
+        block.tris[block.size] = ev.tris();
+        block.starts[block.size] = start;
+        ++block.size;
+    };
+
+    auto make_evaluator = [&](const LaneGroups& funcs,
+                              std::size_t lane,
+                              const DoubleTri& tri,
+                              bool space,
+                              uint64_t level) {
+        auto groups = Groups{};
+        forEachPair(groups, funcs, [&](auto& polys, const auto& lanes) {
+            using Poly = typename std::decay_t<decltype(polys)>::value_type;
+            polys = get_lane<Poly>(lanes, lane);
+        });
+        return std::apply(
+                [&](const auto&... polys) {
+                    return Evaluator(tri, polys..., space, level, opts);
+                },
+                groups);
+    };
+
+    auto count = [&](uint64_t level) {
+        if(num_splits) *num_splits += 1;
+        if(max_level && *max_level < level) *max_level = level;
+    };
+
+    auto searches = std::vector<Search>(start_evs.size());
+    auto frontier = std::vector<Block>{};
+    for(auto i: range(start_evs.size()))
+    {
+        if(max_candidates < 1)
+        {
+            searches[i].failed = true;
+            continue;
+        }
+        auto ev = start_evs[i];
+        count(ev.splitLevel());
+        switch(ev.eval())
+        {
+            case Result::Split:
+            case Result::Promote:
+                searches[i].splits = 1;
+                add_candidate(frontier, ev, i);
+                break;
+            case Result::Accept:
+                searches[i].result.push_back(ev);
+                break;
+            case Result::Discard:
+                break;
+        }
+    }
+
+    if(!start_evs.empty())
+    {
+        auto space = !start_evs.front().lastSplitDir();
+        auto level = uint64_t{start_evs.front().splitLevel() + 1};
+        while(!frontier.empty())
+        {
+            for(auto& s: searches)
+            {
+                s.queued = 4 * s.splits;
+                s.popped = 0;
+                s.splits = 0;
+            }
+
+            auto next = std::vector<Block>{};
+            for(const auto& block: frontier)
+            {
+                // Split all lanes and apply the sign test to the four parts
+                auto children = std::array<LaneGroups, 4>{};
+                auto has_root = std::array<Mask, 4>{};
+                for(auto part: range(std::size_t{4}))
+                {
+                    has_root[part] = Lane{} == 0;
+                    forEachPair(
+                            children[part],
+                            block.funcs,
+                            [&](auto& child, const auto& parent) {
+                                for(auto i: range(parent.size()))
+                                {
+                                    child[i] = space ? parent[i].template
+                                                       split<1>(part)
+                                                     : parent[i].template
+                                                       split<0>(part);
+                                }
+                                lanes_have_root(child, has_root[part]);
+                            });
+                }
+
+                // Process the children in the order of rootSearch()
+                for(auto lane: range(block.size))
+                {
+                    auto& s = searches[block.starts[lane]];
+                    for(auto part: range(std::size_t{4}))
+                    {
+                        if(s.failed) break;
+                        if(s.queued - s.popped + 4 * s.splits > max_candidates)
+                        {
+                            s.failed = true;
+                            break;
+                        }
+                        ++s.popped;
+                        count(level);
+                        if(!has_root[part][lane]) continue;
+
+                        const auto& tri = block.tris[lane];
+                        auto ev = make_evaluator(
+                                children[part],
+                                lane,
+                                space ? tri.template split<1>(part)
+                                      : tri.template split<0>(part),
+                                space,
+                                level);
+                        switch(ev.eval())
+                        {
+                            case Result::Split:
+                            case Result::Promote:
+                                ++s.splits;
+                                add_candidate(next, ev, block.starts[lane]);
+                                break;
+                            case Result::Accept:
+                                s.result.push_back(ev);
+                                break;
+                            case Result::Discard:
+                                break;
+                        }
+                    }
+                }
+            }
+
+            frontier = std::move(next);
+            space = !space;
+            ++level;
+        }
+    }
+
+    auto result = std::vector<boost::optional<std::vector<Evaluator>>>{};
+    for(auto& s: searches)
+    {
+        if(s.failed)
+        {
+            result.push_back(boost::none);
+        }
+        else
+        {
+            result.push_back(std::move(s.result));
+        }
+    }
+    return result;
+}
+#endif
+
+
+/**
+ * @brief Perform the root search for several starting evaluators.
+ * @details Uses lockstepRootSearch() for all starting evaluators at once if
+ *      the compiler supports vector types, or mixedPrecisionRootSearch() for
+ *      each of them otherwise or if @a coarse_levels is not zero.
+ *
+ * @param start_evs Starting evaluators (at the same subdivision level)
+ * @param opts Options of the starting evaluators
+ * @param coarse_levels Number of subdivision levels evaluated in reduced
+ *     precision
+ * @param max_candidates Maximum number of triangles produced during subdivision
+ *     of each starting evaluator before early termination
+ * @param num_splits Optional output parameter for storing the number of split
+ *     operations performed
+ * @param max_level Optional output parameter for storing the maximum
+ *     subdivision level reached
+ * @return For each starting evaluator, a vector of solution candidates or
+ *     boost::none if its search was terminated early
+ */
+template <typename CoarseEvaluator, typename Evaluator>
+std::vector<boost::optional<std::vector<Evaluator>>>
+startRootSearch(const std::vector<Evaluator>& start_evs,
+                const typename Evaluator::Options& opts,
+                std::size_t coarse_levels,
+                std::size_t max_candidates,
+                uint64_t* num_splits = nullptr,
+                uint64_t* max_level = nullptr)
+{
+#ifdef TL_HAS_VECTOR_TYPES
+    if(coarse_levels == 0)
+    {
+        return lockstepRootSearch<lockstep_lanes>(
+                start_evs, opts, max_candidates, num_splits, max_level);
+    }
+#endif
+
+    auto result = std::vector<boost::optional<std::vector<Evaluator>>>{};
+    for(const auto& ev : start_evs)
+    {
+        result.push_back(mixedPrecisionRootSearch<CoarseEvaluator>(
+                ev,
+                opts.tolerance,
+                coarse_levels,
+                max_candidates,
+                num_splits,
+                max_level));
+    }
+    return result;
+}
+
+
+/**
+ * @brief Get the direction triangles selected in the options.
+ * @details The patches only depend on the start mesh and its level, so they
+ *      are created once and shared by all searches. The patches of the
+ *      default mesh are computed at compile time.
+ */
+const std::vector<StartPatch>& startPatches(const TLOptions& opts)
+{
+    if(opts.start_mesh == StartMesh::Octants && opts.start_mesh_level == 1)
+    {
+        static const auto octants = std::vector<StartPatch>(
+                octant_start_patches.begin(), octant_start_patches.end());
+        return octants;
+    }
+
+    using Key = std::pair<StartMesh, std::size_t>;
+    static auto cache = std::map<Key, std::vector<StartPatch>>{};
+    static auto mutex = std::mutex{};
+
+    auto lock = std::lock_guard<std::mutex>{mutex};
+    auto key = Key{opts.start_mesh, opts.start_mesh_level};
+    auto it = cache.find(key);
+    if(it == cache.end())
+    {
+        it = cache.emplace(key, make_start_patches(key.first, key.second))
+                     .first;
+    }
+    return it->second;
+}
+
+
+/**
+ * @brief Select the start patches the search has to start with.
+ * @details With seeding, patches are skipped if the predicate proves that they
+ *      contain no solution, judged from the tensors at the vertices of the
+ *      face (see may_contain_eigenvector()).
+ *
+ * @param patches All start patches
+ * @param seeded Whether to select the patches with the predicate
+ * @param may_contain_solution Predicate that returns false if a patch contains
+ *     no solution
+ * @return The selected patches
+ */
+template <typename Predicate>
+std::vector<const StartPatch*>
+seedPatches(const std::vector<StartPatch>& patches,
+            bool seeded,
+            Predicate may_contain_solution)
+{
+    auto result = std::vector<const StartPatch*>{};
+    result.reserve(patches.size());
+    for(const auto& patch : patches)
+    {
+        if(!seeded || may_contain_solution(patch))
+        {
+            result.push_back(&patch);
+        }
+    }
+    return result;
+}
+
+
 /**
  * Search for parallel eigenvector intersections with a triangle.
  *
  * @param s First tensor field (linear on a triangle)
  * @param t Second tensor field (linear on a triangle)
  * @param tri Physical location of the triangle
+ * @param patches Direction triangles the search starts with (see
+ *     seedPatches())
  * @param tolerance Error tolerance for subdivision
  * @param max_candidates Maximum number of triangles produced during subdivision
  *     before early termination
+ * @param coarse_levels Number of subdivision levels evaluated in single
+ *     precision (see mixedPrecisionRootSearch())
  * @param num_splits Optional output parameter for storing the number of split
  *     operations performed
  * @param max_level Optional output parameter for storing the maximum
@@ -445,8 +1122,10 @@ std::pair<std::vector<ParallelEigenvectorsEvaluator>, std::vector<Vec3d>>
 parallelEigenvectorSearch(const TensorInterp& s,
                           const TensorInterp& t,
                           const Triangle& tri,
+                          const std::vector<const StartPatch*>& patches,
                           double tolerance,
                           std::size_t max_candidates,
+                          std::size_t coarse_levels,
                           uint64_t* num_splits = nullptr,
                           uint64_t* max_level = nullptr)
 {
@@ -455,36 +1134,35 @@ parallelEigenvectorSearch(const TensorInterp& s,
     // too many splits
     auto failed_dirs = std::vector<Vec3d>{};
 
-    auto compute_tri = [&](const Triangle& r) {
-        auto start_ev = ParallelEigenvectorsEvaluator(
-                {tri, r}, s, t, {tolerance});
-        auto solutions =
-                rootSearch(start_ev, max_candidates, num_splits, max_level);
-        if(solutions)
+    auto opts = ParallelEigenvectorsEvaluator::Options{tolerance};
+    auto start_evs = std::vector<ParallelEigenvectorsEvaluator>{};
+    start_evs.reserve(patches.size());
+    for(const auto& patch: patches)
+    {
+        start_evs.emplace_back(tri, *patch, s, t, opts);
+    }
+
+    auto solutions =
+            startRootSearch<BasicParallelEigenvectorsEvaluator<float>>(
+                    start_evs,
+                    opts,
+                    coarse_levels,
+                    max_candidates,
+                    num_splits,
+                    max_level);
+    for(auto i: range(start_evs.size()))
+    {
+        if(solutions[i])
         {
             boost::insert(
                     result,
                     result.end(),
-                    solutions.value());
+                    solutions[i].value());
         }
         else
         {
-            failed_dirs.push_back(r({1./3, 1./3, 1./3}));
-        }
-    };
-
-    // Four triangles covering hemisphere
-    auto dir_tris = std::array<Triangle, 4>{
-            Triangle{{Vec3d{1, 0, 0}, Vec3d{0, 1, 0}, Vec3d{0, 0, 1}}},
-            Triangle{{Vec3d{0, 1, 0}, Vec3d{-1, 0, 0}, Vec3d{0, 0, 1}}},
-            Triangle{{Vec3d{-1, 0, 0}, Vec3d{0, -1, 0}, Vec3d{0, 0, 1}}},
-            Triangle{{Vec3d{0, -1, 0}, Vec3d{1, 0, 0}, Vec3d{0, 0, 1}}}};
-
-    for(const auto& tri : dir_tris)
-    {
-        for(const auto& t : tri.split())
-        {
-            compute_tri(t);
+            failed_dirs.push_back(
+                    patches[i]->triangle()({1. / 3, 1. / 3, 1. / 3}));
         }
     }
 
@@ -499,9 +1177,13 @@ parallelEigenvectorSearch(const TensorInterp& s,
  * @param t Tensor field (linear on a triangle)
  * @param dt derivatives of the tensor field (constant on a triangle)
  * @param tri Physical location of the triangle
+ * @param patches Direction triangles the search starts with (see
+ *     seedPatches())
  * @param tolerance Error tolerance for subdivision
  * @param max_candidates Maximum number of triangles produced during subdivision
  *     before early termination
+ * @param coarse_levels Number of subdivision levels evaluated in single
+ *     precision (see mixedPrecisionRootSearch())
  * @param num_splits Optional output parameter for storing the number of split
  *     operations performed
  * @param max_level Optional output parameter for storing the maximum
@@ -513,8 +1195,10 @@ std::pair<std::vector<TensorCoreLinesEvaluator>, std::vector<Vec3d>>
 tensorCoreLinesSearch(const TensorInterp& t,
                          const std::array<TensorInterp, 3>& dt,
                          const Triangle& tri,
+                         const std::vector<const StartPatch*>& patches,
                          double tolerance,
                          std::size_t max_candidates,
+                         std::size_t coarse_levels,
                          uint64_t* num_splits = nullptr,
                          uint64_t* max_level = nullptr)
 {
@@ -523,32 +1207,31 @@ tensorCoreLinesSearch(const TensorInterp& t,
     // too many splits
     auto failed_dirs = std::vector<Vec3d>{};
 
-    auto compute_tri = [&](const Triangle& r) {
-        auto start_ev = TensorCoreLinesEvaluator(
-                {tri, r}, t, dt, {tolerance});
-        auto solutions =
-                rootSearch(start_ev, max_candidates, num_splits, max_level);
-        if(solutions)
+    auto opts = TensorCoreLinesEvaluator::Options{tolerance};
+    auto start_evs = std::vector<TensorCoreLinesEvaluator>{};
+    start_evs.reserve(patches.size());
+    for(const auto& patch: patches)
+    {
+        start_evs.emplace_back(tri, *patch, t, dt, opts);
+    }
+
+    auto solutions = startRootSearch<BasicTensorCoreLinesEvaluator<float>>(
+            start_evs,
+            opts,
+            coarse_levels,
+            max_candidates,
+            num_splits,
+            max_level);
+    for(auto i: range(start_evs.size()))
+    {
+        if(solutions[i])
         {
-            boost::insert(result, result.end(), solutions.value());
+            boost::insert(result, result.end(), solutions[i].value());
         }
         else
         {
-            failed_dirs.push_back(r({1. / 3, 1. / 3, 1. / 3}));
-        }
-    };
-
-    auto dir_tris = std::array<Triangle, 4>{
-            Triangle{{Vec3d{1, 0, 0}, Vec3d{0, 1, 0}, Vec3d{0, 0, 1}}},
-            Triangle{{Vec3d{0, 1, 0}, Vec3d{-1, 0, 0}, Vec3d{0, 0, 1}}},
-            Triangle{{Vec3d{-1, 0, 0}, Vec3d{0, -1, 0}, Vec3d{0, 0, 1}}},
-            Triangle{{Vec3d{0, -1, 0}, Vec3d{1, 0, 0}, Vec3d{0, 0, 1}}}};
-
-    for(const auto& tri : dir_tris)
-    {
-        for(const auto& t : tri.split())
-        {
-            compute_tri(t);
+            failed_dirs.push_back(
+                    patches[i]->triangle()({1. / 3, 1. / 3, 1. / 3}));
         }
     }
 
@@ -564,6 +1247,8 @@ tensorCoreLinesSearch(const TensorInterp& t,
  * @param tolerance Error tolerance for subdivision
  * @param max_candidates Maximum number of triangles produced during subdivision
  *     before early termination
+ * @param coarse_levels Number of subdivision levels evaluated in single
+ *     precision (see mixedPrecisionRootSearch())
  * @param num_splits Optional output parameter for storing the number of split
  *     operations performed
  * @param max_level Optional output parameter for storing the maximum
@@ -576,6 +1261,7 @@ tensorTopologySearch(const TensorInterp& t,
                      const Triangle& tri,
                      double tolerance,
                      std::size_t max_candidates,
+                     std::size_t coarse_levels,
                      uint64_t* num_splits = nullptr,
                      uint64_t* max_level = nullptr)
 {
@@ -584,7 +1270,13 @@ tensorTopologySearch(const TensorInterp& t,
             t,
             {tolerance});
     auto solutions =
-            rootSearch(start_ev, max_candidates, num_splits, max_level);
+            mixedPrecisionRootSearch<BasicTensorTopologyEvaluator<float>>(
+                    start_ev,
+                    tolerance,
+                    coarse_levels,
+                    max_candidates,
+                    num_splits,
+                    max_level);
 
     if(solutions)
     {
@@ -597,40 +1289,173 @@ tensorTopologySearch(const TensorInterp& t,
     }
 }
 
+
+/**
+ * @brief Append a value to the key of a face with the lowest mantissa bits
+ *      dropped.
+ * @details Negative zero is mapped to zero, so that both have the same key.
+ */
+void appendKey(std::vector<uint64_t>& key, double value, unsigned mantissa_bits)
+{
+    const auto drop = 52 - std::min(mantissa_bits, 52u);
+    auto bits = uint64_t{0};
+    value = value == 0. ? 0. : value;
+    std::memcpy(&bits, &value, sizeof(bits));
+    key.push_back(bits >> drop);
+}
+
+
+void appendKey(std::vector<uint64_t>& key,
+               const std::array<Mat3d, 3>& tensors,
+               unsigned mantissa_bits)
+{
+    for(const auto& t : tensors)
+    {
+        for(auto i : range(t.size()))
+        {
+            appendKey(key, t.data()[i], mantissa_bits);
+        }
+    }
+}
+
+
+/**
+ * @brief Drop the lowest mantissa bits of the tensor entries like appendKey().
+ * @details The result is the tensors represented by the key, so the search of
+ *      a key does not depend on which of the faces sharing it comes first.
+ */
+std::array<Mat3d, 3> truncated(std::array<Mat3d, 3> tensors,
+                               unsigned mantissa_bits)
+{
+    const auto drop = 52 - std::min(mantissa_bits, 52u);
+    for(auto& t : tensors)
+    {
+        for(auto i : range(t.size()))
+        {
+            auto& value = t.data()[i];
+            value = value == 0. ? 0. : value;
+            auto bits = uint64_t{0};
+            std::memcpy(&bits, &value, sizeof(bits));
+            bits = (bits >> drop) << drop;
+            std::memcpy(&value, &bits, sizeof(bits));
+        }
+    }
+    return tensors;
+}
+
+
+/**
+ * Start the key of a face with the type of the search and all options
+ */
+std::vector<uint64_t> optionsKey(uint64_t line_type, const TLOptions& opts)
+{
+    auto key = std::vector<uint64_t>{line_type,
+                                     opts.max_candidates,
+                                     opts.coarse_levels,
+                                     uint64_t(opts.start_mesh),
+                                     opts.start_mesh_level,
+                                     opts.seeded_search,
+                                     opts.compute_eigenvalues,
+                                     opts.compute_ranks,
+                                     opts.compute_line_stability};
+    appendKey(key, opts.tolerance, 52);
+    appendKey(key, opts.cluster_epsilon, 52);
+    return key;
+}
+
 } // namespace
 
 
 namespace tl
 {
 
-TLResult findParallelEigenvectors(const std::array<Mat3d, 3>& s,
-                                   const std::array<Mat3d, 3>& t,
-                                   const std::array<Vec3d, 3>& x,
-                                   const TLOptions& opts)
+void PointTensors::set(std::size_t point, const Mat3d& tensor)
+{
+    tensors[point] = tensor;
+    operator_norms[point] = tensor.operatorNorm();
+}
+
+
+VertexTensors vertexTensors(const std::array<Mat3d, 3>& tensors)
+{
+    return {tensors,
+            {tensors[0].operatorNorm(),
+             tensors[1].operatorNorm(),
+             tensors[2].operatorNorm()}};
+}
+
+
+TLCandidates searchParallelEigenvectors(const VertexTensors& s,
+                                       const VertexTensors& t,
+                                       const TLOptions& opts)
 {
     auto start_tri =
             Triangle{{Vec3d{1., 0., 0.}, Vec3d{0., 1., 0.}, Vec3d{0., 0., 1.}}};
 
-    auto st = TensorInterp{{s[0], s[1], s[2]}};
-    auto tt = TensorInterp{{t[0], t[1], t[2]}};
-    auto xt = Triangle{{x[0], x[1], x[2]}};
+    auto st = TensorInterp{s.tensors};
+    auto tt = TensorInterp{t.tensors};
+
+    auto patches = seedPatches(
+            startPatches(opts), opts.seeded_search, [&](const auto& patch) {
+                return may_contain_eigenvector(st, patch)
+                       && may_contain_eigenvector(tt, patch);
+            });
 
     auto num_splits = uint64_t{0};
     auto max_level = uint64_t{0};
     auto tris = parallelEigenvectorSearch(st,
                                           tt,
                                           start_tri,
+                                          patches,
                                           opts.tolerance,
                                           opts.max_candidates,
+                                          opts.coarse_levels,
                                           &num_splits,
                                           &max_level);
 
-    auto clustered_tris = clusterTris(tris.first, opts.cluster_epsilon);
+    return makeCandidates(tris, num_splits, max_level);
+}
+
+
+TLResult clusterParallelEigenvectors(const TLCandidates& candidates,
+                                     const VertexTensors& s,
+                                     const VertexTensors& t,
+                                     const std::array<Vec3d, 3>& x,
+                                     const TLOptions& opts)
+{
+    auto st = TensorInterp{s.tensors};
+    auto tt = TensorInterp{t.tensors};
+    auto xt = Triangle{{x[0], x[1], x[2]}};
+
+    auto clustered_tris = clusterTris(candidates.cells, opts.cluster_epsilon);
 
     auto representatives = findRepresentatives(clustered_tris);
 
-    return {computeContextInfoPEV(representatives, st, tt, xt),
-            tris.second};
+    return {computeContextInfoPEV(representatives, st, tt, xt, opts),
+            candidates.non_line_dirs,
+            candidates.num_splits,
+            candidates.max_level};
+}
+
+
+TLResult findParallelEigenvectors(const VertexTensors& s,
+                                   const VertexTensors& t,
+                                   const std::array<Vec3d, 3>& x,
+                                   const TLOptions& opts)
+{
+    return clusterParallelEigenvectors(
+            searchParallelEigenvectors(s, t, opts), s, t, x, opts);
+}
+
+
+TLResult findParallelEigenvectors(const std::array<Mat3d, 3>& s,
+                                   const std::array<Mat3d, 3>& t,
+                                   const std::array<Vec3d, 3>& x,
+                                   const TLOptions& opts)
+{
+    // The operator norms are not used for parallel eigenvectors
+    return findParallelEigenvectors(
+            VertexTensors{s, {}}, VertexTensors{t, {}}, x, opts);
 }
 
 
@@ -646,40 +1471,87 @@ TLResult findParallelEigenvectors(const std::array<Mat3d, 3>& s,
 }
 
 
-TLResult findTensorCoreLines(const std::array<Mat3d, 3>& t,
-                                 const std::array<Mat3d, 3>& dt,
-                                 const std::array<Vec3d, 3>& x,
-                                 const TLOptions& opts)
+TLCandidates searchTensorCoreLines(const VertexTensors& t,
+                                   const std::array<Mat3d, 3>& dt,
+                                   const TLOptions& opts)
 {
     auto start_tri =
             Triangle{{Vec3d{1., 0., 0.}, Vec3d{0., 1., 0.}, Vec3d{0., 0., 1.}}};
 
-    auto tt = TensorInterp{{t[0], t[1], t[2]}};
+    auto tt = TensorInterp{t.tensors};
     auto tx = TensorInterp{{dt[0], dt[0], dt[0]}};
     auto ty = TensorInterp{{dt[1], dt[1], dt[1]}};
     auto tz = TensorInterp{{dt[2], dt[2], dt[2]}};
-    auto xt = Triangle{{x[0], x[1], x[2]}};
 
-    auto tolerance_scale = std::max({tt[0].operatorNorm(),
-                                     tt[1].operatorNorm(),
-                                     tt[2].operatorNorm()});
+    auto tolerance_scale = std::max({t.operator_norms[0],
+                                     t.operator_norms[1],
+                                     t.operator_norms[2]});
+
+    auto patches = seedPatches(
+            startPatches(opts), opts.seeded_search, [&](const auto& patch) {
+                return may_contain_eigenvector(tt, patch)
+                       && !separated_from_zero(
+                               tensorCoreLinesDerivCoeffs({tx, ty, tz},
+                                                          patch.triangle()),
+                               1);
+            });
 
     auto num_splits = uint64_t{0};
     auto max_level = uint64_t{0};
     auto tris = tensorCoreLinesSearch(tt,
                                          {tx, ty, tz},
                                          start_tri,
+                                         patches,
                                          opts.tolerance*tolerance_scale,
                                          opts.max_candidates,
+                                         opts.coarse_levels,
                                          &num_splits,
                                          &max_level);
 
-    auto clustered_tris = clusterTris(tris.first, opts.cluster_epsilon);
+    return makeCandidates(tris, num_splits, max_level);
+}
+
+
+TLResult clusterTensorCoreLines(const TLCandidates& candidates,
+                                const VertexTensors& t,
+                                const std::array<Mat3d, 3>& dt,
+                                const std::array<Vec3d, 3>& x,
+                                const TLOptions& opts)
+{
+    auto tt = TensorInterp{t.tensors};
+    auto tx = TensorInterp{{dt[0], dt[0], dt[0]}};
+    auto ty = TensorInterp{{dt[1], dt[1], dt[1]}};
+    auto tz = TensorInterp{{dt[2], dt[2], dt[2]}};
+    auto xt = Triangle{{x[0], x[1], x[2]}};
+
+    auto clustered_tris = clusterTris(candidates.cells, opts.cluster_epsilon);
 
     auto representatives = findRepresentatives(clustered_tris);
 
-    return {computeContextInfoTCL(representatives, tt, tx, ty, tz, xt),
-            tris.second};
+    return {computeContextInfoTCL(
+                    representatives, tt, tx, ty, tz, xt, opts),
+            candidates.non_line_dirs,
+            candidates.num_splits,
+            candidates.max_level};
+}
+
+
+TLResult findTensorCoreLines(const VertexTensors& t,
+                             const std::array<Mat3d, 3>& dt,
+                             const std::array<Vec3d, 3>& x,
+                             const TLOptions& opts)
+{
+    return clusterTensorCoreLines(
+            searchTensorCoreLines(t, dt, opts), t, dt, x, opts);
+}
+
+
+TLResult findTensorCoreLines(const std::array<Mat3d, 3>& t,
+                                 const std::array<Mat3d, 3>& dt,
+                                 const std::array<Vec3d, 3>& x,
+                                 const TLOptions& opts)
+{
+    return findTensorCoreLines(vertexTensors(t), dt, x, opts);
 }
 
 
@@ -694,19 +1566,17 @@ TLResult findTensorCoreLines(const std::array<Mat3d, 3>& t,
             opts);
 }
 
-TLResult findTensorTopology(const std::array<Mat3d, 3>& t,
-                             const std::array<Vec3d, 3>& x,
-                             const TLOptions& opts)
+TLCandidates searchTensorTopology(const VertexTensors& t,
+                                  const TLOptions& opts)
 {
     auto start_tri =
             Triangle{{Vec3d{1., 0., 0.}, Vec3d{0., 1., 0.}, Vec3d{0., 0., 1.}}};
 
-    auto tt = TensorInterp{{t[0], t[1], t[2]}};
-    auto xt = Triangle{{x[0], x[1], x[2]}};
+    auto tt = TensorInterp{t.tensors};
 
-    auto tolerance_scale = std::max({tt[0].operatorNorm(),
-                                     tt[1].operatorNorm(),
-                                     tt[2].operatorNorm()});
+    auto tolerance_scale = std::max({t.operator_norms[0],
+                                     t.operator_norms[1],
+                                     t.operator_norms[2]});
 
     auto num_splits = uint64_t{0};
     auto max_level = uint64_t{0};
@@ -714,15 +1584,44 @@ TLResult findTensorTopology(const std::array<Mat3d, 3>& t,
                                      start_tri,
                                      opts.tolerance * tolerance_scale,
                                      opts.max_candidates,
+                                     opts.coarse_levels,
                                      &num_splits,
                                      &max_level);
 
-    auto clustered_tris = clusterTris(tris.first, opts.cluster_epsilon);
+    return makeCandidates(tris, num_splits, max_level);
+}
+
+
+TLResult clusterTensorTopology(const TLCandidates& candidates,
+                               const std::array<Vec3d, 3>& x,
+                               const TLOptions& opts)
+{
+    auto xt = Triangle{{x[0], x[1], x[2]}};
+
+    auto clustered_tris = clusterTris(candidates.cells, opts.cluster_epsilon);
 
     auto representatives = findRepresentatives(clustered_tris);
 
     return {computeContextInfoTopo(representatives, xt),
-            tris.second};
+            candidates.non_line_dirs,
+            candidates.num_splits,
+            candidates.max_level};
+}
+
+
+TLResult findTensorTopology(const VertexTensors& t,
+                            const std::array<Vec3d, 3>& x,
+                            const TLOptions& opts)
+{
+    return clusterTensorTopology(searchTensorTopology(t, opts), x, opts);
+}
+
+
+TLResult findTensorTopology(const std::array<Mat3d, 3>& t,
+                             const std::array<Vec3d, 3>& x,
+                             const TLOptions& opts)
+{
+    return findTensorTopology(vertexTensors(t), x, opts);
 }
 
 
@@ -735,4 +1634,112 @@ TLResult findTensorTopology(const std::array<Mat3d, 3>& t,
             opts);
 }
 
+
+
+std::size_t FaceResultCache::KeyHash::operator()(const Key& key) const
+{
+    return boost::hash_range(key.begin(), key.end());
+}
+
+
+template <typename Search>
+TLResult FaceResultCache::memoized(const Key& key,
+                                   const std::array<Vec3d, 3>& x,
+                                   Search search)
+{
+    auto result = TLResult{};
+    auto found = false;
+    {
+        auto lock = std::lock_guard<std::mutex>{_mutex};
+        auto it = _results.find(key);
+        if(it != _results.end())
+        {
+            result = it->second;
+            found = true;
+        }
+    }
+
+    if(found)
+    {
+        ++_hits;
+    }
+    else
+    {
+        ++_misses;
+        // Search outside of the lock, a concurrent search for the same key
+        // only costs time
+        result = search();
+        auto lock = std::lock_guard<std::mutex>{_mutex};
+        auto inserted = _results.emplace(key, result);
+        if(inserted.second)
+        {
+            _order.push(&inserted.first->first);
+            if(_results.size() > _max_entries)
+            {
+                _results.erase(_results.find(*_order.front()));
+                _order.pop();
+            }
+        }
+    }
+
+    // Map the barycentric coordinates to the triangle of the face
+    for(auto& p : result.points)
+    {
+        p.pos = x[0] * p.pos[0] + x[1] * p.pos[1] + x[2] * p.pos[2];
+    }
+    return result;
+}
+
+
+TLResult FaceResultCache::findParallelEigenvectors(
+        const VertexTensors& s,
+        const VertexTensors& t,
+        const std::array<Vec3d, 3>& x,
+        const TLOptions& opts)
+{
+    auto key = optionsKey(0, opts);
+    appendKey(key, s.tensors, _mantissa_bits);
+    appendKey(key, t.tensors, _mantissa_bits);
+    return memoized(key, x, [&]() {
+        return tl::findParallelEigenvectors(
+                vertexTensors(truncated(s.tensors, _mantissa_bits)),
+                vertexTensors(truncated(t.tensors, _mantissa_bits)),
+                {Vec3d{1., 0., 0.}, Vec3d{0., 1., 0.}, Vec3d{0., 0., 1.}},
+                opts);
+    });
+}
+
+
+TLResult FaceResultCache::findTensorCoreLines(const VertexTensors& t,
+                                              const std::array<Mat3d, 3>& dt,
+                                              const std::array<Vec3d, 3>& x,
+                                              const TLOptions& opts)
+{
+    auto key = optionsKey(1, opts);
+    appendKey(key, t.tensors, _mantissa_bits);
+    appendKey(key, dt, _mantissa_bits);
+    return memoized(key, x, [&]() {
+        return tl::findTensorCoreLines(
+                vertexTensors(truncated(t.tensors, _mantissa_bits)),
+                truncated(dt, _mantissa_bits),
+                {Vec3d{1., 0., 0.}, Vec3d{0., 1., 0.}, Vec3d{0., 0., 1.}},
+                opts);
+    });
+}
+
+
+TLResult FaceResultCache::findTensorTopology(const VertexTensors& t,
+                                             const std::array<Vec3d, 3>& x,
+                                             const TLOptions& opts)
+{
+    auto key = optionsKey(2, opts);
+    appendKey(key, t.tensors, _mantissa_bits);
+    return memoized(key, x, [&]() {
+        return tl::findTensorTopology(
+                vertexTensors(truncated(t.tensors, _mantissa_bits)),
+                {Vec3d{1., 0., 0.}, Vec3d{0., 1., 0.}, Vec3d{0., 0., 1.}},
+                opts);
+    });
+}
+
 } // namespace tl
@@ -4,7 +4,13 @@
 #include "TensorLineDefinitions.hh"
 
 #include <vector>
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
 
 namespace tl
 {
@@ -21,6 +27,53 @@ struct TLResult
     // List of (approximate) eigenvector directions for which
     // a planar or volume structure might exist
     std::vector<Vec3d> non_line_dirs;
+    // Number of subdivision cells evaluated during the search
+    uint64_t num_splits = 0;
+    // Maximum subdivision level reached during the search
+    uint64_t max_level = 0;
+};
+
+
+/**
+ * Solution candidate of the search: a subdivision cell in (barycentric)
+ * position and direction space that was accepted
+ */
+struct TLCandidate
+{
+    std::array<Vec3d, 3> pos_tri;
+    std::array<Vec3d, 3> dir_tri;
+    // Worst case residual of the target functions on the cell
+    double error;
+
+    friend bool operator==(const TLCandidate& c1, const TLCandidate& c2)
+    {
+        return c1.pos_tri == c2.pos_tri && c1.dir_tri == c2.dir_tri
+               && c1.error == c2.error;
+    }
+};
+
+
+/**
+ * Unclustered result of the search on a face, which only depends on the
+ * options of the search and not on the clustering (see TLOptions)
+ */
+struct TLCandidates
+{
+    std::vector<TLCandidate> cells;
+    // (Approximate) eigenvector directions for which a planar or volume
+    // structure might exist
+    std::vector<Vec3d> non_line_dirs;
+    // Number of subdivision cells evaluated during the search
+    uint64_t num_splits = 0;
+    // Maximum subdivision level reached during the search
+    uint64_t max_level = 0;
+
+    friend bool operator==(const TLCandidates& c1, const TLCandidates& c2)
+    {
+        return c1.cells == c2.cells && c1.non_line_dirs == c2.non_line_dirs
+               && c1.num_splits == c2.num_splits
+               && c1.max_level == c2.max_level;
+    }
 };
 
 
@@ -32,9 +85,142 @@ struct TLOptions
     double tolerance = 1e-6;
     double cluster_epsilon = 5e-6;
     std::size_t max_candidates = 100;
+    // Number of subdivision levels evaluated in single precision before
+    // switching to double precision (0 disables the single precision search)
+    std::size_t coarse_levels = 0;
+    // Mesh of direction triangles the searches for parallel eigenvectors and
+    // tensor core lines start with
+    StartMesh start_mesh = StartMesh::Octants;
+    // Number of times each triangle of the start mesh is split
+    std::size_t start_mesh_level = 1;
+    // Skip the start patches that provably contain no solution, judged from
+    // the eigenvector residuals of the tensors at the vertices of the face
+    bool seeded_search = false;
+    // Context info computed for the found points besides position, direction,
+    // cluster size and uncertainties. Fields that are not computed are zero
+    // and cost nothing.
+    // Eigenvalues belonging to the found eigenvector
+    bool compute_eigenvalues = true;
+    // Ranks of these eigenvalues and presence of imaginary eigenvalues, which
+    // need full eigen decompositions
+    bool compute_ranks = true;
+    // Numeric stability of tensor core lines
+    bool compute_line_stability = true;
+};
+
+
+/**
+ * @brief Tensors at the vertices of a face together with quantities derived
+ *      from them that do not depend on the face.
+ * @details Use PointTensors::face() to share the per-vertex work between all
+ *      faces incident to a mesh point.
+ */
+struct VertexTensors
+{
+    std::array<Mat3d, 3> tensors;
+    // Operator norms of the tensors
+    std::array<double, 3> operator_norms;
+};
+
+
+/**
+ * @brief Tensors at the points of a mesh together with quantities derived
+ *      from them, stored in a separate array for each quantity.
+ * @details The derived quantities are computed once per mesh point by set(),
+ *      which may be called concurrently for different points.
+ */
+struct PointTensors
+{
+    std::vector<Mat3d> tensors;
+    // Operator norms of the tensors
+    std::vector<double> operator_norms;
+
+    explicit PointTensors(std::size_t num_points = 0)
+        : tensors(num_points), operator_norms(num_points)
+    {
+    }
+
+    /**
+     * Store the tensor of a point and compute the derived quantities
+     */
+    void set(std::size_t point, const Mat3d& tensor);
+
+    /**
+     * Gather the cached quantities at the vertices of a face
+     */
+    VertexTensors face(const std::array<std::size_t, 3>& points) const
+    {
+        auto result = VertexTensors{};
+        for(auto i = std::size_t{0}; i < 3; ++i)
+        {
+            result.tensors[i] = tensors[points[i]];
+            result.operator_norms[i] = operator_norms[points[i]];
+        }
+        return result;
+    }
 };
 
 
+/**
+ * Compute the derived quantities of the tensors at the vertices of a single
+ * face.
+ */
+VertexTensors vertexTensors(const std::array<Mat3d, 3>& tensors);
+
+
+/**
+ * @brief Search for the solution candidates of parallel eigenvector lines on a
+ *      triangle defining two linear tensor fields.
+ * @details This is the expensive part of findParallelEigenvectors(), its
+ *      result can be stored and clustered again with other options of the
+ *      clustering.
+ *
+ * @param s The first tensor field (given by the cached quantities at the
+ *      triangle corners)
+ * @param t The second tensor field (given by the cached quantities at the
+ *      triangle corners)
+ * @param opts Options for the search algorithm
+ * @return The candidates in barycentric coordinates of the triangle
+ */
+TLCandidates searchParallelEigenvectors(const VertexTensors& s,
+                                        const VertexTensors& t,
+                                        const TLOptions& opts);
+
+/**
+ * Cluster the solution candidates found by searchParallelEigenvectors().
+ *
+ * @param candidates The candidates of the triangle
+ * @param s The first tensor field
+ * @param t The second tensor field
+ * @param x The triangle on which they are defined (given by the three corners)
+ * @param opts Options for the clustering
+ * @return The result with points in cartesian coordinates in the original 3D
+ *      space
+ */
+TLResult clusterParallelEigenvectors(const TLCandidates& candidates,
+                                     const VertexTensors& s,
+                                     const VertexTensors& t,
+                                     const std::array<Vec3d, 3>& x,
+                                     const TLOptions& opts);
+
+/**
+ * Find intersections of parallel eigenvector lines with a triangle defining
+ * two linear tensor fields.
+ *
+ * @param s The first tensor field (given by the cached quantities at the
+ *      triangle corners)
+ * @param t The second tensor field (given by the cached quantities at the
+ *      triangle corners)
+ * @param x The triangle on which they are defined (given by the three corners)
+ * @param opts Options for the search algorithm
+ * @return The result of the search with points in cartesian coordinates in the
+ *      original 3D space
+ */
+TLResult findParallelEigenvectors(const VertexTensors& s,
+                                  const VertexTensors& t,
+                                  const std::array<Vec3d, 3>& x,
+                                  const TLOptions& opts = TLOptions{});
+
 /**
  * Find intersections of parallel eigenvector lines with a triangle defining
  * two linear tensor fields.
@@ -67,6 +253,58 @@ TLResult findParallelEigenvectors(const std::array<Mat3d, 3>& s,
                                   const TLOptions& opts = TLOptions{});
 
 
+/**
+ * @brief Search for the solution candidates of tensor core lines on a triangle
+ *      defining a linear tensor field (see searchParallelEigenvectors()).
+ *
+ * @param t The tensor field (given by the cached quantities at the triangle
+ *     corners)
+ * @param dt The derivatives of the tensor field (in x, y, and z direction,
+ *     constant on the triangle)
+ * @param opts Options for the search algorithm
+ * @return The candidates in barycentric coordinates of the triangle
+ */
+TLCandidates searchTensorCoreLines(const VertexTensors& t,
+                                   const std::array<Mat3d, 3>& dt,
+                                   const TLOptions& opts);
+
+/**
+ * Cluster the solution candidates found by searchTensorCoreLines().
+ *
+ * @param candidates The candidates of the triangle
+ * @param t The tensor field
+ * @param dt The derivatives of the tensor field
+ * @param x The triangle on which the tensor field is defined (given by the
+ *     three corners)
+ * @param opts Options for the clustering
+ * @return The result with points in cartesian coordinates in the original 3D
+ *      space
+ */
+TLResult clusterTensorCoreLines(const TLCandidates& candidates,
+                                const VertexTensors& t,
+                                const std::array<Mat3d, 3>& dt,
+                                const std::array<Vec3d, 3>& x,
+                                const TLOptions& opts);
+
+/**
+ * Find intersections of tensor core lines with a triangle defining a linear
+ * tensor field
+ *
+ * @param t The tensor field (given by the cached quantities at the triangle
+ *     corners)
+ * @param dt The derivatives of the tensor field (in x, y, and z direction,
+ *     constant on the triangle)
+ * @param x The triangle on which the tensor field is defined (given by the
+ *     three corners)
+ * @param opts Options for the search algorithm
+ * @return The result of the search with points in cartesian coordinates in the
+ *      original 3D space
+ */
+TLResult findTensorCoreLines(const VertexTensors& t,
+                             const std::array<Mat3d, 3>& dt,
+                             const std::array<Vec3d, 3>& x,
+                             const TLOptions& opts = TLOptions{});
+
 /**
  * Find intersections of tensor core lines with a triangle defining a linear
  * tensor field
@@ -101,6 +339,48 @@ TLResult findTensorCoreLines(const std::array<Mat3d, 3>& t,
                              const TLOptions& opts = TLOptions{});
 
 
+/**
+ * @brief Search for the solution candidates of degenerate lines on a triangle
+ *      defining a linear tensor field (see searchParallelEigenvectors()).
+ *
+ * @param t The tensor field (given by the cached quantities at the triangle
+ *     corners)
+ * @param opts Options for the search algorithm
+ * @return The candidates in barycentric coordinates of the triangle
+ */
+TLCandidates searchTensorTopology(const VertexTensors& t,
+                                  const TLOptions& opts);
+
+/**
+ * Cluster the solution candidates found by searchTensorTopology().
+ *
+ * @param candidates The candidates of the triangle
+ * @param x The triangle on which the tensor field is defined (given by the
+ *     three corners)
+ * @param opts Options for the clustering
+ * @return The result with points in cartesian coordinates in the original 3D
+ *      space
+ */
+TLResult clusterTensorTopology(const TLCandidates& candidates,
+                               const std::array<Vec3d, 3>& x,
+                               const TLOptions& opts);
+
+/**
+ * Find intersections of degenerate lines (where two eigenvalues are equal) with
+ * a triangle defining a linear tensor field
+ *
+ * @param t The tensor field (given by the cached quantities at the triangle
+ *     corners)
+ * @param x The triangle on which the tensor field is defined (given by the
+ *     three corners)
+ * @param opts Options for the search algorithm
+ * @return The result of the search with points in cartesian coordinates in the
+ *      original 3D space
+ */
+TLResult findTensorTopology(const VertexTensors& t,
+                            const std::array<Vec3d, 3>& x,
+                            const TLOptions& opts = TLOptions{});
+
 /**
  * Find intersections of degenerate lines (where two eigenvalues are equal) with
  * a triangle defining a linear tensor field
@@ -130,6 +410,107 @@ TLResult findTensorTopology(const std::array<Mat3d, 3>& t,
 TLResult findTensorTopology(const std::array<Mat3d, 3>& t,
                             const TLOptions& opts = TLOptions{});
 
+
+/**
+ * @brief Memoization of the search results of faces by their tensors.
+ * @details The result of the search in barycentric coordinates only depends on
+ *      the tensors at the vertices (and the derivatives for tensor core lines)
+ *      and the options, not on the position of the face. The cache stores
+ *      these results keyed by the tensors with the lowest mantissa bits
+ *      dropped, so faces in regions with identical or constant tensors are
+ *      searched only once. The search of a key uses the tensors with the
+ *      dropped bits cleared, so the result only depends on the key and not on
+ *      which face was searched first. The points of a hit are mapped to the
+ *      triangle of the face. The member functions may be called concurrently.
+ *
+ *      Since every face is searched with truncated tensors, the results
+ *      differ from an uncached search as if the tensor entries were perturbed
+ *      by a relative error of up to 2^-mantissa_bits (about 1e-12 for the
+ *      default), which is far below the usual tolerances. The points can
+ *      therefore differ in the last digits, and a point whose error is
+ *      within this perturbation of the tolerance can appear or disappear.
+ *
+ *      At most @a max_entries results are kept. When the cache is full, the
+ *      oldest result is evicted, which only affects the hit rate.
+ */
+class FaceResultCache
+{
+public:
+    /**
+     * @param mantissa_bits Number of mantissa bits of the tensor entries that
+     *      are part of the key (at most 52)
+     * @param max_entries Maximum number of results kept (at least 1)
+     */
+    explicit FaceResultCache(unsigned mantissa_bits = 40,
+                             std::size_t max_entries = std::size_t{1} << 20)
+        : _mantissa_bits(mantissa_bits),
+          _max_entries(std::max(max_entries, std::size_t{1}))
+    {
+    }
+
+    /**
+     * Same as tl::findParallelEigenvectors(), but looks up the result first
+     */
+    TLResult findParallelEigenvectors(const VertexTensors& s,
+                                      const VertexTensors& t,
+                                      const std::array<Vec3d, 3>& x,
+                                      const TLOptions& opts);
+
+    /**
+     * Same as tl::findTensorCoreLines(), but looks up the result first
+     */
+    TLResult findTensorCoreLines(const VertexTensors& t,
+                                 const std::array<Mat3d, 3>& dt,
+                                 const std::array<Vec3d, 3>& x,
+                                 const TLOptions& opts);
+
+    /**
+     * Same as tl::findTensorTopology(), but looks up the result first
+     */
+    TLResult findTensorTopology(const VertexTensors& t,
+                                const std::array<Vec3d, 3>& x,
+                                const TLOptions& opts);
+
+    /**
+     * Get the number of faces whose result was taken from the cache
+     */
+    uint64_t hits() const
+    {
+        return _hits;
+    }
+
+    /**
+     * Get the number of faces that were searched
+     */
+    uint64_t misses() const
+    {
+        return _misses;
+    }
+
+private:
+    using Key = std::vector<uint64_t>;
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Key& key) const;
+    };
+
+    template <typename Search>
+    TLResult memoized(const Key& key,
+                      const std::array<Vec3d, 3>& x,
+                      Search search);
+
+    unsigned _mantissa_bits;
+    std::size_t _max_entries;
+    std::unordered_map<Key, TLResult, KeyHash> _results;
+    // Keys of the results in insertion order, for the eviction. The keys in
+    // the map are not moved by a rehash.
+    std::queue<const Key*> _order;
+    std::mutex _mutex;
+    std::atomic<uint64_t> _hits{0};
+    std::atomic<uint64_t> _misses{0};
+};
+
 } // namespace tl
 
 #endif
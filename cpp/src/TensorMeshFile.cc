@@ -0,0 +1,396 @@
+#include "TensorMeshFile.hh"
+
+#include <vtkCellArray.h>
+#include <vtkCellType.h>
+#include <vtkDataArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIdList.h>
+#include <vtkIdTypeArray.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkUnstructuredGrid.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // __linux__
+
+namespace
+{
+using namespace tl;
+
+uint64_t align(uint64_t offset)
+{
+    return (offset + tensor_mesh_alignment - 1) / tensor_mesh_alignment
+           * tensor_mesh_alignment;
+}
+
+
+void pad(std::ostream& out, uint64_t offset)
+{
+    static const char zeros[tensor_mesh_alignment] = {};
+    auto pos = uint64_t(out.tellp());
+    out.write(zeros, std::streamsize(offset - pos));
+}
+
+
+/**
+ * Check that a section of @a count items of @a size bytes lies in the file
+ */
+bool inFile(const MappedFile& file,
+            uint64_t offset,
+            uint64_t count,
+            std::size_t size)
+{
+    return offset % tensor_mesh_alignment == 0 && offset <= file.size()
+           && count <= (file.size() - offset) / size;
+}
+
+
+/**
+ * Wrap memory of the mapped file in a VTK array without copying it
+ */
+template <typename Array, typename T>
+vtkSmartPointer<Array> wrap(const MappedFile& file,
+                            uint64_t offset,
+                            uint64_t num_tuples,
+                            int num_components)
+{
+    auto array = vtkSmartPointer<Array>::New();
+    array->SetNumberOfComponents(num_components);
+    // save = 1: the array does not own the memory
+    array->SetArray(
+            reinterpret_cast<T*>(const_cast<char*>(file.data() + offset)),
+            vtkIdType(num_tuples * uint64_t(num_components)),
+            1);
+    return array;
+}
+} // namespace
+
+
+namespace tl
+{
+
+MappedFile::MappedFile(const std::string& file_name)
+{
+#ifdef __linux__
+    auto fd = ::open(file_name.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        throw std::runtime_error("Could not open " + file_name);
+    }
+    struct stat info;
+    if(::fstat(fd, &info) != 0)
+    {
+        ::close(fd);
+        throw std::runtime_error("Could not read " + file_name);
+    }
+    _size = std::size_t(info.st_size);
+    if(_size > 0)
+    {
+        // Private writable mapping, so that modifications of the VTK arrays
+        // never reach the file
+        auto* ptr = ::mmap(nullptr,
+                           _size,
+                           PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE,
+                           fd,
+                           0);
+        if(ptr != MAP_FAILED)
+        {
+            _data = static_cast<char*>(ptr);
+            ::madvise(ptr, _size, MADV_WILLNEED);
+        }
+    }
+    ::close(fd);
+    if(_data || _size == 0)
+    {
+        return;
+    }
+#endif // __linux__
+
+    auto in = std::ifstream{file_name, std::ios::binary | std::ios::ate};
+    if(!in)
+    {
+        throw std::runtime_error("Could not open " + file_name);
+    }
+    _buffer.resize(std::size_t(in.tellg()));
+    in.seekg(0);
+    in.read(_buffer.data(), std::streamsize(_buffer.size()));
+    if(!in)
+    {
+        throw std::runtime_error("Could not read " + file_name);
+    }
+    _data = _buffer.data();
+    _size = _buffer.size();
+}
+
+
+MappedFile::~MappedFile()
+{
+#ifdef __linux__
+    if(_data && _buffer.empty())
+    {
+        ::munmap(_data, _size);
+    }
+#endif // __linux__
+}
+
+
+bool isTensorMeshFile(const std::string& file_name)
+{
+    const auto ext = std::string{".tlm"};
+    return file_name.size() >= ext.size()
+           && std::equal(ext.rbegin(), ext.rend(), file_name.rbegin());
+}
+
+
+TensorMesh readTensorMesh(const std::string& file_name)
+{
+    auto file = std::make_shared<const MappedFile>(file_name);
+    auto damaged = [&]() {
+        return std::runtime_error(file_name + " is not a valid tensor mesh");
+    };
+
+    auto header = TensorMeshHeader{};
+    if(file->size() < sizeof(header))
+    {
+        throw damaged();
+    }
+    std::memcpy(&header, file->data(), sizeof(header));
+    if(!std::equal(std::begin(header.magic),
+                   std::end(header.magic),
+                   std::begin(tensor_mesh_magic)))
+    {
+        throw damaged();
+    }
+    if(header.byte_order != tensor_mesh_byte_order)
+    {
+        throw std::runtime_error(file_name
+                                 + " was written with another byte order");
+    }
+    const auto single = (header.flags & tensor_mesh_single_precision) != 0;
+    const auto value_size = single ? sizeof(float) : sizeof(double);
+    if(!inFile(*file,
+               sizeof(header),
+               header.num_fields,
+               sizeof(TensorMeshField))
+       || !inFile(*file, header.points_offset, header.num_points, 24)
+       || !inFile(*file, header.cells_offset, header.num_cells, 40))
+    {
+        throw damaged();
+    }
+
+    auto grid = vtkSmartPointer<vtkUnstructuredGrid>::New();
+
+    auto points = vtkSmartPointer<vtkPoints>::New();
+    points->SetData(wrap<vtkDoubleArray, double>(
+            *file, header.points_offset, header.num_points, 3));
+    grid->SetPoints(points);
+
+    // Invalid point ids would make VTK read out of bounds later
+    const auto* ids = reinterpret_cast<const int64_t*>(file->data()
+                                                       + header.cells_offset);
+    for(auto i = uint64_t{0}; i < header.num_cells; ++i)
+    {
+        const auto* cell = ids + 5 * i;
+        if(cell[0] != 4
+           || std::any_of(cell + 1, cell + 5, [&](int64_t id) {
+                  return id < 0 || uint64_t(id) >= header.num_points;
+              }))
+        {
+            throw damaged();
+        }
+    }
+
+    auto cell_ids = vtkSmartPointer<vtkIdTypeArray>::New();
+    if(sizeof(vtkIdType) == sizeof(int64_t))
+    {
+        cell_ids = wrap<vtkIdTypeArray, vtkIdType>(
+                *file, header.cells_offset, header.num_cells, 5);
+    }
+    else
+    {
+        // Narrower ids have to be converted
+        cell_ids->SetNumberOfValues(vtkIdType(5 * header.num_cells));
+        for(auto i = uint64_t{0}; i < 5 * header.num_cells; ++i)
+        {
+            cell_ids->SetValue(vtkIdType(i), vtkIdType(ids[i]));
+        }
+    }
+    auto cells = vtkSmartPointer<vtkCellArray>::New();
+    cells->SetCells(vtkIdType(header.num_cells), cell_ids);
+    grid->SetCells(VTK_TETRA, cells);
+
+    for(auto i = uint64_t{0}; i < header.num_fields; ++i)
+    {
+        auto field = TensorMeshField{};
+        std::memcpy(&field,
+                    file->data() + sizeof(header) + i * sizeof(field),
+                    sizeof(field));
+        if(!inFile(*file, field.offset, header.num_points, 9 * value_size)
+           || std::find(std::begin(field.name), std::end(field.name), '\0')
+                      == std::end(field.name))
+        {
+            throw damaged();
+        }
+        auto array = vtkSmartPointer<vtkDataArray>{};
+        if(single)
+        {
+            array = wrap<vtkFloatArray, float>(
+                    *file, field.offset, header.num_points, 9);
+        }
+        else
+        {
+            array = wrap<vtkDoubleArray, double>(
+                    *file, field.offset, header.num_points, 9);
+        }
+        array->SetName(field.name);
+        if(i == 0)
+        {
+            grid->GetPointData()->SetTensors(array);
+        }
+        else
+        {
+            grid->GetPointData()->AddArray(array);
+        }
+    }
+
+    return {file, grid};
+}
+
+
+void writeTensorMesh(vtkUnstructuredGrid* grid,
+                     const std::string& file_name,
+                     bool single_precision)
+{
+    auto tets = std::vector<vtkIdType>{};
+    for(auto i = vtkIdType{0}; i < grid->GetNumberOfCells(); ++i)
+    {
+        if(grid->GetCellType(i) == VTK_TETRA)
+        {
+            tets.push_back(i);
+        }
+    }
+    // Checked before the file is created, so that a failed read of the input
+    // does not leave an empty mesh behind
+    if(tets.empty())
+    {
+        throw std::runtime_error("The dataset has no tetrahedra, " + file_name
+                                 + " is not written");
+    }
+    if(tets.size() != std::size_t(grid->GetNumberOfCells()))
+    {
+        std::cout << "WARNING: Dataset contains non-tet cells, which will "
+                     "not be written.\n";
+    }
+
+    auto fields = std::vector<vtkDataArray*>{};
+    auto* point_data = grid->GetPointData();
+    for(auto i = 0; i < point_data->GetNumberOfArrays(); ++i)
+    {
+        auto* array = point_data->GetArray(i);
+        if(array && array->GetNumberOfComponents() == 9 && array->GetName()
+           && std::strlen(array->GetName()) < sizeof(TensorMeshField::name))
+        {
+            fields.push_back(array);
+        }
+    }
+    // Keep the active tensors first, so they are active again when reading
+    auto* tensors = point_data->GetTensors();
+    std::stable_partition(fields.begin(),
+                          fields.end(),
+                          [&](vtkDataArray* a) { return a == tensors; });
+
+    const auto num_points = uint64_t(grid->GetNumberOfPoints());
+    const auto value_size = single_precision ? sizeof(float) : sizeof(double);
+
+    auto out = std::ofstream{file_name, std::ios::binary};
+    if(!out)
+    {
+        throw std::runtime_error("Could not open " + file_name);
+    }
+
+    auto header = TensorMeshHeader{};
+    std::copy(std::begin(tensor_mesh_magic),
+              std::end(tensor_mesh_magic),
+              std::begin(header.magic));
+    header.byte_order = tensor_mesh_byte_order;
+    header.flags = single_precision ? tensor_mesh_single_precision : 0;
+    header.num_points = num_points;
+    header.num_cells = tets.size();
+    header.num_fields = fields.size();
+    header.points_offset =
+            align(sizeof(header) + fields.size() * sizeof(TensorMeshField));
+    header.cells_offset = align(header.points_offset + num_points * 24);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    auto offset = align(header.cells_offset + header.num_cells * 40);
+    for(auto* array : fields)
+    {
+        auto field = TensorMeshField{};
+        std::strncpy(field.name, array->GetName(), sizeof(field.name) - 1);
+        field.offset = offset;
+        out.write(reinterpret_cast<const char*>(&field), sizeof(field));
+        offset = align(offset + num_points * 9 * value_size);
+    }
+
+    pad(out, header.points_offset);
+    auto p = std::array<double, 3>{};
+    for(auto i = vtkIdType{0}; i < vtkIdType(num_points); ++i)
+    {
+        grid->GetPoint(i, p.data());
+        out.write(reinterpret_cast<const char*>(p.data()), sizeof(p));
+    }
+
+    pad(out, header.cells_offset);
+    auto ids = vtkSmartPointer<vtkIdList>::New();
+    for(auto c : tets)
+    {
+        grid->GetCellPoints(c, ids);
+        auto cell = std::array<int64_t, 5>{4};
+        for(auto j = 0; j < 4; ++j)
+        {
+            cell[std::size_t(j + 1)] = ids->GetId(j);
+        }
+        out.write(reinterpret_cast<const char*>(cell.data()), sizeof(cell));
+    }
+
+    auto t = std::array<double, 9>{};
+    auto tf = std::array<float, 9>{};
+    for(auto* array : fields)
+    {
+        pad(out, align(uint64_t(out.tellp())));
+        for(auto i = vtkIdType{0}; i < vtkIdType(num_points); ++i)
+        {
+            array->GetTuple(i, t.data());
+            if(single_precision)
+            {
+                std::copy(t.begin(), t.end(), tf.begin());
+                out.write(reinterpret_cast<const char*>(tf.data()),
+                          sizeof(tf));
+            }
+            else
+            {
+                out.write(reinterpret_cast<const char*>(t.data()), sizeof(t));
+            }
+        }
+    }
+
+    if(!out)
+    {
+        throw std::runtime_error("Could not write " + file_name);
+    }
+}
+
+} // namespace tl
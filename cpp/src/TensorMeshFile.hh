@@ -0,0 +1,147 @@
+#ifndef CPP_TENSOR_MESH_FILE_HH
+#define CPP_TENSOR_MESH_FILE_HH
+
+#include <vtkSmartPointer.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class vtkUnstructuredGrid;
+
+/*
+ * Binary tensor mesh format (.tlm)
+ *
+ * A tetrahedral mesh with point tensor fields, laid out so that it can be
+ * memory mapped and used without parsing or copying. All values are stored in
+ * native byte order, every section starts at a multiple of 64 bytes.
+ *
+ *   header        64 bytes, see TensorMeshHeader
+ *   field table   num_fields entries of 64 bytes, see TensorMeshField
+ *   points        num_points * 3 doubles
+ *   cells         num_cells * 5 int64: the point count 4 followed by the point
+ *                 ids of a tetrahedron (VTK's legacy cell array layout)
+ *   fields        num_points * 9 components each, row major tensors as
+ *                 doubles or, with the single precision flag, floats
+ */
+
+namespace tl
+{
+
+// Identifies the file format, increased on incompatible changes
+constexpr char tensor_mesh_magic[8] = {'T', 'L', 'M', 'E', 'S', 'H', '0', '1'};
+// Written as a number to detect files from machines of other byte order
+constexpr uint32_t tensor_mesh_byte_order = 0x01020304;
+// Flag for tensor fields stored as floats
+constexpr uint32_t tensor_mesh_single_precision = 1;
+// Alignment of the sections
+constexpr std::size_t tensor_mesh_alignment = 64;
+
+
+struct TensorMeshHeader
+{
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t flags;
+    uint64_t num_points;
+    uint64_t num_cells;
+    uint64_t num_fields;
+    uint64_t points_offset;
+    uint64_t cells_offset;
+    uint64_t reserved;
+};
+static_assert(sizeof(TensorMeshHeader) == 64, "Unexpected header padding");
+
+
+struct TensorMeshField
+{
+    // Zero terminated name of the field
+    char name[56];
+    uint64_t offset;
+};
+static_assert(sizeof(TensorMeshField) == 64, "Unexpected field padding");
+
+
+/**
+ * Read-only view of the contents of a file, memory mapped where supported.
+ */
+class MappedFile
+{
+public:
+    /**
+     * @brief Map a file into memory.
+     * @throws std::runtime_error if the file can not be opened
+     */
+    explicit MappedFile(const std::string& file_name);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const
+    {
+        return _data;
+    }
+
+    std::size_t size() const
+    {
+        return _size;
+    }
+
+private:
+    char* _data = nullptr;
+    std::size_t _size = 0;
+    // Contents of the file if it could not be mapped
+    std::vector<char> _buffer;
+};
+
+
+/**
+ * A mesh read from a tensor mesh file. The arrays of the grid point into the
+ * mapped file, which must be kept as long as the grid is used.
+ */
+struct TensorMesh
+{
+    std::shared_ptr<const MappedFile> file;
+    vtkSmartPointer<vtkUnstructuredGrid> grid;
+};
+
+
+/**
+ * Check whether a file name has the extension of tensor mesh files (.tlm).
+ */
+bool isTensorMeshFile(const std::string& file_name);
+
+
+/**
+ * @brief Map a tensor mesh file and wrap its sections in VTK arrays without
+ *      copying.
+ * @details All fields are added as point data, the first one is marked as the
+ *      active tensors.
+ *
+ * @param file_name Name of the file
+ * @return The mapped file and the grid using it
+ * @throws std::runtime_error if the file can not be read or is damaged
+ */
+TensorMesh readTensorMesh(const std::string& file_name);
+
+
+/**
+ * @brief Write the tetrahedra of a grid and its tensor point fields (arrays
+ *      with 9 components) to a tensor mesh file.
+ *
+ * @param grid The grid, cells other than tetrahedra are skipped
+ * @param file_name Name of the file
+ * @param single_precision Store the tensors as floats
+ * @throws std::runtime_error if the grid has no tetrahedra or the file can
+ *      not be written
+ */
+void writeTensorMesh(vtkUnstructuredGrid* grid,
+                     const std::string& file_name,
+                     bool single_precision);
+
+} // namespace tl
+
+#endif
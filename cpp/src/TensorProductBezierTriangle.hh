@@ -5,12 +5,18 @@
 
 #include <Eigen/Core>
 
+#include <algorithm>
+#include <array>
+#include <functional>
 #include <type_traits>
 #include <utility>
 #include <stdexcept>
 
 namespace tl
 {
+template <typename T, typename C, std::size_t... Degrees>
+class TensorProductBezierTriangle;
+
 template <std::size_t D, typename T, typename C, std::size_t... Degrees>
 struct TensorProductDerivativeType;
 
@@ -99,6 +105,9 @@ struct TensorProductTraits;
  *          // Compute coefficients of an interpolating polynomial given sampled
  *          // values at the control points.
  *          static Coeffs computeCoeffs(const Coeffs& samples);
+ *
+ *          // Compute the smallest and largest coefficient
+ *          static std::pair<T, T> coeffsRange(const Coeffs& in);
  *      };
  *
  *      ```
@@ -203,6 +212,16 @@ public:
         return _coeffs;
     }
 
+    /**
+     * @brief Get the smallest and the largest coefficient.
+     * @details Uses the branch-free reduction generated for the specialization
+     *      instead of a sequential scan.
+     */
+    std::pair<T, T> range() const
+    {
+        return Derived::coeffsRange(_coeffs);
+    }
+
     /**
      * @brief Split the triangle into four new ones in the given space.
      * @details The triangle A-B-C is split into four new ones numbered
@@ -251,6 +270,27 @@ public:
         }
     }
 
+    /**
+     * @brief Convert the polynomial to different coefficient and coordinate
+     *      types.
+     * @details E.g. `poly.cast<float>()` creates a single precision copy of a
+     *      double precision polynomial.
+     *
+     * @tparam T2 New type of the coefficients
+     * @tparam C2 New type of the coordinates
+     * @return Polynomial of the same degrees with converted coefficients
+     */
+    template <typename T2, typename C2 = T2>
+    TensorProductBezierTriangle<T2, C2, Degrees...> cast() const
+    {
+        auto result = TensorProductBezierTriangle<T2, C2, Degrees...>{};
+        for(auto i: cpp_utils::range(NCoeffs))
+        {
+            result[i] = static_cast<T2>(_coeffs[i]);
+        }
+        return result;
+    }
+
     template <std::size_t D>
     TensorProductDerivativeType_t<D, T, C, Degrees...>
     derivative(std::size_t i) const
@@ -280,12 +320,18 @@ public:
         }
     }
 
+    // Scalar coefficients are scaled in their own precision, e.g. single
+    // precision coefficients by a single precision factor
+    template <typename Scalar>
+    using ScaleFactor =
+            std::conditional_t<std::is_arithmetic<T>::value, T, Scalar>;
+
     template <typename Scalar>
     void operator*=(const Scalar& scalar)
     {
         for(auto& c: _coeffs)
         {
-            c *= scalar;
+            c *= ScaleFactor<Scalar>(scalar);
         }
     }
 
@@ -294,7 +340,7 @@ public:
     {
         for(auto& c: _coeffs)
         {
-            c /= scalar;
+            c /= ScaleFactor<Scalar>(scalar);
         }
     }
 
@@ -390,6 +436,244 @@ class TensorProductBezierTriangle
 {
 };
 
+namespace detail
+{
+/**
+ * Number of Bernstein polynomials of the given degree over a triangle.
+ */
+constexpr std::size_t bernsteinSize(std::size_t degree)
+{
+    return ((degree + 1) * (degree + 2)) / 2;
+}
+
+
+/**
+ * @brief Exponents of the i-th Bernstein polynomial of the given degree.
+ * @details Uses the order of the generated specializations, i.e. the
+ *      multi-indices are sorted lexicographically in descending order.
+ */
+constexpr std::array<std::size_t, 3> bernsteinExponents(std::size_t degree,
+                                                        std::size_t i)
+{
+    for(auto a = degree;; --a)
+    {
+        const auto count = degree - a + 1;
+        if(i < count || a == 0)
+        {
+            return {a, degree - a - i, i};
+        }
+        i -= count;
+    }
+}
+
+
+/**
+ * Position of the Bernstein polynomial with the given exponents among all
+ * Bernstein polynomials of the given degree (inverse of bernsteinExponents).
+ */
+constexpr std::size_t
+bernsteinIndex(std::size_t degree, const std::array<std::size_t, 3>& exponents)
+{
+    auto index = exponents[2];
+    for(auto a = exponents[0] + 1; a <= degree; ++a)
+    {
+        index += degree - a + 1;
+    }
+    return index;
+}
+
+
+/**
+ * Multinomial coefficient degree! / (i! j! k!) for the given exponents.
+ */
+constexpr double multinomial(std::size_t degree,
+                             const std::array<std::size_t, 3>& exponents)
+{
+    auto result = 1.;
+    for(auto n = std::size_t{2}; n <= degree; ++n)
+    {
+        result *= double(n);
+    }
+    for(auto i = std::size_t{0}; i < 3; ++i)
+    {
+        for(auto n = std::size_t{2}; n <= exponents[i]; ++n)
+        {
+            result /= double(n);
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Terms of the product of two tensor products of Bernstein-Bézier
+ *      triangles with the degrees D1 and D2.
+ * @details For every pair of coefficients (i, j) of the factors, stored at
+ *      `i * NB + j`, holds the index of the coefficient of the product it
+ *      contributes to, the weight of the contribution and whether it is the
+ *      first contribution to that coefficient.
+ */
+template <typename D1, typename D2>
+struct BernsteinProductTable;
+
+template <std::size_t... D1, std::size_t... D2>
+struct BernsteinProductTable<std::index_sequence<D1...>,
+                             std::index_sequence<D2...>>
+{
+    static_assert(sizeof...(D1) == sizeof...(D2),
+                  "Factors must have the same number of spaces");
+
+    static constexpr std::size_t NA = (bernsteinSize(D1) * ...);
+    static constexpr std::size_t NB = (bernsteinSize(D2) * ...);
+
+    struct Entry
+    {
+        std::size_t index = 0;
+        double weight = 0;
+        bool first = false;
+    };
+
+    static constexpr std::array<Entry, NA * NB> make()
+    {
+        constexpr auto NSpaces = sizeof...(D1);
+        constexpr auto degrees_a = std::array<std::size_t, NSpaces>{D1...};
+        constexpr auto degrees_b = std::array<std::size_t, NSpaces>{D2...};
+
+        auto table = std::array<Entry, NA * NB>{};
+        auto assigned = std::array<bool, ((bernsteinSize(D1 + D2)) * ...)>{};
+        for(auto i = std::size_t{0}; i < NA; ++i)
+        {
+            for(auto j = std::size_t{0}; j < NB; ++j)
+            {
+                // Combine the multi-indices space by space, the last space
+                // varies fastest in the coefficient arrays
+                auto rest_i = i;
+                auto rest_j = j;
+                auto& entry = table[i * NB + j];
+                auto stride = std::size_t{1};
+                entry.weight = 1.;
+                for(auto s = NSpaces; s-- > 0;)
+                {
+                    const auto m = degrees_a[s];
+                    const auto n = degrees_b[s];
+                    const auto ei =
+                            bernsteinExponents(m, rest_i % bernsteinSize(m));
+                    const auto ej =
+                            bernsteinExponents(n, rest_j % bernsteinSize(n));
+                    rest_i /= bernsteinSize(m);
+                    rest_j /= bernsteinSize(n);
+
+                    const auto ek = std::array<std::size_t, 3>{
+                            ei[0] + ej[0], ei[1] + ej[1], ei[2] + ej[2]};
+                    entry.index += stride * bernsteinIndex(m + n, ek);
+                    stride *= bernsteinSize(m + n);
+                    entry.weight *= multinomial(m, ei) * multinomial(n, ej)
+                                    / multinomial(m + n, ek);
+                }
+                entry.first = !assigned[entry.index];
+                assigned[entry.index] = true;
+            }
+        }
+        return table;
+    }
+};
+} // namespace detail
+
+
+/**
+ * @brief Exact product of two tensor products of Bernstein-Bézier triangles.
+ * @details The product of two Bernstein polynomials of degrees m and n is a
+ *      Bernstein polynomial of degree m+n whose coefficients are
+ *
+ *      \f[
+ *          c_k = \sum_{i+j=k}
+ *              \frac{\binom{m}{i}\binom{n}{j}}{\binom{m+n}{k}} \;
+ *              a_i b_j
+ *      \f]
+ *
+ *      with multinomial coefficients for the multi-indices i, j, k. For
+ *      tensor products this applies to every space separately. Compared to
+ *      sampling the product at the control points and solving for the
+ *      coefficients, no linear system is involved and the coefficients
+ *      carry only the rounding error of the sums.
+ *
+ *      Coefficients of different types are combined with `op`, which has to
+ *      be bilinear, e.g. a matrix-vector or a cross product. A polynomial can
+ *      be lifted into a higher dimensional tensor product by adding a space
+ *      of degree zero, which leaves its coefficients unchanged, e.g.
+ *      `TensorProductBezierTriangle<T, C, 1, 0>{p.coefficients()}` for
+ *      `p` of type `TensorProductBezierTriangle<T, C, 1>`.
+ *
+ * @tparam R Type of the coefficients of the result
+ * @param a First factor
+ * @param b Second factor, must have the same number of spaces as `a`
+ * @param op Bilinear function combining a coefficient of `a` with one of `b`
+ * @return Polynomial of the summed degrees
+ */
+template <typename R,
+          typename T1,
+          typename T2,
+          typename C,
+          std::size_t... D1,
+          std::size_t... D2,
+          typename Op = std::multiplies<>>
+TensorProductBezierTriangle<R, C, (D1 + D2)...>
+product(const TensorProductBezierTriangle<T1, C, D1...>& a,
+        const TensorProductBezierTriangle<T2, C, D2...>& b,
+        Op op = Op{})
+{
+    using Table = detail::BernsteinProductTable<std::index_sequence<D1...>,
+                                                std::index_sequence<D2...>>;
+    static constexpr auto table = Table::make();
+
+    auto result = TensorProductBezierTriangle<R, C, (D1 + D2)...>{};
+    for(auto i: cpp_utils::range(Table::NA))
+    {
+        for(auto j: cpp_utils::range(Table::NB))
+        {
+            const auto& entry = table[i * Table::NB + j];
+            const auto term = R(op(a[i], b[j]) * static_cast<C>(entry.weight));
+            if(entry.first)
+            {
+                result[entry.index] = term;
+            }
+            else
+            {
+                result[entry.index] += term;
+            }
+        }
+    }
+    return result;
+}
+
+
+/**
+ * @brief Apply a linear function to all coefficients of a polynomial.
+ * @details Since the Bernstein basis does not depend on the coefficients, this
+ *      yields the polynomial of the transformed values, e.g. a single
+ *      component of a vector-valued polynomial.
+ *
+ * @tparam R Type of the coefficients of the result
+ * @param poly Polynomial to transform
+ * @param func Linear function mapping a coefficient to R
+ * @return Polynomial of the same degrees with transformed coefficients
+ */
+template <typename R,
+          typename T,
+          typename C,
+          std::size_t... Degrees,
+          typename Function>
+TensorProductBezierTriangle<R, C, Degrees...>
+mapCoefficients(const TensorProductBezierTriangle<T, C, Degrees...>& poly,
+                Function func)
+{
+    auto result = TensorProductBezierTriangle<R, C, Degrees...>{};
+    for(auto i: cpp_utils::range(poly.coefficients().size()))
+    {
+        result[i] = func(poly[i]);
+    }
+    return result;
+}
+
 } // namespace tl
 
 #endif
@@ -2,7 +2,6 @@
 
 #include <Eigen/Geometry>
 
-#include <boost/algorithm/cxx11/any_of.hpp>
 #include <boost/range/algorithm/max_element.hpp>
 #include <boost/range/algorithm/min_element.hpp>
 
@@ -19,150 +18,196 @@ using TPBT = TensorProductBezierTriangle<T, double, Degrees...>;
 
 std::array<TPBT<double, 3, 0>, 7> tensorTopologyCoeffs(const TensorInterp& t)
 {
-    using Coords = TPBT<double, 3, 0>::Coords;
-    // Constraint functions according to Zheng et al. 2004
-
-    auto fx = [&](const Coords& coords) -> double {
-        auto tv = t(coords.head<3>());
-        return tv(0, 0) * ((tv(1, 1) * tv(1, 1) - tv(2, 2) * tv(2, 2))
-                           + (tv(0, 1) * tv(0, 1) - tv(0, 2) * tv(0, 2)))
-               + tv(1, 1) * ((tv(2, 2) * tv(2, 2) - tv(0, 0) * tv(0, 0))
-                             + (tv(1, 2) * tv(1, 2) - tv(0, 1) * tv(0, 1)))
-               + tv(2, 2) * ((tv(0, 0) * tv(0, 0) - tv(1, 1) * tv(1, 1))
-                             + (tv(0, 2) * tv(0, 2) - tv(1, 2) * tv(1, 2)));
+    // The tensor entries are linear, the constraint functions are cubic
+    // polynomials in the entries
+    auto entry = [&](int i, int j) {
+        return mapCoefficients<double>(
+                t, [i, j](const Mat3d& m) { return m(i, j); });
     };
-
-    auto fy1 = [&](const Coords& coords) -> double {
-        auto tv = t(coords.head<3>());
-        return tv(1, 2) * (2 * (tv(1, 2) * tv(1, 2) - tv(0, 0) * tv(0, 0))
-                           - (tv(0, 2) * tv(0, 2) + tv(0, 1) * tv(0, 1))
-                           + 2 * (tv(1, 1) * tv(0, 0) + tv(2, 2) * tv(0, 0)
-                                  - tv(1, 1) * tv(2, 2)))
-               + tv(0, 1) * tv(0, 2) * (2 * tv(0, 0) - tv(2, 2) - tv(1, 1));
+    const auto xx = entry(0, 0);
+    const auto yy = entry(1, 1);
+    const auto zz = entry(2, 2);
+    const auto xy = entry(0, 1);
+    const auto xz = entry(0, 2);
+    const auto yz = entry(1, 2);
+
+    auto mul = [](const auto& a, const auto& b) {
+        return product<double>(a, b);
     };
-
-    auto fy2 = [&](const Coords& coords) -> double {
-        auto tv = t(coords.head<3>());
-        return tv(0, 2) * (2 * (tv(0, 2) * tv(0, 2) - tv(1, 1) * tv(1, 1))
-                           - (tv(0, 1) * tv(0, 1) + tv(1, 2) * tv(1, 2))
-                           + 2 * (tv(2, 2) * tv(1, 1) + tv(0, 0) * tv(1, 1)
-                                  - tv(2, 2) * tv(0, 0)))
-               + tv(1, 2) * tv(0, 1) * (2 * tv(1, 1) - tv(0, 0) - tv(2, 2));
+    auto lift = [](const TPBT<double, 3>& f) {
+        return TPBT<double, 3, 0>{f.coefficients()};
     };
 
-    auto fy3 = [&](const Coords& coords) -> double {
-        auto tv = t(coords.head<3>());
-        return tv(0, 1) * (2 * (tv(0, 1) * tv(0, 1) - tv(2, 2) * tv(2, 2))
-                           - (tv(1, 2) * tv(1, 2) + tv(0, 2) * tv(0, 2))
-                           + 2 * (tv(0, 0) * tv(2, 2) + tv(1, 1) * tv(2, 2)
-                                  - tv(0, 0) * tv(1, 1)))
-               + tv(0, 2) * tv(1, 2) * (2 * tv(2, 2) - tv(1, 1) - tv(0, 0));
-    };
+    // Quadratic terms shared by the constraint functions
+    const auto xx2 = mul(xx, xx);
+    const auto yy2 = mul(yy, yy);
+    const auto zz2 = mul(zz, zz);
+    const auto xy2 = mul(xy, xy);
+    const auto xz2 = mul(xz, xz);
+    const auto yz2 = mul(yz, yz);
+    const auto xxyy = mul(xx, yy);
+    const auto xxzz = mul(xx, zz);
+    const auto yyzz = mul(yy, zz);
+    const auto xyxz = mul(xy, xz);
+    const auto xyyz = mul(xy, yz);
+    const auto xzyz = mul(xz, yz);
 
-    auto fz1 = [&](const Coords& coords) -> double {
-        auto tv = t(coords.head<3>());
-        return tv(1, 2) * (tv(0, 2) * tv(0, 2) - tv(0, 1) * tv(0, 1))
-               + tv(0, 1) * tv(0, 2) * (tv(1, 1) - tv(2, 2));
-    };
+    // Constraint functions according to Zheng et al. 2004
+    const auto fx = mul(xx, (yy2 - zz2) + (xy2 - xz2))
+                    + mul(yy, (zz2 - xx2) + (yz2 - xy2))
+                    + mul(zz, (xx2 - yy2) + (xz2 - yz2));
+
+    const auto fy1 = mul(yz,
+                         2 * (yz2 - xx2) - (xz2 + xy2)
+                                 + 2 * (xxyy + xxzz - yyzz))
+                     + mul(xyxz, 2 * xx - zz - yy);
+
+    const auto fy2 = mul(xz,
+                         2 * (xz2 - yy2) - (xy2 + yz2)
+                                 + 2 * (yyzz + xxyy - xxzz))
+                     + mul(xyyz, 2 * yy - xx - zz);
+
+    const auto fy3 = mul(xy,
+                         2 * (xy2 - zz2) - (yz2 + xz2)
+                                 + 2 * (xxzz + yyzz - xxyy))
+                     + mul(xzyz, 2 * zz - yy - xx);
+
+    const auto fz1 = mul(yz, xz2 - xy2) + mul(xyxz, yy - zz);
+    const auto fz2 = mul(xz, xy2 - yz2) + mul(xyyz, zz - xx);
+    const auto fz3 = mul(xy, yz2 - xz2) + mul(xzyz, xx - yy);
+
+    return {lift(fx),
+            lift(fy1),
+            lift(fy2),
+            lift(fy3),
+            lift(fz1),
+            lift(fz2),
+            lift(fz3)};
+}
 
-    auto fz2 = [&](const Coords& coords) -> double {
-        auto tv = t(coords.head<3>());
-        return tv(0, 2) * (tv(0, 1) * tv(0, 1) - tv(1, 2) * tv(1, 2))
-               + tv(1, 2) * tv(0, 1) * (tv(2, 2) - tv(0, 0));
-    };
 
-    auto fz3 = [&](const Coords& coords) -> double {
-        auto tv = t(coords.head<3>());
-        return tv(0, 1) * (tv(1, 2) * tv(1, 2) - tv(0, 2) * tv(0, 2))
-               + tv(0, 2) * tv(1, 2) * (tv(0, 0) - tv(1, 1));
-    };
+namespace
+{
+template <typename Real>
+using TargetFuncs =
+        std::array<TensorProductBezierTriangle<Real, Real, 3, 0>, 7>;
+using FuncRanges = std::array<std::pair<double, double>, 7>;
+
+// The subdivision kernels are compiled for several instruction sets with
+// runtime dispatch (see TL_TARGET_CLONES). This requires non-template
+// functions, hence the overloads for each coefficient type.
+
+TL_TARGET_CLONES
+TargetFuncs<double> splitFuncs(const TargetFuncs<double>& funcs,
+                               std::size_t part,
+                               FuncRanges& ranges)
+{
+    return split_all<0>(funcs, part, ranges);
+}
 
-    return {TPBT<double, 3, 0>{fx},
-            TPBT<double, 3, 0>{fy1},
-            TPBT<double, 3, 0>{fy2},
-            TPBT<double, 3, 0>{fy3},
-            TPBT<double, 3, 0>{fz1},
-            TPBT<double, 3, 0>{fz2},
-            TPBT<double, 3, 0>{fz3}};
+
+TL_TARGET_CLONES
+TargetFuncs<float> splitFuncs(const TargetFuncs<float>& funcs,
+                              std::size_t part,
+                              FuncRanges& ranges)
+{
+    return split_all<0>(funcs, part, ranges);
 }
+} // namespace
 
 
-using TSHE = TensorTopologyEvaluator;
+template <typename Real>
+using TSHE = BasicTensorTopologyEvaluator<Real>;
 
-TSHE::TensorTopologyEvaluator(const DoubleTri& tri,
-                              const TensorInterp& t,
-                              const Options& opts)
-        : _tri(tri), _target_funcs(tensorTopologyCoeffs(t)), _opts(opts)
+template <typename Real>
+BasicTensorTopologyEvaluator<Real>::BasicTensorTopologyEvaluator(
+        const DoubleTri& tri,
+        const TensorInterp& t,
+        const Options& opts)
+        : _tri(tri),
+          _target_funcs(cast_all<Real>(tensorTopologyCoeffs(t))),
+          _ranges(bernstein_ranges(_target_funcs)),
+          _opts(opts)
 {
 }
 
 
-std::array<TSHE, 4> TSHE::split() const
+template <typename Real>
+std::array<TSHE<Real>, 4> BasicTensorTopologyEvaluator<Real>::split() const
 {
-    auto part = [&](std::size_t i) {
-        return TensorTopologyEvaluator(_tri.split<0>(i),
-                                       {_target_funcs[0].split<0>(i),
-                                        _target_funcs[1].split<0>(i),
-                                        _target_funcs[2].split<0>(i),
-                                        _target_funcs[3].split<0>(i),
-                                        _target_funcs[4].split<0>(i),
-                                        _target_funcs[5].split<0>(i),
-                                        _target_funcs[6].split<0>(i)},
-                                       _split_level + 1,
-                                       _opts);
-    };
-    return {part(0), part(1), part(2), part(3)};
+    return {split(0), split(1), split(2), split(3)};
 }
 
 
-Result TSHE::eval()
+template <typename Real>
+TSHE<Real> BasicTensorTopologyEvaluator<Real>::split(std::size_t part) const
 {
+    auto ranges = FuncRanges{};
+    auto funcs = splitFuncs(_target_funcs, part, ranges);
+    return Self(_tri.split<0>(part), funcs, ranges, _split_level + 1, _opts);
+}
+
+
+template <typename Real>
+Result BasicTensorTopologyEvaluator<Real>::eval()
+{
+    // Coefficients computed in reduced precision are only trusted up to the
+    // rounding error accumulated during subdivision, plus the error they
+    // carried when the evaluator was created
+    auto rounding_error = _opts.rounding_error * double(_split_level + 1)
+                          + _opts.coefficient_error;
+
     // Check if any of the error components can not become zero in the
-    // current subdivision triangles
-    auto has_nonzero =
-            boost::algorithm::any_of(_target_funcs, [](const auto& c) {
-                return sameSign(c.coefficients()) != 0;
-            });
+    // current subdivision triangles and compute upper bound for target
+    // functions from the Bernstein ranges computed during the split
+    auto range = range_bound(_ranges, rounding_error);
 
     // Discard triangles if no roots can occur inside
-    if(has_nonzero)
+    if(!range.has_root)
     {
         return Result::Discard;
     }
 
-    // Compute upper bound for target functions
-    auto max_error = abs_max_upper_bound(_target_funcs);
+    if(range.abs_max < _opts.tolerance + rounding_error)
+    {
+        return _opts.rounding_error > 0 ? Result::Promote : Result::Accept;
+    }
+
+    if(range.ambiguous)
+    {
+        return Result::Promote;
+    }
 
-    if(max_error < _opts.tolerance)
+    // Discard triangles if two error components can not become zero at the
+    // same position
+    switch(pairwise_exclusion(_target_funcs, rounding_error))
     {
-        return Result::Accept;
+    case Exclusion::Excluded:
+        return Result::Discard;
+    case Exclusion::Ambiguous:
+        return Result::Promote;
+    case Exclusion::Possible:
+        break;
     }
 
     return Result::Split;
 }
 
 
-double TSHE::error() const
+template <typename Real>
+double BasicTensorTopologyEvaluator<Real>::error() const
 {
     return upper_bound_norm(_target_funcs);
 }
 
 
-double distance(const TSHE& t1, const TSHE& t2)
-{
-    return distance(t1.tris(), t2.tris());
-}
-
-
-bool operator==(const TSHE& t1, const TSHE& t2)
+template <typename Real>
+double BasicTensorTopologyEvaluator<Real>::coefficientBound() const
 {
-    return t1._tri == t2._tri && t1._target_funcs == t2._target_funcs
-           && t1._split_level == t2._split_level && t1._opts == t2._opts;
+    return abs_max_upper_bound(_target_funcs);
 }
 
 
-bool operator!=(const TSHE& t1, const TSHE& t2)
-{
-    return !(t1 == t2);
-}
+template class BasicTensorTopologyEvaluator<double>;
+template class BasicTensorTopologyEvaluator<float>;
 }
@@ -7,21 +7,41 @@
 
 namespace tl
 {
-class TensorTopologyEvaluator
+/**
+ * Evaluator for degenerate points of the tensor field.
+ *
+ * @tparam Real Type of the coefficients of the target functions
+ */
+template <typename Real>
+class BasicTensorTopologyEvaluator
 {
-    using Self = TensorTopologyEvaluator;
+    using Self = BasicTensorTopologyEvaluator<Real>;
     template <typename T, std::size_t... Degrees>
-    using TPBT = TensorProductBezierTriangle<T, double, Degrees...>;
+    using TPBT = TensorProductBezierTriangle<T, Real, Degrees...>;
 
 public:
+    /// Type of the coefficients of the target functions
+    using Scalar = Real;
 
     struct Options
     {
         double tolerance = 1e-6;
+        /// Bound for the absolute rounding error of the coefficients that is
+        /// introduced per subdivision level. Must be set for single precision
+        /// evaluators, which return Result::Promote instead of deciding
+        /// within this bound.
+        double rounding_error = 0.;
+        /// Bound for the absolute error the coefficients already carry when
+        /// the evaluator is created, e.g. by conversion from a single
+        /// precision evaluator. It does not grow with further splits, and
+        /// triangles are accepted within this bound of the tolerance.
+        double coefficient_error = 0.;
 
         friend bool operator==(const Options& o1, const Options& o2)
         {
-            return o1.tolerance == o2.tolerance;
+            return o1.tolerance == o2.tolerance
+                   && o1.rounding_error == o2.rounding_error
+                   && o1.coefficient_error == o2.coefficient_error;
         }
 
         friend bool operator!=(const Options& o1, const Options& o2)
@@ -30,20 +50,37 @@ public:
         }
     };
 
-    TensorTopologyEvaluator() = default;
+    BasicTensorTopologyEvaluator() = default;
 
-    TensorTopologyEvaluator(const DoubleTri& tri,
-                            const TensorInterp& t,
-                            const Options& opts);
+    BasicTensorTopologyEvaluator(const DoubleTri& tri,
+                                 const TensorInterp& t,
+                                 const Options& opts);
 
-    TensorTopologyEvaluator(
+    BasicTensorTopologyEvaluator(
             const DoubleTri& tri,
-            const std::array<TPBT<double, 3, 0>, 7>& target_funcs,
+            const std::array<TPBT<Real, 3, 0>, 7>& target_funcs,
             uint64_t split_level,
             const Options& opts)
-            : _tri(tri),
-              _target_funcs(target_funcs),
-              _split_level(split_level),
+            : BasicTensorTopologyEvaluator(tri,
+                                           target_funcs,
+                                           bernstein_ranges(target_funcs),
+                                           split_level,
+                                           opts)
+    {
+    }
+
+    /**
+     * Create an evaluator with a different coefficient type from another one
+     * by converting the coefficients.
+     */
+    template <typename Other>
+    BasicTensorTopologyEvaluator(
+            const BasicTensorTopologyEvaluator<Other>& other,
+            const Options& opts)
+            : _tri(other.tris()),
+              _target_funcs(cast_all<Real>(other.targetFunctions())),
+              _ranges(bernstein_ranges(_target_funcs)),
+              _split_level(other.splitLevel()),
               _opts(opts)
     {
     }
@@ -62,6 +99,19 @@ public:
      */
     std::array<Self, 4> split() const;
 
+    /**
+     * Equivalent to `split()[part]`
+     */
+    Self split(std::size_t part) const;
+
+    /**
+     * Get the target functions
+     */
+    const std::array<TPBT<Real, 3, 0>, 7>& targetFunctions() const
+    {
+        return _target_funcs;
+    }
+
     /**
      * Get the current subdivision level
      */
@@ -76,7 +126,11 @@ public:
      *          solution is within tolerances of tolerance; returns
      *          Result::Discard if no solution can be found by subdividing
      *          further, and returns Result::Split if further subdivision is
-     *          necessary to find a solution.
+     *          necessary to find a solution. If the coefficients carry a
+     *          rounding error (see Options::rounding_error), returns
+     *          Result::Promote if the decision can not be made reliably. A
+     *          coefficient error (see Options::coefficient_error) widens the
+     *          same bounds, but triangles within it are accepted.
      */
     Result eval();
 
@@ -85,6 +139,12 @@ public:
      */
     double error() const;
 
+    /**
+     * Get the largest absolute value of all coefficients, which bounds the
+     * target functions on all subdivisions of the evaluator
+     */
+    double coefficientBound() const;
+
     /**
      * Get an estimate of the condition of the problem.
      *
@@ -93,26 +153,60 @@ public:
      */
     double condition() const;
 
-    friend bool operator==(const Self& t1, const Self& t2);
+    friend bool operator==(const Self& t1, const Self& t2)
+    {
+        return t1._tri == t2._tri && t1._target_funcs == t2._target_funcs
+               && t1._split_level == t2._split_level && t1._opts == t2._opts;
+    }
 
-    friend bool operator!=(const Self& t1, const Self& t2);
+    friend bool operator!=(const Self& t1, const Self& t2)
+    {
+        return !(t1 == t2);
+    }
 
 private:
     DoubleTri _tri = DoubleTri{};
 
-    std::array<TPBT<double, 3, 0>, 7> _target_funcs =
-            std::array<TPBT<double, 3, 0>, 7>{};
+    std::array<TPBT<Real, 3, 0>, 7> _target_funcs =
+            std::array<TPBT<Real, 3, 0>, 7>{};
+
+    // Bernstein ranges of the target functions, computed together with the
+    // coefficients
+    std::array<std::pair<double, double>, 7> _ranges =
+            std::array<std::pair<double, double>, 7>{};
 
     uint64_t _split_level = 0;
 
     Options _opts = Options{};
+
+    BasicTensorTopologyEvaluator(
+            const DoubleTri& tri,
+            const std::array<TPBT<Real, 3, 0>, 7>& target_funcs,
+            const std::array<std::pair<double, double>, 7>& ranges,
+            uint64_t split_level,
+            const Options& opts)
+            : _tri(tri),
+              _target_funcs(target_funcs),
+              _ranges(ranges),
+              _split_level(split_level),
+              _opts(opts)
+    {
+    }
 };
 
-double distance(const TensorTopologyEvaluator& t1,
-                const TensorTopologyEvaluator& t2);
+template <typename Real>
+double distance(const BasicTensorTopologyEvaluator<Real>& t1,
+                const BasicTensorTopologyEvaluator<Real>& t2)
+{
+    return distance(t1.tris(), t2.tris());
+}
+
+using TensorTopologyEvaluator = BasicTensorTopologyEvaluator<double>;
 
 static_assert(is_evaluator<TensorTopologyEvaluator>::value,
               "TensorTopologyEvaluator is not a valid evaluator!");
+static_assert(is_evaluator<BasicTensorTopologyEvaluator<float>>::value,
+              "BasicTensorTopologyEvaluator<float> is not a valid evaluator!");
 }
 
 #endif
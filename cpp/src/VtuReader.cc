@@ -0,0 +1,819 @@
+#include "VtuReader.hh"
+
+#include "TensorMeshFile.hh"
+
+#include <vtkAppendFilter.h>
+#include <vtkCellArray.h>
+#include <vtkDataArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkUnstructuredGrid.h>
+#include <vtkXMLUnstructuredGridReader.h>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/optional.hpp>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+using namespace tl;
+
+/// Array stored in the appended data section
+struct AppendedArray
+{
+    std::string name;
+    std::string type;
+    uint64_t num_components = 1;
+    uint64_t offset = 0;
+};
+
+
+struct Piece
+{
+    uint64_t num_points = 0;
+    uint64_t num_cells = 0;
+    boost::optional<AppendedArray> points;
+    boost::optional<AppendedArray> connectivity;
+    boost::optional<AppendedArray> offsets;
+    boost::optional<AppendedArray> types;
+    // Point data arrays with 9 components
+    std::vector<AppendedArray> tensors;
+    std::string active_tensors;
+};
+
+
+/// Structure of a file with appended raw data
+struct Layout
+{
+    bool uint64_headers = false;
+    bool compressed = false;
+    std::vector<Piece> pieces;
+    std::size_t appended_start = 0;
+};
+
+
+std::size_t typeSize(const std::string& type)
+{
+    if(type == "Int8" || type == "UInt8")
+    {
+        return 1;
+    }
+    if(type == "Int16" || type == "UInt16")
+    {
+        return 2;
+    }
+    if(type == "Int32" || type == "UInt32" || type == "Float32")
+    {
+        return 4;
+    }
+    if(type == "Int64" || type == "UInt64" || type == "Float64")
+    {
+        return 8;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Parse the XML header of an unstructured grid file.
+ * @return The layout of the arrays or none if the file does not store all
+ *      required arrays as raw appended data in native byte order
+ */
+boost::optional<Layout> parseLayout(const MappedFile& file)
+{
+    auto layout = Layout{};
+    auto open = std::vector<std::string>{};
+    auto pos = std::size_t{0};
+    auto found_appended = false;
+    while(auto tag = detail::nextTag(file.data(), file.size(), pos))
+    {
+        if(tag->closing)
+        {
+            if(!open.empty() && open.back() == tag->name)
+            {
+                open.pop_back();
+            }
+            continue;
+        }
+        const auto parent = open.empty() ? std::string{} : open.back();
+
+        if(tag->name == "VTKFile")
+        {
+            const auto one = uint16_t{1};
+            const auto little = *reinterpret_cast<const uint8_t*>(&one) == 1;
+            const auto order = tag->attribute("byte_order", "LittleEndian");
+            const auto compressor = tag->attribute("compressor");
+            const auto header_type = tag->attribute("header_type", "UInt32");
+            if(tag->attribute("type") != "UnstructuredGrid"
+               || order != (little ? "LittleEndian" : "BigEndian")
+               || (header_type != "UInt32" && header_type != "UInt64")
+               || (!compressor.empty()
+                   && compressor != "vtkZLibDataCompressor"))
+            {
+                return boost::none;
+            }
+            layout.uint64_headers = header_type == "UInt64";
+            layout.compressed = !compressor.empty();
+        }
+        else if(tag->name == "Piece" && parent == "UnstructuredGrid")
+        {
+            auto piece = Piece{};
+            try
+            {
+                piece.num_points =
+                        std::stoull(tag->attribute("NumberOfPoints"));
+                piece.num_cells = std::stoull(tag->attribute("NumberOfCells"));
+            }
+            catch(std::exception&)
+            {
+                return boost::none;
+            }
+            layout.pieces.push_back(piece);
+        }
+        else if(tag->name == "PointData" && !layout.pieces.empty())
+        {
+            layout.pieces.back().active_tensors = tag->attribute("Tensors");
+        }
+        else if(tag->name == "DataArray"
+                && (parent == "Points" || parent == "Cells"
+                    || parent == "PointData"))
+        {
+            if(layout.pieces.empty()
+               || tag->attribute("format") != "appended")
+            {
+                return boost::none;
+            }
+            auto array = AppendedArray{};
+            array.name = tag->attribute("Name");
+            array.type = tag->attribute("type");
+            try
+            {
+                array.num_components =
+                        std::stoull(tag->attribute("NumberOfComponents", "1"));
+                array.offset = std::stoull(tag->attribute("offset"));
+            }
+            catch(std::exception&)
+            {
+                return boost::none;
+            }
+
+            auto& piece = layout.pieces.back();
+            if(parent == "Points")
+            {
+                piece.points = array;
+            }
+            else if(parent == "Cells" && array.name == "connectivity")
+            {
+                piece.connectivity = array;
+            }
+            else if(parent == "Cells" && array.name == "offsets")
+            {
+                piece.offsets = array;
+            }
+            else if(parent == "Cells" && array.name == "types")
+            {
+                piece.types = array;
+            }
+            else if(parent == "PointData" && array.num_components == 9
+                    && (array.type == "Float32" || array.type == "Float64"))
+            {
+                piece.tensors.push_back(array);
+            }
+        }
+        else if(tag->name == "AppendedData")
+        {
+            if(tag->attribute("encoding") != "raw")
+            {
+                return boost::none;
+            }
+            // The data starts behind an underscore
+            const auto* start = static_cast<const char*>(std::memchr(
+                    file.data() + pos, '_', file.size() - pos));
+            if(!start)
+            {
+                return boost::none;
+            }
+            layout.appended_start = std::size_t(start - file.data()) + 1;
+            found_appended = true;
+            break;
+        }
+
+        if(!tag->self_closing)
+        {
+            open.push_back(tag->name);
+        }
+    }
+
+    if(!found_appended || layout.pieces.empty())
+    {
+        return boost::none;
+    }
+    for(const auto& piece : layout.pieces)
+    {
+        if(!piece.points || !piece.connectivity || !piece.offsets
+           || !piece.types || piece.points->num_components != 3
+           || (piece.points->type != "Float32"
+               && piece.points->type != "Float64")
+           || piece.types->type != "UInt8"
+           || typeSize(piece.connectivity->type) < 4
+           || typeSize(piece.offsets->type) < 4
+           || piece.connectivity->type.find("Float") != std::string::npos
+           || piece.offsets->type.find("Float") != std::string::npos)
+        {
+            return boost::none;
+        }
+    }
+    return layout;
+}
+
+
+/// Part of an array that is decoded by one thread
+struct Block
+{
+    const char* source;
+    uint64_t source_size;
+    char* dest;
+    uint64_t dest_size;
+    bool compressed;
+};
+
+
+/**
+ * @brief Split an appended array into blocks that can be decoded in parallel.
+ *
+ * @param file The mapped file
+ * @param layout Layout of the file
+ * @param array The array
+ * @param dest Memory for the decoded array
+ * @param size Expected size of the decoded array in bytes
+ * @param blocks Receives the blocks
+ * @return false if the array does not fit the file or has another size
+ */
+bool appendedBlocks(const MappedFile& file,
+                    const Layout& layout,
+                    const AppendedArray& array,
+                    char* dest,
+                    uint64_t size,
+                    std::vector<Block>& blocks)
+{
+    const auto header_size = layout.uint64_headers ? 8u : 4u;
+    auto pos = uint64_t(layout.appended_start) + array.offset;
+    auto read_header = [&](uint64_t& value) {
+        if(pos > file.size() || file.size() - pos < header_size)
+        {
+            return false;
+        }
+        if(layout.uint64_headers)
+        {
+            std::memcpy(&value, file.data() + pos, 8);
+        }
+        else
+        {
+            auto value32 = uint32_t{};
+            std::memcpy(&value32, file.data() + pos, 4);
+            value = value32;
+        }
+        pos += header_size;
+        return true;
+    };
+
+    if(!layout.compressed)
+    {
+        auto num_bytes = uint64_t{};
+        if(!read_header(num_bytes) || num_bytes != size
+           || file.size() - pos < num_bytes)
+        {
+            return false;
+        }
+        // Large arrays are copied in chunks by several threads
+        constexpr auto chunk = uint64_t{1} << 24;
+        for(auto begin = uint64_t{0}; begin < num_bytes; begin += chunk)
+        {
+            const auto n = std::min(chunk, num_bytes - begin);
+            blocks.push_back(
+                    {file.data() + pos + begin, n, dest + begin, n, false});
+        }
+        return true;
+    }
+
+    // Compressed arrays start with the number of blocks, the uncompressed
+    // size of the blocks and of the last block, and the compressed sizes
+    auto num_blocks = uint64_t{};
+    auto block_size = uint64_t{};
+    auto last_size = uint64_t{};
+    if(!read_header(num_blocks) || !read_header(block_size)
+       || !read_header(last_size)
+       || num_blocks > (file.size() - pos) / header_size)
+    {
+        return false;
+    }
+    if(num_blocks == 0)
+    {
+        if(size != 0)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        // Bound the sizes before computing the total, so that damaged headers
+        // can not overflow it. The block size may exceed the size of a
+        // single block array, since VTK stores the nominal block size.
+        if(block_size == 0 || last_size > block_size
+           || num_blocks > size / block_size + 1)
+        {
+            return false;
+        }
+        const auto total = (num_blocks - 1) * block_size
+                           + (last_size ? last_size : block_size);
+        if(total != size)
+        {
+            return false;
+        }
+    }
+    auto compressed_sizes = std::vector<uint64_t>(num_blocks);
+    for(auto& s : compressed_sizes)
+    {
+        read_header(s);
+    }
+    for(auto b = uint64_t{0}; b < num_blocks; ++b)
+    {
+        if(file.size() - pos < compressed_sizes[b])
+        {
+            return false;
+        }
+        const auto n = b + 1 == num_blocks && last_size ? last_size
+                                                        : block_size;
+        blocks.push_back({file.data() + pos,
+                          compressed_sizes[b],
+                          dest + b * block_size,
+                          n,
+                          true});
+        pos += compressed_sizes[b];
+    }
+    return true;
+}
+
+
+/**
+ * Decode the blocks in parallel.
+ * @return false if a block could not be decompressed
+ */
+bool decodeBlocks(const std::vector<Block>& blocks)
+{
+    auto ok = true;
+#pragma omp parallel for schedule(dynamic) reduction(&& : ok)
+    for(auto i = std::size_t{0}; i < blocks.size(); ++i)
+    {
+        const auto& block = blocks[i];
+        if(block.compressed)
+        {
+            auto dest_size = uLongf(block.dest_size);
+            const auto decoded =
+                    ::uncompress(reinterpret_cast<Bytef*>(block.dest),
+                                 &dest_size,
+                                 reinterpret_cast<const Bytef*>(block.source),
+                                 uLong(block.source_size))
+                            == Z_OK
+                    && dest_size == block.dest_size;
+            // A later block of the same thread must not hide a failure
+            ok = ok && decoded;
+        }
+        else
+        {
+            std::memcpy(block.dest, block.source, block.dest_size);
+        }
+    }
+    return ok;
+}
+
+
+/**
+ * Convert a decoded integer array to 64 bit values.
+ */
+std::vector<int64_t> toInt64(const std::vector<char>& data,
+                             const std::string& type)
+{
+    const auto size = typeSize(type);
+    auto result = std::vector<int64_t>(data.size() / size);
+    auto convert = [&](auto value) {
+        for(auto i = std::size_t{0}; i < result.size(); ++i)
+        {
+            std::memcpy(&value, data.data() + i * size, size);
+            result[i] = int64_t(value);
+        }
+    };
+    if(type == "Int32")
+    {
+        convert(int32_t{});
+    }
+    else if(type == "UInt32")
+    {
+        convert(uint32_t{});
+    }
+    else if(type == "Int64")
+    {
+        convert(int64_t{});
+    }
+    else
+    {
+        convert(uint64_t{});
+    }
+    return result;
+}
+
+
+vtkSmartPointer<vtkDataArray> newFloatArray(const std::string& type)
+{
+    if(type == "Float32")
+    {
+        return vtkSmartPointer<vtkFloatArray>::New();
+    }
+    return vtkSmartPointer<vtkDoubleArray>::New();
+}
+
+
+vtkSmartPointer<vtkUnstructuredGrid> readWithVtk(const std::string& file_name)
+{
+    auto reader = vtkSmartPointer<vtkXMLUnstructuredGridReader>::New();
+    reader->SetFileName(file_name.c_str());
+    reader->Update();
+    return reader->GetOutput();
+}
+
+
+vtkSmartPointer<vtkUnstructuredGrid> appendGrids(
+        const std::vector<vtkSmartPointer<vtkUnstructuredGrid>>& grids)
+{
+    if(grids.size() == 1)
+    {
+        return grids.front();
+    }
+    // Pieces share the points on their boundaries, which must be merged so
+    // that the faces between the pieces are searched once and the lines
+    // connect across them
+    auto append = vtkSmartPointer<vtkAppendFilter>::New();
+    append->MergePointsOn();
+    for(const auto& grid : grids)
+    {
+        append->AddInputData(grid);
+    }
+    append->Update();
+    return append->GetOutput();
+}
+} // namespace
+
+
+namespace tl
+{
+
+namespace detail
+{
+boost::optional<XmlTag> nextTag(const char* data,
+                                std::size_t size,
+                                std::size_t& pos)
+{
+    auto find = [&](char c) {
+        const auto* found = pos < size ? static_cast<const char*>(
+                                                 std::memchr(data + pos,
+                                                             c,
+                                                             size - pos))
+                                       : nullptr;
+        return found ? std::size_t(found - data) : size;
+    };
+    auto is_space = [&]() {
+        return std::isspace(static_cast<unsigned char>(data[pos])) != 0;
+    };
+    auto skip_space = [&]() {
+        while(pos < size && is_space())
+        {
+            ++pos;
+        }
+    };
+
+    while(true)
+    {
+        pos = find('<');
+        if(pos + 1 >= size)
+        {
+            return boost::none;
+        }
+        ++pos;
+        if(data[pos] != '?' && data[pos] != '!')
+        {
+            break;
+        }
+        pos = find('>');
+    }
+
+    auto tag = XmlTag{};
+    if(data[pos] == '/')
+    {
+        tag.closing = true;
+        ++pos;
+    }
+    auto start = pos;
+    while(pos < size && !is_space() && data[pos] != '>' && data[pos] != '/')
+    {
+        ++pos;
+    }
+    tag.name.assign(data + start, pos - start);
+
+    while(true)
+    {
+        skip_space();
+        if(pos >= size)
+        {
+            return boost::none;
+        }
+        if(data[pos] == '>')
+        {
+            ++pos;
+            return tag;
+        }
+        if(data[pos] == '/')
+        {
+            tag.self_closing = true;
+            ++pos;
+            continue;
+        }
+
+        start = pos;
+        while(pos < size && !is_space() && data[pos] != '='
+              && data[pos] != '>')
+        {
+            ++pos;
+        }
+        auto key = std::string(data + start, pos - start);
+        skip_space();
+        if(pos >= size || data[pos] != '=')
+        {
+            return boost::none;
+        }
+        ++pos;
+        skip_space();
+        if(pos >= size || (data[pos] != '"' && data[pos] != '\''))
+        {
+            return boost::none;
+        }
+        const auto quote = data[pos++];
+        start = pos;
+        pos = find(quote);
+        if(pos >= size)
+        {
+            return boost::none;
+        }
+        tag.attributes[key] = std::string(data + start, pos - start);
+        ++pos;
+    }
+}
+} // namespace detail
+
+
+bool isVtuFile(const std::string& file_name)
+{
+    return boost::iends_with(file_name, ".vtu");
+}
+
+
+bool isPvtuFile(const std::string& file_name)
+{
+    return boost::iends_with(file_name, ".pvtu");
+}
+
+
+vtkSmartPointer<vtkUnstructuredGrid> readVtu(const std::string& file_name)
+{
+    auto file = MappedFile{file_name};
+    auto layout = parseLayout(file);
+    if(!layout)
+    {
+        return readWithVtk(file_name);
+    }
+    const auto damaged = std::runtime_error(file_name
+                                            + " has invalid appended data");
+
+    // Allocate all arrays, then decode the blocks of all pieces together
+    auto grids = std::vector<vtkSmartPointer<vtkUnstructuredGrid>>{};
+    auto connectivity = std::vector<std::vector<char>>{};
+    auto offsets = std::vector<std::vector<char>>{};
+    auto types = std::vector<std::vector<char>>{};
+    auto blocks = std::vector<Block>{};
+    for(const auto& piece : layout->pieces)
+    {
+        auto grid = vtkSmartPointer<vtkUnstructuredGrid>::New();
+
+        auto point_coords = newFloatArray(piece.points->type);
+        point_coords->SetNumberOfComponents(3);
+        point_coords->SetNumberOfTuples(vtkIdType(piece.num_points));
+        auto points = vtkSmartPointer<vtkPoints>::New();
+        points->SetData(point_coords);
+        grid->SetPoints(points);
+
+        auto ok = appendedBlocks(
+                file,
+                *layout,
+                *piece.points,
+                static_cast<char*>(point_coords->GetVoidPointer(0)),
+                piece.num_points * 3 * typeSize(piece.points->type),
+                blocks);
+
+        for(const auto& array : piece.tensors)
+        {
+            auto tensors = newFloatArray(array.type);
+            tensors->SetName(array.name.c_str());
+            tensors->SetNumberOfComponents(9);
+            tensors->SetNumberOfTuples(vtkIdType(piece.num_points));
+            if(array.name == piece.active_tensors)
+            {
+                grid->GetPointData()->SetTensors(tensors);
+            }
+            else
+            {
+                grid->GetPointData()->AddArray(tensors);
+            }
+            ok = ok
+                 && appendedBlocks(
+                         file,
+                         *layout,
+                         array,
+                         static_cast<char*>(tensors->GetVoidPointer(0)),
+                         piece.num_points * 9 * typeSize(array.type),
+                         blocks);
+        }
+
+        // The size of the connectivity is only known from the offsets, so it
+        // is taken from the header of the array
+        offsets.emplace_back(piece.num_cells * typeSize(piece.offsets->type));
+        types.emplace_back(piece.num_cells);
+        ok = ok
+             && appendedBlocks(file,
+                               *layout,
+                               *piece.offsets,
+                               offsets.back().data(),
+                               offsets.back().size(),
+                               blocks)
+             && appendedBlocks(file,
+                               *layout,
+                               *piece.types,
+                               types.back().data(),
+                               types.back().size(),
+                               blocks);
+        if(!ok)
+        {
+            throw damaged;
+        }
+        grids.push_back(grid);
+    }
+    if(!decodeBlocks(blocks))
+    {
+        throw damaged;
+    }
+
+    // With the offsets known, decode the connectivity
+    blocks.clear();
+    auto cell_offsets = std::vector<std::vector<int64_t>>{};
+    for(auto p = std::size_t{0}; p < grids.size(); ++p)
+    {
+        const auto& piece = layout->pieces[p];
+        cell_offsets.push_back(toInt64(offsets[p], piece.offsets->type));
+        const auto num_ids =
+                piece.num_cells > 0 ? cell_offsets.back().back() : 0;
+        if(num_ids < 0)
+        {
+            throw damaged;
+        }
+        connectivity.emplace_back(uint64_t(num_ids)
+                                  * typeSize(piece.connectivity->type));
+        if(!appendedBlocks(file,
+                           *layout,
+                           *piece.connectivity,
+                           connectivity.back().data(),
+                           connectivity.back().size(),
+                           blocks))
+        {
+            throw damaged;
+        }
+    }
+    if(!decodeBlocks(blocks))
+    {
+        throw damaged;
+    }
+
+    for(auto p = std::size_t{0}; p < grids.size(); ++p)
+    {
+        const auto& piece = layout->pieces[p];
+        const auto ids = toInt64(connectivity[p], piece.connectivity->type);
+        const auto& ends = cell_offsets[p];
+        const auto num_cells = piece.num_cells;
+
+        // Check the offsets before the parallel loop, which writes each cell
+        // at the position given by its offsets
+        auto previous = int64_t{0};
+        for(auto end : ends)
+        {
+            if(end < previous)
+            {
+                throw damaged;
+            }
+            previous = end;
+        }
+        if(previous > int64_t(ids.size()))
+        {
+            throw damaged;
+        }
+
+        // VTK's legacy layout stores the point count before the ids of each
+        // cell
+        auto legacy = vtkSmartPointer<vtkIdTypeArray>::New();
+        legacy->SetNumberOfValues(vtkIdType(ids.size() + num_cells));
+        auto* legacy_ids = legacy->GetPointer(0);
+        auto valid = true;
+#pragma omp parallel for reduction(&& : valid)
+        for(auto c = int64_t{0}; c < int64_t(num_cells); ++c)
+        {
+            const auto begin = c == 0 ? int64_t{0} : ends[std::size_t(c - 1)];
+            const auto end = ends[std::size_t(c)];
+            auto* out = legacy_ids + begin + c;
+            *out++ = vtkIdType(end - begin);
+            for(auto i = begin; i < end; ++i)
+            {
+                const auto id = ids[std::size_t(i)];
+                valid = valid && id >= 0 && uint64_t(id) < piece.num_points;
+                *out++ = vtkIdType(id);
+            }
+        }
+        if(!valid)
+        {
+            throw damaged;
+        }
+
+        auto cells = vtkSmartPointer<vtkCellArray>::New();
+        cells->SetCells(vtkIdType(num_cells), legacy);
+        auto cell_types = std::vector<int>(types[p].begin(), types[p].end());
+        grids[p]->SetCells(cell_types.data(), cells);
+    }
+
+    return appendGrids(grids);
+}
+
+
+std::vector<std::string> pvtuPieces(const std::string& file_name)
+{
+    auto file = MappedFile{file_name};
+    auto directory = std::string{};
+    const auto slash = file_name.find_last_of("/\\");
+    if(slash != std::string::npos)
+    {
+        directory = file_name.substr(0, slash + 1);
+    }
+
+    auto sources = std::vector<std::string>{};
+    auto pos = std::size_t{0};
+    while(auto tag = detail::nextTag(file.data(), file.size(), pos))
+    {
+        if(!tag->closing && tag->name == "Piece")
+        {
+            auto source = tag->attribute("Source");
+            if(source.empty())
+            {
+                continue;
+            }
+            if(source.front() != '/')
+            {
+                source = directory + source;
+            }
+            sources.push_back(source);
+        }
+    }
+    if(sources.empty())
+    {
+        throw std::runtime_error(file_name + " does not list any pieces");
+    }
+    return sources;
+}
+
+
+vtkSmartPointer<vtkUnstructuredGrid> readPvtu(const std::string& file_name)
+{
+    auto grids = std::vector<vtkSmartPointer<vtkUnstructuredGrid>>{};
+    for(const auto& source : pvtuPieces(file_name))
+    {
+        grids.push_back(readVtu(source));
+    }
+    return appendGrids(grids);
+}
+
+} // namespace tl
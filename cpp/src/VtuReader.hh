@@ -0,0 +1,107 @@
+#ifndef CPP_VTU_READER_HH
+#define CPP_VTU_READER_HH
+
+#include <vtkSmartPointer.h>
+
+#include <boost/optional.hpp>
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+class vtkUnstructuredGrid;
+
+namespace tl
+{
+
+namespace detail
+{
+/// Element of the XML header of a file
+struct XmlTag
+{
+    std::string name;
+    std::map<std::string, std::string> attributes;
+    bool closing = false;
+    bool self_closing = false;
+
+    std::string attribute(const std::string& key,
+                          const std::string& fallback = "") const
+    {
+        auto it = attributes.find(key);
+        return it != attributes.end() ? it->second : fallback;
+    }
+};
+
+
+/**
+ * @brief Read the next tag of an XML text, skipping character data, comments
+ *      and declarations.
+ *
+ * @param data The text
+ * @param size Size of the text
+ * @param pos Position to start at, set behind the tag
+ * @return The tag or none at the end of the text or for malformed tags
+ */
+boost::optional<XmlTag> nextTag(const char* data,
+                                std::size_t size,
+                                std::size_t& pos);
+} // namespace detail
+
+
+/**
+ * Check whether a file name has the extension of VTK XML unstructured grids
+ * (.vtu).
+ */
+bool isVtuFile(const std::string& file_name);
+
+
+/**
+ * Check whether a file name has the extension of parallel VTK XML
+ * unstructured grids (.pvtu).
+ */
+bool isPvtuFile(const std::string& file_name);
+
+
+/**
+ * @brief Read a VTK XML unstructured grid, decoding the arrays in parallel.
+ * @details Files with appended raw data, uncompressed or zlib compressed, are
+ *      decoded by a thread per array or compressed block. The points, the
+ *      cells and the point data arrays with 9 components (tensors) are read,
+ *      other arrays are skipped. All other files are read with VTK's reader.
+ *      Several pieces in the file are appended like in readPvtu().
+ *
+ * @param file_name Name of the .vtu file
+ * @return The grid
+ * @throws std::runtime_error if the file can not be read or is damaged
+ */
+vtkSmartPointer<vtkUnstructuredGrid> readVtu(const std::string& file_name);
+
+
+/**
+ * @brief Get the files of the pieces of a parallel VTK XML unstructured grid.
+ * @details Relative names are resolved against the directory of the .pvtu
+ *      file.
+ *
+ * @param file_name Name of the .pvtu file
+ * @return The names of the .vtu files of the pieces
+ * @throws std::runtime_error if the file can not be read or lists no pieces
+ */
+std::vector<std::string> pvtuPieces(const std::string& file_name);
+
+
+/**
+ * @brief Read the pieces of a parallel VTK XML unstructured grid with readVtu()
+ *      and append them to a single grid.
+ * @details Coincident points of different pieces, like the points on the
+ *      boundaries between pieces, are merged into one point.
+ *
+ * @param file_name Name of the .pvtu file
+ * @return The grid
+ * @throws std::runtime_error if a piece can not be read
+ */
+vtkSmartPointer<vtkUnstructuredGrid> readPvtu(const std::string& file_name);
+
+} // namespace tl
+
+#endif
@@ -0,0 +1,104 @@
+#include "TensorMeshFile.hh"
+
+#include <boost/algorithm/string.hpp>
+#include <boost/program_options.hpp>
+
+#include <vtkSmartPointer.h>
+#include <vtkUnstructuredGrid.h>
+#include <vtkUnstructuredGridReader.h>
+#include <vtkXMLUnstructuredGridReader.h>
+
+#include <iostream>
+#include <string>
+#include <stdexcept>
+
+namespace po = boost::program_options;
+
+
+int main(int argc, char const* argv[])
+{
+    auto input_file = std::string{};
+    auto out_name = std::string{};
+    auto single_precision = false;
+
+    try
+    {
+        po::options_description desc("Allowed options");
+        desc.add_options()
+            ("help,h", "produce help message")
+            ("input-file,i",
+             po::value<std::string>(&input_file)->required(),
+             "Name of the input file (VTK legacy or XML unstructured grid)")
+            ("output,o",
+             po::value<std::string>(&out_name),
+             "Name of the output file (defaults to the input name with the "
+             "extension .tlm)")
+            ("single-precision",
+             po::bool_switch(&single_precision),
+             "Store the tensors as floats");
+
+        auto vm = po::variables_map{};
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+
+        if(vm.empty() || vm.count("help"))
+        {
+            std::cout << "Convert a tetrahedral VTK dataset with tensor point "
+                         "fields to the binary tensor mesh format.\n\n";
+            std::cout << desc << "\n";
+            return 0;
+        }
+
+        po::notify(vm);
+
+        if(vm.count("output") == 0)
+        {
+            auto lastindex = input_file.find_last_of(".");
+            out_name = input_file.substr(0, lastindex) + ".tlm";
+        }
+    }
+    catch(std::exception& e)
+    {
+        std::cerr << "error: " << e.what() << "\n";
+        return 1;
+    }
+    catch(...)
+    {
+        std::cerr << "Exception of unknown type!\n";
+    }
+
+    auto grid = vtkSmartPointer<vtkUnstructuredGrid>{};
+    auto reader_error = 0ul;
+    if(boost::iends_with(input_file, ".vtu"))
+    {
+        auto reader = vtkSmartPointer<vtkXMLUnstructuredGridReader>::New();
+        reader->SetFileName(input_file.c_str());
+        reader->Update();
+        reader_error = reader->GetErrorCode();
+        grid = reader->GetOutput();
+    }
+    else
+    {
+        auto reader = vtkSmartPointer<vtkUnstructuredGridReader>::New();
+        reader->SetFileName(input_file.c_str());
+        reader->Update();
+        reader_error = reader->GetErrorCode();
+        grid = reader->GetOutput();
+    }
+    if(reader_error != 0 || !grid || grid->GetNumberOfPoints() == 0)
+    {
+        std::cerr << "error: could not read " << input_file << "\n";
+        return 1;
+    }
+
+    try
+    {
+        tl::writeTensorMesh(grid, out_name, single_precision);
+    }
+    catch(std::exception& e)
+    {
+        std::cerr << "error: " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
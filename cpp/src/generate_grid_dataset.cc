@@ -1,6 +1,7 @@
 #include "utils.hh"
 
 #include "TensorField.hh"
+#include "TensorMeshFile.hh"
 
 #include <vtkSmartPointer.h>
 #include <vtkDoubleArray.h>
@@ -153,6 +154,7 @@ int main(int argc, char const* argv[])
     auto maxz = 0.;
     auto np = 0u;
     auto out_name = std::string{"Grid.vtk"};
+    auto single_precision = false;
 
     try
     {
@@ -185,7 +187,11 @@ int main(int argc, char const* argv[])
                 ("output,o",
                  po::value<std::string>(&out_name)->required()->default_value(
                         out_name),
-                 "Name of the output file");
+                 "Name of the output file (VTK format, or the binary tensor "
+                 "mesh format for the extension .tlm)")
+                ("single-precision",
+                 po::bool_switch(&single_precision),
+                 "Store the tensors as floats in .tlm files");
 
         auto vm = po::variables_map{};
         po::store(po::parse_command_line(argc, argv, desc), vm);
@@ -267,6 +273,20 @@ int main(int argc, char const* argv[])
     auto tri_filt = vtkSmartPointer<vtkDataSetTriangleFilter>::New();
     tri_filt->SetInputData(grid);
 
+    if(isTensorMeshFile(out_name))
+    {
+        tri_filt->Update();
+        try
+        {
+            writeTensorMesh(tri_filt->GetOutput(), out_name, single_precision);
+        }
+        catch(std::exception& e)
+        {
+            std::cerr << "error: " << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
 
     auto writer = vtkSmartPointer<vtkUnstructuredGridWriter>::New();
     writer->SetInputConnection(0, tri_filt->GetOutputPort());
@@ -1,3 +1,4 @@
+#include "TensorMeshFile.hh"
 #include "utils.hh"
 
 #include <boost/program_options.hpp>
@@ -61,6 +62,7 @@ int main(int argc, char const* argv[])
     auto symmetric = false;
     auto interactive = false;
     auto gen_derivatives = false;
+    auto single_precision = false;
 
     try
     {
@@ -88,7 +90,11 @@ int main(int argc, char const* argv[])
             ("output,o",
              po::value<std::string>(&out_name)
                      ->required()->default_value(out_name),
-             "Name of the output file");
+             "Name of the output file (VTK format, or the binary tensor mesh "
+             "format for the extension .tlm)")
+            ("single-precision",
+             po::bool_switch(&single_precision),
+             "Store the tensors as floats in .tlm files");
 
         auto vm = po::variables_map{};
         po::store(po::parse_command_line(argc, argv, desc), vm);
@@ -116,7 +122,7 @@ int main(int argc, char const* argv[])
     }
     catch(std::exception& e)
     {
-        std::cerr << "Error: " << e.what() << "\n";
+        std::cerr << "error: " << e.what() << "\n";
         return 1;
     }
     catch(...)
@@ -232,6 +238,20 @@ int main(int argc, char const* argv[])
         grid->DeepCopy(new_grid);
     }
 
+    if(tl::isTensorMeshFile(out_name))
+    {
+        try
+        {
+            tl::writeTensorMesh(grid, out_name, single_precision);
+        }
+        catch(std::exception& e)
+        {
+            std::cerr << "error: " << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
     auto inwriter = vtkSmartPointer<vtkUnstructuredGridWriter>::New();
     inwriter->SetInputData(grid);
     inwriter->SetFileName(out_name.c_str());
@@ -206,11 +206,14 @@ def generate_basis(tp):
 
 
 def generate_trans_func(mat):
+    '''Generate statements applying the linear operator mat to the array in.
+       Factors are cast to the coordinate type C so that single precision
+       specializations do not compute in double precision.'''
     matrix = np.array(mat)
 
     for i in range(matrix.shape[0]):
         line = "out[" + str(i) + "] = "
-        line += " + ".join(((format_coeff(matrix[i, j]) + " * ") if matrix[i, j] != 1. else "") + "in[" + str(
+        line += " + ".join((("C(" + format_coeff(matrix[i, j]) + ") * ") if matrix[i, j] != 1. else "") + "in[" + str(
             j) + "]" for j in range(matrix.shape[1]) if abs(matrix[i, j]) > 1e-9) + ";"
         yield line
 
@@ -289,6 +292,11 @@ private:
 {ComputeCoeffs}
         return out;
     }}
+
+    static std::pair<T, T> coeffsRange(const Coeffs& in)
+    {{
+{CoeffsRange}
+    }}
 }};"""
 
 deriv_template = """template <typename T, typename C>
@@ -338,6 +346,34 @@ def codegen_splitcoeffs(tp):
     return code
 
 
+def codegen_range(ncoeffs):
+    '''Generate a branch-free reduction computing the minimum and maximum of
+       the coefficients. Each step combines the lower half of the remaining
+       values with the upper half element-wise, so that the compiler can map
+       every step to packed min/max instructions of the target.'''
+    if ncoeffs == 1:
+        return "return {in[0], in[0]};"
+    lo = ["in[{}]".format(i) for i in range(ncoeffs)]
+    hi = list(lo)
+    code = ""
+    step = 0
+    while len(lo) > 1:
+        half = len(lo) // 2
+        size = half + len(lo) % 2
+        for name, op, vals in (("lo", "min", lo), ("hi", "max", hi)):
+            code += "auto {}{} = std::array<T, {}>{{}};\n".format(name, step, size)
+            for i in range(half):
+                code += "{}{}[{}] = std::{}({}, {});\n".format(
+                    name, step, i, op, vals[i], vals[i + half])
+            if len(vals) % 2:
+                code += "{}{}[{}] = {};\n".format(name, step, half, vals[-1])
+        lo = ["lo{}[{}]".format(step, i) for i in range(size)]
+        hi = ["hi{}[{}]".format(step, i) for i in range(size)]
+        step += 1
+    code += "return {{{}, {}}};".format(lo[0], hi[0])
+    return code
+
+
 def codegen_derivatives(tp):
     deg_args = ", ".join(str(i) for i in tp.degrees)
     derivatives = ""
@@ -376,12 +412,14 @@ def generate_tpbt_file(degrees):
     basis = indent("\n".join(generate_basis(tp)), 3)
     splitcoeffs = indent(codegen_splitcoeffs(tp), 3)
     computecoeffs = indent("\n".join(generate_trans_func(tp.system_inv())), 3)
+    coeffsrange = indent(codegen_range(len(tp.multi_indices())), 2)
 
     class_code = class_template.format(deg=deg_args, NDegrees=len(tp.degrees),
                                        Indices=cindices,
                                        DomainPoints=domainpoints,
                                        Basis=basis, SplitCoeffs=splitcoeffs,
-                                       ComputeCoeffs=computecoeffs)
+                                       ComputeCoeffs=computecoeffs,
+                                       CoeffsRange=coeffsrange)
 
     derivatives_code = codegen_derivatives(tp)
 
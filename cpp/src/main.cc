@@ -1,4 +1,9 @@
+#include "BoundedQueue.hh"
+#include "CandidateCache.hh"
+#include "LineWriter.hh"
 #include "TensorLines.hh"
+#include "TensorMeshFile.hh"
+#include "VtuReader.hh"
 #include "utils.hh"
 #include "vtkTensorLines.h"
 
@@ -21,16 +26,25 @@
 #include <vtkUnstructuredGridWriter.h>
 
 #include <boost/algorithm/string.hpp>
+#include <boost/optional.hpp>
 #include <boost/program_options.hpp>
 
 #include <Eigen/Geometry>
 
+#include <algorithm>
+#include <atomic>
+#include <initializer_list>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #ifdef __linux__
+#include <glob.h>
 #include <signal.h>
-#include <thread>
 
 
 bool term = false;
@@ -79,6 +93,54 @@ std::istream& operator>>(std::istream& in, vtkTensorLines::LineType& ltype)
 }
 
 
+std::istream& operator>>(std::istream& in, tl::StartMesh& mesh)
+{
+    auto token = std::string{};
+    in >> token;
+
+    boost::to_upper(token);
+
+    if(token == "OCTANTS")
+    {
+        mesh = tl::StartMesh::Octants;
+    }
+    else if(token == "OCTAHEDRON")
+    {
+        mesh = tl::StartMesh::Octahedron;
+    }
+    else if(token == "ICOSAHEDRON")
+    {
+        mesh = tl::StartMesh::Icosahedron;
+    }
+    else
+    {
+        throw po::validation_error(po::validation_error::invalid_option_value, "start-mesh", token);
+    }
+
+    return in;
+}
+
+
+std::ostream& operator<<(std::ostream& out, const tl::StartMesh& mesh)
+{
+    switch(mesh)
+    {
+        case tl::StartMesh::Octants:
+            out << "octants";
+            break;
+        case tl::StartMesh::Octahedron:
+            out << "octahedron";
+            break;
+        case tl::StartMesh::Icosahedron:
+            out << "icosahedron";
+            break;
+        default:
+            assert(false);
+    }
+    return out;
+}
+
+
 std::ostream& operator<<(std::ostream& out, const vtkTensorLines::LineType& ftype)
 {
     switch(ftype)
@@ -99,6 +161,149 @@ std::ostream& operator<<(std::ostream& out, const vtkTensorLines::LineType& ftyp
 }
 
 
+/**
+ * Append the index of an input to a file name, before the extension.
+ */
+std::string stepFileName(const std::string& file_name, std::size_t step)
+{
+    auto lastindex = file_name.find_last_of(".");
+    if(lastindex == std::string::npos)
+    {
+        return file_name + "_" + std::to_string(step);
+    }
+    return file_name.substr(0, lastindex) + "_" + std::to_string(step)
+           + file_name.substr(lastindex);
+}
+
+
+/**
+ * @brief Compute the digest of an input file that keys the candidate cache.
+ * @details For a .pvtu file, the digests of its pieces are appended, since the
+ *      data is stored in the pieces.
+ * @return The digest or boost::none if a file can not be read
+ */
+boost::optional<std::string> inputDigest(const std::string& file_name)
+{
+    auto digest = tl::fileDigest(file_name);
+    if(!digest || !tl::isPvtuFile(file_name))
+    {
+        return digest;
+    }
+    try
+    {
+        for(const auto& piece : tl::pvtuPieces(file_name))
+        {
+            const auto piece_digest = tl::fileDigest(piece);
+            if(!piece_digest)
+            {
+                return boost::none;
+            }
+            *digest += ' ' + *piece_digest;
+        }
+    }
+    catch(const std::runtime_error&)
+    {
+        return boost::none;
+    }
+    return digest;
+}
+
+
+/**
+ * Replace glob patterns by the matching file names in sorted order. Names
+ * without matches are kept, so that reading them reports the error.
+ */
+std::vector<std::string> expandInputFiles(
+        const std::vector<std::string>& patterns)
+{
+    auto files = std::vector<std::string>{};
+    for(const auto& pattern : patterns)
+    {
+#ifdef __linux__
+        auto matches = glob_t{};
+        if(::glob(pattern.c_str(), 0, nullptr, &matches) == 0)
+        {
+            for(auto i = std::size_t{0}; i < matches.gl_pathc; ++i)
+            {
+                files.emplace_back(matches.gl_pathv[i]);
+            }
+            globfree(&matches);
+            continue;
+        }
+        globfree(&matches);
+#endif // __linux__
+        files.push_back(pattern);
+    }
+    return files;
+}
+
+
+/// Dataset read from an input file
+struct InputData
+{
+    std::size_t index;
+    vtkSmartPointer<vtkUnstructuredGrid> grid;
+    // Memory the arrays of the grid point to, if not owned by them
+    std::shared_ptr<const void> storage;
+    // Digest that keys the candidate cache, if one is used and it was computed
+    boost::optional<std::string> digest;
+};
+
+
+/**
+ * @brief Read the grid of an input file, memory mapping binary tensor meshes
+ *      and decoding VTK XML grids in parallel.
+ * @throws std::runtime_error if the file can not be read
+ */
+InputData readGrid(std::size_t index, const std::string& file_name)
+{
+    if(tl::isTensorMeshFile(file_name))
+    {
+        auto mesh = tl::readTensorMesh(file_name);
+        return {index, mesh.grid, mesh.file, boost::none};
+    }
+    if(tl::isPvtuFile(file_name))
+    {
+        return {index, tl::readPvtu(file_name), nullptr, boost::none};
+    }
+    if(tl::isVtuFile(file_name))
+    {
+        return {index, tl::readVtu(file_name), nullptr, boost::none};
+    }
+    auto reader = vtkSmartPointer<vtkUnstructuredGridReader>::New();
+    reader->SetFileName(file_name.c_str());
+    reader->Update();
+    if(reader->GetErrorCode() != 0
+       || reader->GetOutput()->GetNumberOfPoints() == 0)
+    {
+        throw std::runtime_error("VTK's reader failed");
+    }
+    return {index,
+            vtkSmartPointer<vtkUnstructuredGrid>{reader->GetOutput()},
+            nullptr,
+            boost::none};
+}
+
+
+/**
+ * @brief Read an input file and, if a candidate cache is used, compute its
+ *      digest, so that hashing the file does not delay the search.
+ * @param with_digest Whether to compute the digest of the file
+ * @throws std::runtime_error if the file can not be read
+ */
+InputData readInput(std::size_t index,
+                    const std::string& file_name,
+                    bool with_digest)
+{
+    auto input = readGrid(index, file_name);
+    if(with_digest)
+    {
+        input.digest = inputDigest(file_name);
+    }
+    return input;
+}
+
+
 void ProgressFunction(vtkObject* caller,
                       long unsigned int vtkNotUsed(eventId),
                       void* vtkNotUsed(clientData),
@@ -114,11 +319,24 @@ int main(int argc, char const* argv[])
 {
     using namespace tl;
 
-    auto input_file = std::string{};
+    auto input_files = std::vector<std::string>{};
     auto tolerance = 1e-6;
     auto cluster_epsilon = 1e-3;
     auto max_candidates = std::size_t{1000};
+    auto coarse_levels = std::size_t{0};
+    auto start_mesh = StartMesh::Octants;
+    auto start_mesh_level = std::size_t{1};
+    auto seeded_search = false;
+    auto cache_face_results = false;
+    auto numa_local = false;
+    auto candidate_cache = std::string{};
+    auto incremental = false;
+    auto incremental_threshold = 0.;
+    auto queue_size = std::size_t{1};
+    auto output_format = std::string{"vtk"};
+    auto output_attributes = std::vector<std::string>{};
     auto out_name = std::string{"Parallel_Eigenvectors_Lines.vtk"};
+    auto out_names = std::vector<std::string>{};
     auto out2_name = std::string{"Parallel_Eigenvectors_Lines_NLTris.vtk"};
     auto s_field_name = std::string{"S"};
     auto t_field_name = std::string{"T"};
@@ -142,9 +360,80 @@ int main(int argc, char const* argv[])
                      ->required()->default_value(max_candidates),
              "Maximum number of candidate triangles on a face before "
              "breaking off and assuming a non-line structure")
+            ("coarse-levels",
+             po::value<std::size_t>(&coarse_levels)
+                     ->default_value(coarse_levels),
+             "Number of subdivision levels evaluated in single precision "
+             "before switching to double precision (0 to disable)")
+            ("start-mesh",
+             po::value<StartMesh>(&start_mesh)->default_value(start_mesh),
+             "Mesh of direction triangles the search starts with (octants, "
+             "octahedron, icosahedron)")
+            ("start-mesh-level",
+             po::value<std::size_t>(&start_mesh_level)
+                     ->default_value(start_mesh_level),
+             "Number of times each triangle of the start mesh is split")
+            ("seeded-search",
+             po::bool_switch(&seeded_search),
+             "Skip the start triangles that can not contain a solution, "
+             "judged from the tensors at the face vertices")
+            ("cache-face-results",
+             po::bool_switch(&cache_face_results),
+             "Search faces with the same tensors only once (for fields with "
+             "constant or repeated regions). The tensors are compared and "
+             "searched with 40 mantissa bits.")
+            ("numa-local",
+             po::bool_switch(&numa_local),
+             "Pin each thread to the CPUs of a NUMA node (Linux only) and "
+             "search the faces in a contiguous part per node, with the "
+             "tensors of each part in the memory of its node. Ignored with a "
+             "warning on machines with a single node")
+            ("candidate-cache",
+             po::value<std::string>(&candidate_cache),
+             "File keeping the search results of each face, so that runs on "
+             "the same input with other clustering options skip the search")
             ("input-file,i",
-             po::value<std::string>(&input_file)->required(),
-             "name of the input file (VTK format)")
+             po::value<std::vector<std::string>>(&input_files)
+                     ->required()->multitoken(),
+             "name of the input file (VTK legacy format, VTK XML .vtu or "
+             ".pvtu, or binary tensor mesh with the extension .tlm). Several "
+             "files or glob "
+             "patterns are processed in turn, reading the next and writing "
+             "the previous file while the lines of one are computed.")
+            ("incremental",
+             po::bool_switch(&incremental),
+             "Treat the input files as time steps on the same mesh and only "
+             "search the faces whose tensors changed since the previous step")
+            ("incremental-threshold",
+             po::value<double>(&incremental_threshold)
+                     ->default_value(incremental_threshold),
+             "Largest change of a tensor component that does not trigger a "
+             "new search of the incident faces. Changes are measured from "
+             "the step in which the point was last searched, so small "
+             "changes add up.")
+            ("queue-size",
+             po::value<std::size_t>(&queue_size)
+                     ->default_value(queue_size),
+             "Number of read inputs and computed results buffered while "
+             "processing several input files")
+            ("output-format",
+             po::value<std::string>(&output_format)
+                     ->default_value(output_format),
+             "Output format: vtk (VTK legacy), vtp (VTK XML poly data) or npy "
+             "(one NumPy array file per point attribute plus the segments, "
+             "the output name is a prefix). vtp and npy are written while the "
+             "lines are assembled instead of building a VTK dataset of them. "
+             "The points of all faces are still held until the search of an "
+             "input ends, and vtp columns go to temporary files first, which "
+             "are then copied into the output")
+            ("output-attributes",
+             po::value<std::vector<std::string>>(&output_attributes)
+                     ->multitoken(),
+             "Point attributes to write (pos, rank1, rank2, eigenvalue1, "
+             "eigenvalue2, eivec, imaginary1, imaginary2, cluster_size, "
+             "pos_uncertainty, dir_uncertainty, line_stability), all if not "
+             "given. Eigenvalues, ranks and the line stability are only "
+             "computed if selected.")
             ("s-field-name,s",
              po::value<std::string>(&s_field_name)
                  ->required()->default_value(s_field_name),
@@ -190,22 +479,47 @@ int main(int argc, char const* argv[])
                          "--t-field-name will be ignored."
                       << std::endl;
         }
-        if(vm.count("output") == 0)
+        if(output_format != "vtk" && output_format != "vtp"
+           && output_format != "npy")
         {
-            auto lastindex = input_file.find_last_of(".");
-            auto rawname = input_file.substr(0, lastindex);
-            switch(line_type)
+            throw std::invalid_argument("Unknown output format "
+                                        + output_format);
+        }
+        for(const auto& key : output_attributes)
+        {
+            // Throws for unknown attributes
+            tl::lineAttributeName(key);
+        }
+        input_files = expandInputFiles(input_files);
+        for(auto i = std::size_t{0}; i < input_files.size(); ++i)
+        {
+            if(vm.count("output") == 0)
             {
-                case vtkTensorLines::ParallelEigenvectors:
-                    out_name = rawname + "_PEV";
-                    break;
-                case vtkTensorLines::TensorCoreLines:
-                    out_name = rawname + "_TCL";
-                    break;
-                case vtkTensorLines::TensorTopology:
-                    out_name = rawname + "_Topo";
+                const auto& input_file = input_files[i];
+                auto lastindex = input_file.find_last_of(".");
+                auto rawname = input_file.substr(0, lastindex);
+                switch(line_type)
+                {
+                    case vtkTensorLines::ParallelEigenvectors:
+                        out_name = rawname + "_PEV";
+                        break;
+                    case vtkTensorLines::TensorCoreLines:
+                        out_name = rawname + "_TCL";
+                        break;
+                    case vtkTensorLines::TensorTopology:
+                        out_name = rawname + "_Topo";
+                }
+                out_names.push_back(out_name
+                                    + (output_format == "npy"
+                                               ? "Lines"
+                                               : "Lines." + output_format));
+            }
+            else
+            {
+                out_names.push_back(input_files.size() > 1
+                                            ? stepFileName(out_name, i)
+                                            : out_name);
             }
-            out_name = out_name + "Lines.vtk";
         }
         // if(vm.count("output2") == 0)
         // {
@@ -243,9 +557,6 @@ int main(int argc, char const* argv[])
     std::cout << "Running in DEBUG mode" << std::endl;
 #endif
 
-    auto reader = vtkSmartPointer<vtkUnstructuredGridReader>::New();
-    reader->SetFileName(input_file.c_str());
-
     auto progressCallback = vtkSmartPointer<vtkCallbackCommand>::New();
     progressCallback->SetCallback(ProgressFunction);
 
@@ -253,10 +564,39 @@ int main(int argc, char const* argv[])
     vtkpev->SetTolerance(tolerance);
     vtkpev->SetClusterEpsilon(cluster_epsilon);
     vtkpev->SetMaxCandidates(max_candidates);
+    vtkpev->SetCoarseLevels(coarse_levels);
+    vtkpev->SetStartMesh(static_cast<int>(start_mesh));
+    vtkpev->SetStartMeshLevel(start_mesh_level);
+    vtkpev->SetSeededSearch(seeded_search);
+    vtkpev->SetCacheFaceResults(cache_face_results);
+    vtkpev->SetNumaLocal(numa_local);
+    // Each input is processed only once
+    vtkpev->SetKeepCandidates(false);
+    vtkpev->SetIncremental(incremental);
+    vtkpev->SetIncrementalThreshold(incremental_threshold);
     vtkpev->SetLineType(line_type);
+    vtkpev->SetStreamOutputFormat(int(output_format == "npy"
+                                              ? tl::LineFileFormat::Npy
+                                              : tl::LineFileFormat::VtkXml));
+    vtkpev->SetOutputAttributes(output_attributes);
+    if(!output_attributes.empty())
+    {
+        // Only compute the context info of the selected attributes
+        auto selected = [&](std::initializer_list<std::string> keys) {
+            return std::any_of(keys.begin(), keys.end(), [&](const auto& key) {
+                return std::find(output_attributes.begin(),
+                                 output_attributes.end(),
+                                 key)
+                       != output_attributes.end();
+            });
+        };
+        vtkpev->SetComputeEigenvalues(selected({"eigenvalue1", "eigenvalue2"}));
+        vtkpev->SetComputeRanks(
+                selected({"rank1", "rank2", "imaginary1", "imaginary2"}));
+        vtkpev->SetComputeLineStability(selected({"line_stability"}));
+    }
     vtkpev->AddObserver(vtkCommand::ProgressEvent, progressCallback);
 
-    vtkpev->SetInputConnection(0, reader->GetOutputPort(0));
     if(line_type == vtkTensorLines::ParallelEigenvectors)
     {
         vtkpev->SetInputArrayToProcess(0,
@@ -281,8 +621,9 @@ int main(int argc, char const* argv[])
 
 #ifdef __linux__
     // Set up thread to check for program termination and set AbortExecute
-    auto check_terminate = std::thread([&vtkpev]() {
-        while(!term && vtkpev->GetProgress() < 1.)
+    auto finished = std::atomic<bool>{false};
+    auto check_terminate = std::thread([&vtkpev, &finished]() {
+        while(!term && !finished)
         {
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
         }
@@ -306,12 +647,106 @@ int main(int argc, char const* argv[])
     // counter->SetOutputArrayName("Vertex Count");
     // counter->SetInputData(data);
 
-    auto outwriter = vtkSmartPointer<vtkPolyDataWriter>::New();
-    outwriter->SetInputConnection(vtkpev->GetOutputPort(0));
-    outwriter->SetFileName(out_name.c_str());
-    outwriter->SetFileTypeToBinary();
-    outwriter->Update();
-    outwriter->Write();
+    // Read the next inputs and write the previous results while the lines of
+    // the current input are computed. The queues limit the number of datasets
+    // held in memory.
+    auto read_queue = BoundedQueue<InputData>{queue_size};
+    auto write_queue =
+            BoundedQueue<std::pair<std::size_t, vtkSmartPointer<vtkPolyData>>>{
+                    queue_size};
+
+    // Inputs that can not be read are skipped, but make the program fail
+    auto read_failed = std::atomic<bool>{false};
+    auto read_thread = std::thread([&]() {
+        for(auto i = std::size_t{0}; i < input_files.size(); ++i)
+        {
+            try
+            {
+                if(!read_queue.push(readInput(
+                           i, input_files[i], !candidate_cache.empty())))
+                {
+                    break;
+                }
+            }
+            catch(std::exception& e)
+            {
+                std::cerr << "error: could not read " << input_files[i] << ": "
+                          << e.what() << "\n";
+                read_failed = true;
+            }
+        }
+        read_queue.close();
+    });
+
+    auto write_thread = std::thread([&]() {
+        while(auto result = write_queue.pop())
+        {
+            auto outwriter = vtkSmartPointer<vtkPolyDataWriter>::New();
+            outwriter->SetInputData(result->second);
+            outwriter->SetFileName(out_names[result->first].c_str());
+            outwriter->SetFileTypeToBinary();
+            outwriter->Write();
+        }
+    });
+
+    // Storage of the current input, which the filter references until the
+    // next input is set
+    auto current_storage = std::shared_ptr<const void>{};
+    while(auto input = read_queue.pop())
+    {
+#ifdef __linux__
+        if(term)
+        {
+            break;
+        }
+#endif // __linux__
+        const auto& input_file = input_files[input->index];
+        if(input_files.size() > 1)
+        {
+            std::cout << "Input " << input->index + 1 << " of "
+                      << input_files.size() << ": " << input_file << std::endl;
+        }
+
+        if(!candidate_cache.empty())
+        {
+            if(input->digest)
+            {
+                vtkpev->SetCandidateCache(
+                        input_files.size() > 1
+                                ? stepFileName(candidate_cache, input->index)
+                                : candidate_cache,
+                        input->digest.value());
+            }
+            else
+            {
+                std::cerr << "warning: could not read " << input_file
+                          << ", the candidate cache is disabled" << std::endl;
+                vtkpev->SetCandidateCache("", "");
+            }
+        }
+
+        if(output_format != "vtk")
+        {
+            vtkpev->SetStreamOutputFile(out_names[input->index]);
+        }
+        vtkpev->SetInputData(0, input->grid);
+        current_storage = input->storage;
+        vtkpev->Update();
+        if(output_format != "vtk")
+        {
+            continue;
+        }
+
+        // The filter replaces the arrays of its output on the next update, so
+        // a shallow copy stays valid while it is written
+        auto output = vtkSmartPointer<vtkPolyData>::New();
+        output->ShallowCopy(vtkpev->GetOutput());
+        write_queue.push({input->index, output});
+    }
+    read_queue.close();
+    write_queue.close();
+    read_thread.join();
+    write_thread.join();
 
     // auto out2writer = vtkSmartPointer<vtkPolyDataWriter>::New();
     // outwriter->SetInputConnection(vtkpev->GetOutputPort(1));
@@ -321,8 +756,9 @@ int main(int argc, char const* argv[])
     // outwriter->Write();
 
 #ifdef __linux__
+    finished = true;
     check_terminate.join();
 #endif // __linux__
 
-    return 0;
+    return read_failed ? 1 : 0;
 }
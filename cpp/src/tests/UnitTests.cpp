@@ -2,9 +2,40 @@
 #include <doctest.h>
 
 #include "TensorProductBezierTriangles.hh"
+#include "CandidateCache.hh"
+#include "EvaluatorUtils.hh"
+#include "LineWriter.hh"
+#include "NumaScheduling.hh"
+#include "StartPatches.hh"
 #include "TensorLineDefinitions.hh"
+#include "TensorLines.hh"
+#include "TensorMeshFile.hh"
+#include "VtuReader.hh"
 #include "utils.hh"
 
+#include <vtkCellType.h>
+#include <vtkDoubleArray.h>
+#include <vtkIdList.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkSmartPointer.h>
+#include <vtkUnstructuredGrid.h>
+
+#include <Eigen/Geometry>
+#include <Eigen/LU>
+
+#include <zlib.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <regex>
+#include <string>
+#include <tuple>
+
 using namespace cpp_utils;
 
 using doctest::Approx;
@@ -602,3 +633,1357 @@ TEST_CASE_TEMPLATE("Test SameSign functions", T, SameSignTypes)
         REQUIRE(tl::sameSign(std::vector<T>{0, -16}) == 0);
     }
 }
+
+TEST_CASE("Test exclusion of common roots of two polynomials")
+{
+    using Poly = tl::TensorProductBezierTriangle<double, double, 1>;
+
+    SUBCASE("Positive linear combination exists")
+    {
+        // f + g = 1 everywhere
+        auto f = Poly{{1., -1., 0.5}};
+        auto g = Poly{{0., 2., 0.5}};
+        REQUIRE(tl::sameSign(f.coefficients()) == 0);
+        REQUIRE(tl::sameSign(g.coefficients()) == 0);
+        REQUIRE_FALSE(tl::has_common_root(f, g));
+        REQUIRE_FALSE(tl::has_common_root(g, f));
+    }
+    SUBCASE("Negative linear combination exists")
+    {
+        // f - 2g < 0 everywhere
+        auto f = Poly{{-1., 1., 3.}};
+        auto g = Poly{{0., 2., 2.}};
+        REQUIRE_FALSE(tl::has_common_root(f, g));
+    }
+    SUBCASE("Common root at a corner")
+    {
+        auto f = Poly{{0., 1., -1.}};
+        auto g = Poly{{0., -1., 2.}};
+        REQUIRE(tl::has_common_root(f, g));
+    }
+    SUBCASE("Common root inside")
+    {
+        auto f = Poly{{1., -1., 0.}};
+        auto g = Poly{{1., 1., -2.}};
+        REQUIRE(f({1. / 3, 1. / 3, 1. / 3}) == Approx(0.));
+        REQUIRE(g({1. / 3, 1. / 3, 1. / 3}) == Approx(0.));
+        REQUIRE(tl::has_common_root(f, g));
+    }
+    SUBCASE("Sequence of polynomials")
+    {
+        auto polys = std::array<Poly, 3>{Poly{{1., -1., 0.}},
+                                         Poly{{1., 1., -2.}},
+                                         Poly{{-1., 0., 1.}}};
+        REQUIRE(tl::pairwise_common_root(polys));
+        polys[2] = Poly{{-1., 2., 1.}};
+        REQUIRE_FALSE(tl::pairwise_common_root(polys));
+    }
+}
+
+TEST_CASE("Test single precision subdivision")
+{
+    GIVEN("A tensor product polynomial of degree 1 and 3 with random "
+          "coefficients")
+    {
+        auto coeffs = Coeffs1_3{};
+        for(auto& c : coeffs)
+        {
+            c = 10. * Eigen::Matrix<double, 1, 1>::Random()(0);
+        }
+        auto poly = TPBT1_3{coeffs};
+        auto bound = tl::abs_upper_bound(poly);
+
+        WHEN("We split a single precision copy and the original 16 times")
+        {
+            auto poly_f = poly.cast<float>();
+            for(auto level : range(16))
+            {
+                auto part = std::size_t(level * 7 % 4);
+                if(level % 2 == 0)
+                {
+                    poly = poly.split<0>(part);
+                    poly_f = poly_f.split<0>(part);
+                }
+                else
+                {
+                    poly = poly.split<1>(part);
+                    poly_f = poly_f.split<1>(part);
+                }
+            }
+
+            THEN("The coefficients differ by less than the rounding error "
+                 "bound used in the search")
+            {
+                // One rounding error per split plus one for the conversion
+                auto error_bound =
+                        17 * 16 * std::numeric_limits<float>::epsilon() * bound;
+                for(auto i : range(coeffs.size()))
+                {
+                    REQUIRE(std::abs(poly.coefficients()[i]
+                                     - poly_f.coefficients()[i])
+                            < error_bound);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Test range of the coefficients")
+{
+    auto coeffs = Coeffs1_3{};
+    for(auto& c : coeffs)
+    {
+        c = Eigen::Matrix<double, 1, 1>::Random()(0);
+    }
+    auto minmax = std::minmax_element(coeffs.begin(), coeffs.end());
+    auto range = TPBT1_3{coeffs}.range();
+    REQUIRE(range.first == *minmax.first);
+    REQUIRE(range.second == *minmax.second);
+}
+
+TEST_CASE("Test exact product of polynomials")
+{
+    using TPBT1_1 = tl::TensorProductBezierTriangle<double, double, 1, 1>;
+    using TPBT0_1 = tl::TensorProductBezierTriangle<double, double, 0, 1>;
+    using Triangle0_1 =
+            tl::TensorProductBezierTriangle<tl::Vec3d, double, 0, 1>;
+
+    auto random_coords = []() {
+        auto coords = Coords1_2{};
+        for(auto s : range(2))
+        {
+            auto bary = Eigen::Vector3d{Eigen::Vector3d::Random().cwiseAbs()};
+            coords.segment<3>(3 * s) = bary / bary.sum();
+        }
+        return coords;
+    };
+
+    GIVEN("Two scalar polynomials with random coefficients")
+    {
+        auto a = TPBT1_1{};
+        auto b = TPBT0_1{};
+        for(auto& c : a.coefficients())
+        {
+            c = Eigen::Matrix<double, 1, 1>::Random()(0);
+        }
+        for(auto& c : b.coefficients())
+        {
+            c = Eigen::Matrix<double, 1, 1>::Random()(0);
+        }
+
+        WHEN("We compute their product")
+        {
+            auto ab = tl::product<double>(a, b);
+
+            THEN("It evaluates to the product of the factors")
+            {
+                for(auto _ : range(10))
+                {
+                    auto coords = random_coords();
+                    REQUIRE(ab(coords) == Approx(a(coords) * b(coords)));
+                }
+            }
+        }
+    }
+
+    GIVEN("A triangle of vectors lifted to the second space")
+    {
+        auto r = Triangle{{tl::Vec3d::Random(),
+                           tl::Vec3d::Random(),
+                           tl::Vec3d::Random()}};
+        auto r0_1 = Triangle0_1{r.coefficients()};
+
+        WHEN("We compute the cross products with a polynomial of degree 1, 1")
+        {
+            auto v = tl::TensorProductBezierTriangle<tl::Vec3d, double, 1, 1>{};
+            for(auto& c : v.coefficients())
+            {
+                c = tl::Vec3d::Random();
+            }
+            auto cross = [](const tl::Vec3d& x, const tl::Vec3d& y) {
+                return tl::Vec3d{x.cross(y)};
+            };
+            auto vr = tl::product<tl::Vec3d>(v, r0_1, cross);
+
+            THEN("Each component evaluates to the pointwise cross product")
+            {
+                for(auto i : range(3))
+                {
+                    auto component = tl::mapCoefficients<double>(
+                            vr, [i](const tl::Vec3d& x) { return x[i]; });
+                    auto coords = random_coords();
+                    auto expected = v(coords).cross(r(coords.tail<3>()));
+                    REQUIRE(component(coords) == Approx(expected[i]));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Test precomputed start patches")
+{
+    // The patches must be computed at compile time
+    constexpr auto patches = tl::detail::makeOctantStartPatches();
+    static_assert(patches.size() == 16, "Wrong number of start patches");
+    static_assert(patches[0].corners[0][0] == 1.,
+                  "Wrong first corner of the start patches");
+
+    using tl::Vec3d;
+    auto octants = std::array<Triangle, 4>{
+            Triangle{{Vec3d{1, 0, 0}, Vec3d{0, 1, 0}, Vec3d{0, 0, 1}}},
+            Triangle{{Vec3d{0, 1, 0}, Vec3d{-1, 0, 0}, Vec3d{0, 0, 1}}},
+            Triangle{{Vec3d{-1, 0, 0}, Vec3d{0, -1, 0}, Vec3d{0, 0, 1}}},
+            Triangle{{Vec3d{0, -1, 0}, Vec3d{1, 0, 0}, Vec3d{0, 0, 1}}}};
+
+    auto t = tl::TensorInterp{};
+    for(auto& c : t.coefficients())
+    {
+        c = tl::Mat3d::Random();
+    }
+
+    for(auto i : range(tl::octant_start_patches.size()))
+    {
+        const auto& patch = tl::octant_start_patches[i];
+        auto r = octants[i / 4].split(i % 4);
+        REQUIRE(patch.triangle() == r);
+
+        // (T * r) x r as a product of polynomials
+        auto rv = tl::TensorProductBezierTriangle<Vec3d, double, 0, 1>{
+                r.coefficients()};
+        auto tv = tl::TensorProductBezierTriangle<tl::Mat3d, double, 1, 0>{
+                t.coefficients()};
+        auto cross = [](const Vec3d& x, const Vec3d& y) {
+            return Vec3d{x.cross(y)};
+        };
+        auto ev = tl::product<Vec3d>(tl::product<Vec3d>(tv, rv), rv, cross);
+
+        auto coeffs = tl::start_patch_ev_coeffs(t, patch);
+        for(auto c : range(3))
+        {
+            for(auto k : range(TPBT1_2::NCoeffs))
+            {
+                REQUIRE(coeffs[c][k] == Approx(ev[k][c]));
+            }
+        }
+    }
+}
+
+TEST_CASE("Test start meshes covering the hemisphere")
+{
+    using tl::StartMesh;
+    using tl::Vec3d;
+
+    auto meshes = std::array<std::pair<StartMesh, std::size_t>, 3>{
+            std::make_pair(StartMesh::Octants, 4),
+            std::make_pair(StartMesh::Octahedron, 4),
+            std::make_pair(StartMesh::Icosahedron, 10)};
+
+    for(const auto& mesh : meshes)
+    {
+        for(auto level : range(3))
+        {
+            auto patches = tl::make_start_patches(mesh.first, level);
+            REQUIRE(patches.size() == mesh.second << (2 * level));
+
+            // Each direction or its opposite lies in the cone of a patch
+            for(auto _ : range(20))
+            {
+                auto dir = Vec3d{Vec3d::Random().normalized()};
+                auto covered = false;
+                for(const auto& patch : patches)
+                {
+                    auto r = patch.triangle();
+                    auto m = tl::Mat3d{};
+                    m << r[0], r[1], r[2];
+                    auto coords = Vec3d{m.inverse() * dir};
+                    covered = covered
+                              || (coords.array() >= -1e-12).all()
+                              || (coords.array() <= 1e-12).all();
+                }
+                REQUIRE(covered);
+            }
+        }
+    }
+
+    SUBCASE("The octants split once are the default patches")
+    {
+        auto patches = tl::make_start_patches(StartMesh::Octants, 1);
+        for(auto i : range(patches.size()))
+        {
+            REQUIRE(patches[i].triangle()
+                    == tl::octant_start_patches[i].triangle());
+        }
+    }
+}
+
+TEST_CASE("Test orthonormal basis of the plane orthogonal to a direction")
+{
+    using tl::Vec3d;
+
+    auto dirs = std::vector<Vec3d>{Vec3d{0, 0, 1},
+                                   Vec3d{0, 0, -1},
+                                   Vec3d{1, 0, -0.},
+                                   Vec3d{0, 1, 1e-17}};
+    for(auto _ : range(100))
+    {
+        dirs.push_back(Vec3d::Random().normalized());
+    }
+
+    for(const auto& n : dirs)
+    {
+        auto basis = tl::orthonormalBasis(n);
+        const auto& b1 = basis.first;
+        const auto& b2 = basis.second;
+        REQUIRE(b1.norm() == Approx(1));
+        REQUIRE(b2.norm() == Approx(1));
+        REQUIRE(b1.dot(b2) == Approx(0));
+        REQUIRE(b1.dot(n) == Approx(0));
+        REQUIRE(b2.dot(n) == Approx(0));
+        REQUIRE(b1.cross(b2).dot(n) == Approx(1));
+
+        // The basis only depends on the direction
+        REQUIRE(tl::orthonormalBasis(n) == basis);
+    }
+}
+
+TEST_CASE("Test seeding of the start patches")
+{
+    using tl::Mat3d;
+    using tl::Vec3d;
+
+    auto patches = tl::make_start_patches(tl::StartMesh::Octahedron, 2);
+
+    SUBCASE("Patches containing a known real eigenvector are kept")
+    {
+        auto kept = std::size_t{0};
+        auto excluded = std::size_t{0};
+        for(auto _ : range(200))
+        {
+            auto t = tl::TensorInterp{};
+            for(auto& c : t.coefficients())
+            {
+                c = Mat3d::Random();
+            }
+            auto x = Vec3d{Vec3d::Random().cwiseAbs()};
+            x /= x.sum();
+            auto r = Vec3d{Vec3d::Random().normalized()};
+
+            // Make r an eigenvector of t(x) by a rank one update of all
+            // vertex tensors
+            auto tx = Mat3d{x[0] * t[0] + x[1] * t[1] + x[2] * t[2]};
+            auto update = Mat3d{(r - tx * r) * r.transpose()};
+            for(auto& c : t.coefficients())
+            {
+                c += update;
+            }
+
+            for(const auto& patch : patches)
+            {
+                auto m = Mat3d{};
+                m << patch.triangle()[0], patch.triangle()[1],
+                        patch.triangle()[2];
+                auto coords = Vec3d{m.inverse() * r};
+                auto contains = (coords.array() >= 1e-9).all()
+                                || (coords.array() <= -1e-9).all();
+                if(contains)
+                {
+                    REQUIRE(tl::may_contain_eigenvector(t, patch));
+                    ++kept;
+                }
+                else if(!tl::may_contain_eigenvector(t, patch))
+                {
+                    ++excluded;
+                }
+            }
+        }
+        REQUIRE(kept > 0);
+        REQUIRE(excluded > 0);
+    }
+
+    SUBCASE("A constant polynomial is separated from zero if nonzero")
+    {
+        auto funcs = std::array<TPBT3, 3>{};
+        for(auto c : range(3))
+        {
+            for(auto& coeff : funcs[c].coefficients())
+            {
+                coeff = c + 1.;
+            }
+        }
+        REQUIRE(tl::separated_from_zero(funcs, 1));
+        for(auto& coeff : funcs[1].coefficients())
+        {
+            coeff = 0.;
+        }
+        REQUIRE(tl::separated_from_zero(funcs, 1));
+        funcs[0][0] = -1.;
+        funcs[2][0] = -3.;
+        REQUIRE_FALSE(tl::separated_from_zero(funcs, 1));
+    }
+}
+
+#ifdef TL_HAS_VECTOR_TYPES
+TEST_CASE("Test subdivision of polynomials in lanes")
+{
+    constexpr auto W = std::size_t{4};
+    using LanePoly = tl::LanePolynomial<TPBT1_3, W>;
+
+    GIVEN("Arrays of polynomials with random coefficients stored in lanes")
+    {
+        auto polys = std::array<std::array<TPBT1_3, 2>, W>{};
+        auto lanes = std::array<LanePoly, 2>{};
+        for(auto lane : range(W))
+        {
+            for(auto& p : polys[lane])
+            {
+                for(auto& c : p.coefficients())
+                {
+                    c = Eigen::Matrix<double, 1, 1>::Random()(0);
+                }
+            }
+            // Shift one polynomial so that it has no root
+            if(lane % 2 == 1)
+            {
+                for(auto& c : polys[lane][1].coefficients())
+                {
+                    c += 2.;
+                }
+            }
+            tl::set_lane(lanes, lane, polys[lane]);
+        }
+
+        THEN("Each lane holds the stored polynomials")
+        {
+            for(auto lane : range(W))
+            {
+                REQUIRE(tl::get_lane<TPBT1_3>(lanes, lane) == polys[lane]);
+            }
+        }
+
+        WHEN("We split the lanes and each polynomial")
+        {
+            auto part = std::size_t{3};
+            auto split_lanes = std::array<LanePoly, 2>{lanes[0].split<1>(part),
+                                                       lanes[1].split<1>(part)};
+            auto has_root = tl::Lanes<double, W>{} == 0;
+            tl::lanes_have_root(split_lanes, has_root);
+
+            THEN("The results agree for each lane")
+            {
+                for(auto lane : range(W))
+                {
+                    auto split_polys = std::array<TPBT1_3, 2>{
+                            polys[lane][0].split<1>(part),
+                            polys[lane][1].split<1>(part)};
+                    REQUIRE(tl::get_lane<TPBT1_3>(split_lanes, lane)
+                            == split_polys);
+                    REQUIRE(bool(has_root[lane])
+                            == tl::range_max_upper_bound(split_polys)
+                                       .has_root);
+                }
+            }
+        }
+    }
+}
+#endif
+
+TEST_CASE("Test memoization of the search results of faces")
+{
+    using tl::Mat3d;
+    using tl::Vec3d;
+
+    // Entries with few mantissa bits, which the cache keys keep exactly
+    auto random_tensor = []() {
+        return Mat3d{(Mat3d::Random() * 16.).array().round() / 16.};
+    };
+    auto require_equal = [](const tl::TLResult& r1, const tl::TLResult& r2) {
+        REQUIRE(r1.points.size() == r2.points.size());
+        for(auto i : range(r1.points.size()))
+        {
+            const auto& p1 = r1.points[i];
+            const auto& p2 = r2.points[i];
+            for(auto c : range(3))
+            {
+                REQUIRE(p1.pos[c] == Approx(p2.pos[c]));
+            }
+            REQUIRE(p1.eivec == p2.eivec);
+            REQUIRE(p1.s_eival == p2.s_eival);
+            REQUIRE(p1.t_eival == p2.t_eival);
+            REQUIRE(p1.cluster_size == p2.cluster_size);
+            REQUIRE(p1.line_stability == p2.line_stability);
+        }
+        REQUIRE(r1.non_line_dirs == r2.non_line_dirs);
+        REQUIRE(r1.num_splits == r2.num_splits);
+    };
+
+    GIVEN("Two faces with the same tensors at the vertices")
+    {
+        auto x1 = std::array<Vec3d, 3>{
+                Vec3d{0, 0, 0}, Vec3d{1, 0, 0}, Vec3d{0, 1, 0}};
+        auto x2 = std::array<Vec3d, 3>{
+                Vec3d{2, 1, 3}, Vec3d{4, 1, 2}, Vec3d{2.5, 3, 3}};
+        auto opts = tl::TLOptions{};
+        opts.max_candidates = 1000;
+
+        auto found_points = false;
+        for(auto _ : range(20))
+        {
+            auto s = std::array<Mat3d, 3>{};
+            auto t = std::array<Mat3d, 3>{};
+            auto dt = std::array<Mat3d, 3>{};
+            for(auto i : range(3))
+            {
+                s[i] = random_tensor();
+                t[i] = random_tensor();
+                dt[i] = random_tensor();
+            }
+
+            auto cache = tl::FaceResultCache{};
+            auto vs = tl::vertexTensors(s);
+            auto vt = tl::vertexTensors(t);
+
+            cache.findParallelEigenvectors(vs, vt, x1, opts);
+            auto pev = cache.findParallelEigenvectors(vs, vt, x2, opts);
+            require_equal(pev, tl::findParallelEigenvectors(s, t, x2, opts));
+
+            cache.findTensorCoreLines(vt, dt, x1, opts);
+            auto tcl = cache.findTensorCoreLines(vt, dt, x2, opts);
+            require_equal(tcl, tl::findTensorCoreLines(t, dt, x2, opts));
+
+            // The first face of each kind is searched, the second one is
+            // taken from the cache
+            REQUIRE(cache.misses() == 2);
+            REQUIRE(cache.hits() == 2);
+
+            found_points = found_points || !pev.points.empty()
+                           || !tcl.points.empty();
+        }
+        REQUIRE(found_points);
+    }
+
+    GIVEN("A cache that keeps a single result")
+    {
+        auto x = std::array<Vec3d, 3>{
+                Vec3d{0, 0, 0}, Vec3d{1, 0, 0}, Vec3d{0, 1, 0}};
+        auto opts = tl::TLOptions{};
+        auto t1 = tl::vertexTensors(
+                {random_tensor(), random_tensor(), random_tensor()});
+        auto t2 = tl::vertexTensors(
+                {random_tensor(), random_tensor(), random_tensor()});
+        auto cache = tl::FaceResultCache{40, 1};
+
+        WHEN("We search a second face with other tensors")
+        {
+            cache.findTensorTopology(t1, x, opts);
+            cache.findTensorTopology(t2, x, opts);
+
+            THEN("The result of the first face is evicted")
+            {
+                cache.findTensorTopology(t1, x, opts);
+                REQUIRE(cache.misses() == 3);
+                cache.findTensorTopology(t1, x, opts);
+                REQUIRE(cache.hits() == 1);
+            }
+        }
+    }
+}
+
+TEST_CASE("Test the candidate cache file")
+{
+    using tl::Vec3d;
+
+    auto file_name = std::string{"candidate_cache_test.bin"};
+    auto key = std::string{"test key\n"};
+
+    auto faces = std::vector<tl::TLCandidates>(3);
+    for(auto i : range(faces.size()))
+    {
+        auto& face = faces[i];
+        for(auto _ : range(i + 1))
+        {
+            auto cell = tl::TLCandidate{};
+            for(auto k : range(3))
+            {
+                cell.pos_tri[k] = Vec3d::Random();
+                cell.dir_tri[k] = Vec3d::Random();
+            }
+            cell.error = Vec3d::Random()[0];
+            face.cells.push_back(cell);
+        }
+        if(i == 1)
+        {
+            face.non_line_dirs.push_back(Vec3d::Random());
+        }
+        face.num_splits = 100 * i + 7;
+        face.max_level = i + 3;
+    }
+    tl::writeCandidates(file_name, key, faces);
+
+    SUBCASE("The candidates are read back unchanged")
+    {
+        auto read = tl::readCandidates(file_name, key);
+        REQUIRE(read);
+        REQUIRE(*read == faces);
+    }
+
+    SUBCASE("The candidates are not read for a different key")
+    {
+        REQUIRE_FALSE(tl::readCandidates(file_name, "other key\n"));
+        REQUIRE_FALSE(tl::readCandidates(file_name, key + "more"));
+    }
+
+    SUBCASE("A truncated file is not read")
+    {
+        auto in = std::ifstream{file_name, std::ios::binary};
+        auto data = std::string{std::istreambuf_iterator<char>(in),
+                                std::istreambuf_iterator<char>()};
+        in.close();
+        for(auto size : {std::size_t{0},
+                         std::size_t{12},
+                         data.size() / 2,
+                         data.size() - 1})
+        {
+            auto out = std::ofstream{file_name,
+                                     std::ios::binary | std::ios::trunc};
+            out.write(data.data(), std::streamsize(size));
+            out.close();
+            REQUIRE_FALSE(tl::readCandidates(file_name, key));
+        }
+    }
+
+    std::remove(file_name.c_str());
+    REQUIRE_FALSE(tl::readCandidates(file_name, key));
+}
+
+namespace
+{
+std::string readFile(const std::string& file_name)
+{
+    auto in = std::ifstream{file_name, std::ios::binary};
+    return {std::istreambuf_iterator<char>(in),
+            std::istreambuf_iterator<char>()};
+}
+
+tl::TLPoint linePoint(const tl::Vec3d& pos, const tl::Vec3d& eivec)
+{
+    auto p = tl::TLPoint{};
+    p.pos = pos;
+    p.eivec = eivec;
+    p.cluster_size = 1;
+    return p;
+}
+} // namespace
+
+TEST_CASE("Test streaming of tensor lines to a file")
+{
+    using tl::Vec3d;
+
+    auto x = Vec3d{1, 0, 0};
+    auto z = Vec3d{0, 0, 1};
+
+    SUBCASE("Points of a cell are connected by similar directions")
+    {
+        auto two = tl::connectCellPoints({x, z});
+        REQUIRE(two.lines.size() == 1);
+        REQUIRE(two.vertices.empty());
+
+        auto three = tl::connectCellPoints({x, z, Vec3d{1, 0, 0.01}});
+        REQUIRE(three.lines.size() == 1);
+        REQUIRE(three.lines[0] == std::array<std::size_t, 2>{0, 2});
+        REQUIRE(three.vertices == std::vector<std::size_t>{1});
+
+        auto one = tl::connectCellPoints({x});
+        REQUIRE(one.lines.empty());
+        REQUIRE(one.vertices == std::vector<std::size_t>{0});
+    }
+
+    SUBCASE("The points are grouped by cell in the VTK XML file")
+    {
+        auto file_name = std::string{"line_writer_test.vtp"};
+        {
+            auto writer = tl::StreamingLineWriter{file_name};
+            // Points 0 to 5, the points of cell 7 come from two faces
+            writer.addPoints(7, {linePoint({0, 0, 0}, x),
+                                 linePoint({1, 0, 0}, z)});
+            writer.addPoints(2, {linePoint({2, 0, 0}, x),
+                                 linePoint({3, 0, 0}, z)});
+            writer.addPoints(7, {linePoint({4, 0, 0}, x)});
+            writer.addPoints(5, {linePoint({5, 0, 0}, z)});
+            REQUIRE(writer.numPoints() == 6);
+            writer.finish();
+        }
+        auto data = readFile(file_name);
+        std::remove(file_name.c_str());
+
+        REQUIRE(data.find("NumberOfPoints=\"6\"") != std::string::npos);
+        REQUIRE(data.find("NumberOfVerts=\"2\"") != std::string::npos);
+        REQUIRE(data.find("NumberOfLines=\"2\"") != std::string::npos);
+
+        // Each array starts with its size at its offset into the appended
+        // data, and the arrays follow each other without gaps
+        const auto start = data.find('_', data.find("<AppendedData")) + 1;
+        const auto header = data.substr(0, start);
+        const auto array_regex = std::regex{
+                "Name=\"([^\"]+)\" NumberOfComponents=\"\\d+\" "
+                "format=\"appended\" offset=\"(\\d+)\""};
+        auto offset = uint64_t{0};
+        auto cell_arrays = std::vector<std::vector<int64_t>>{};
+        for(auto it = std::sregex_iterator(header.begin(),
+                                           header.end(),
+                                           array_regex);
+            it != std::sregex_iterator();
+            ++it)
+        {
+            const auto name = (*it)[1].str();
+            REQUIRE(std::stoull((*it)[2].str()) == offset);
+            auto size = uint64_t{0};
+            REQUIRE(start + offset + sizeof(size) <= data.size());
+            std::memcpy(&size, data.data() + start + offset, sizeof(size));
+            const auto* values = data.data() + start + offset + sizeof(size);
+            offset += sizeof(size) + size;
+            REQUIRE(start + offset <= data.size());
+
+            if(name == "Points")
+            {
+                REQUIRE(size == 6 * 3 * sizeof(double));
+            }
+            if(name == "connectivity" || name == "offsets")
+            {
+                cell_arrays.emplace_back(size / sizeof(int64_t));
+                std::memcpy(cell_arrays.back().data(), values, size);
+            }
+        }
+        REQUIRE(data.substr(start + offset)
+                == "\n  </AppendedData>\n</VTKFile>\n");
+
+        // Cell 2 has a segment and cell 5 a vertex. Of cell 7, the points
+        // with the same direction are connected.
+        REQUIRE(cell_arrays.size() == 4);
+        REQUIRE(cell_arrays[0] == std::vector<int64_t>{5, 1});
+        REQUIRE(cell_arrays[1] == std::vector<int64_t>{1, 2});
+        REQUIRE(cell_arrays[2] == std::vector<int64_t>{2, 3, 0, 4});
+        REQUIRE(cell_arrays[3] == std::vector<int64_t>{2, 4});
+    }
+}
+
+TEST_CASE("Test streaming of tensor lines to NumPy files")
+{
+    using tl::Vec3d;
+
+    auto prefix = std::string{"line_writer_test"};
+    {
+        auto writer = tl::StreamingLineWriter{
+                prefix, tl::LineFileFormat::Npy, {"pos", "line_stability"}};
+        writer.addPoints(3, {linePoint({0, 1, 2}, Vec3d{1, 0, 0}),
+                             linePoint({3, 4, 5}, Vec3d{0, 1, 0})});
+        writer.addPoints(4, {linePoint({6, 7, 8}, Vec3d{0, 0, 1})});
+        writer.finish();
+    }
+
+    // Suffix, shape of the array and number of values of each file
+    auto files = std::vector<std::tuple<std::string, std::string, uint64_t>>{
+            {".pos.npy", "(3, 3)", 9},
+            {".line_stability.npy", "(3,)", 3},
+            {".segments.npy", "(1, 2)", 2},
+            {".vertices.npy", "(1,)", 1}};
+    for(const auto& file : files)
+    {
+        auto file_name = prefix + std::get<0>(file);
+        auto data = readFile(file_name);
+        std::remove(file_name.c_str());
+
+        REQUIRE(data.size() == 128 + std::get<2>(file) * 8);
+        REQUIRE(data.substr(0, 8) == std::string{"\x93NUMPY\x01\x00", 8});
+        REQUIRE(uint8_t(data[8]) + 256 * uint8_t(data[9]) == 118);
+        REQUIRE(data[127] == '\n');
+        REQUIRE(data.find("'shape': " + std::get<1>(file) + ", }")
+                != std::string::npos);
+
+        if(std::get<0>(file) == ".pos.npy")
+        {
+            auto pos = std::array<double, 9>{};
+            std::memcpy(pos.data(), data.data() + 128, sizeof(pos));
+            for(auto i : range(9))
+            {
+                REQUIRE(pos[std::size_t(i)] == double(i));
+            }
+        }
+    }
+}
+
+namespace
+{
+/**
+ * Grid of two tetrahedra sharing a face with the tensor fields S and T, of
+ * which S is active.
+ */
+vtkSmartPointer<vtkUnstructuredGrid> makeTensorGrid()
+{
+    auto grid = vtkSmartPointer<vtkUnstructuredGrid>::New();
+    auto points = vtkSmartPointer<vtkPoints>::New();
+    points->InsertNextPoint(0., 0., 0.);
+    points->InsertNextPoint(1., 0., 0.);
+    points->InsertNextPoint(0., 1., 0.);
+    points->InsertNextPoint(0., 0., 1.);
+    points->InsertNextPoint(1., 1., 1.);
+    grid->SetPoints(points);
+
+    for(const auto& tet : {std::array<vtkIdType, 4>{0, 1, 2, 3},
+                           std::array<vtkIdType, 4>{1, 2, 3, 4}})
+    {
+        auto ids = vtkSmartPointer<vtkIdList>::New();
+        for(auto id : tet)
+        {
+            ids->InsertNextId(id);
+        }
+        grid->InsertNextCell(VTK_TETRA, ids);
+    }
+
+    for(const auto* name : {"T", "S"})
+    {
+        auto field = vtkSmartPointer<vtkDoubleArray>::New();
+        field->SetName(name);
+        field->SetNumberOfComponents(9);
+        field->SetNumberOfTuples(grid->GetNumberOfPoints());
+        for(auto i : range(field->GetNumberOfValues()))
+        {
+            field->SetValue(i, double(i) / 3. + (name[0] == 'S' ? 100. : 0.));
+        }
+        if(name[0] == 'S')
+        {
+            grid->GetPointData()->SetTensors(field);
+        }
+        else
+        {
+            grid->GetPointData()->AddArray(field);
+        }
+    }
+    return grid;
+}
+
+
+/**
+ * Overwrite the bytes of a file at @a offset with the object @a value
+ */
+template <typename T>
+void patchFile(const std::string& file_name, uint64_t offset, const T& value)
+{
+    auto data = readFile(file_name);
+    REQUIRE(offset + sizeof(value) <= data.size());
+    std::memcpy(&data[offset], &value, sizeof(value));
+    auto out = std::ofstream{file_name, std::ios::binary | std::ios::trunc};
+    out.write(data.data(), std::streamsize(data.size()));
+}
+} // namespace
+
+TEST_CASE("Test the binary tensor mesh file")
+{
+    auto file_name = std::string{"tensor_mesh_test.tlm"};
+    auto grid = makeTensorGrid();
+
+    SUBCASE("The mesh is read back unchanged")
+    {
+        for(auto single_precision : {false, true})
+        {
+            tl::writeTensorMesh(grid, file_name, single_precision);
+            auto mesh = tl::readTensorMesh(file_name);
+            REQUIRE(mesh.file);
+            REQUIRE(mesh.grid->GetNumberOfPoints() == 5);
+            REQUIRE(mesh.grid->GetNumberOfCells() == 2);
+
+            auto p = std::array<double, 3>{};
+            auto q = std::array<double, 3>{};
+            for(auto i : range(grid->GetNumberOfPoints()))
+            {
+                grid->GetPoint(i, p.data());
+                mesh.grid->GetPoint(i, q.data());
+                REQUIRE(p == q);
+            }
+
+            auto ids = vtkSmartPointer<vtkIdList>::New();
+            auto read_ids = vtkSmartPointer<vtkIdList>::New();
+            for(auto c : range(grid->GetNumberOfCells()))
+            {
+                REQUIRE(mesh.grid->GetCellType(c) == VTK_TETRA);
+                grid->GetCellPoints(c, ids);
+                mesh.grid->GetCellPoints(c, read_ids);
+                REQUIRE(read_ids->GetNumberOfIds() == 4);
+                for(auto j : range(4))
+                {
+                    REQUIRE(read_ids->GetId(j) == ids->GetId(j));
+                }
+            }
+
+            // The active tensors are written first and active again
+            auto* point_data = mesh.grid->GetPointData();
+            REQUIRE(point_data->GetNumberOfArrays() == 2);
+            REQUIRE(point_data->GetTensors());
+            REQUIRE(std::string{point_data->GetTensors()->GetName()} == "S");
+            for(const auto* name : {"S", "T"})
+            {
+                auto* expected = grid->GetPointData()->GetArray(name);
+                auto* read = point_data->GetArray(name);
+                REQUIRE(read);
+                REQUIRE(read->GetNumberOfComponents() == 9);
+                REQUIRE(read->GetNumberOfTuples() == 5);
+                for(auto i : range(read->GetNumberOfTuples()))
+                {
+                    for(auto j : range(9))
+                    {
+                        const auto value = expected->GetComponent(i, j);
+                        REQUIRE(read->GetComponent(i, j)
+                                == (single_precision ? double(float(value))
+                                                     : value));
+                    }
+                }
+            }
+        }
+    }
+
+    SUBCASE("A damaged header is detected")
+    {
+        tl::writeTensorMesh(grid, file_name, false);
+        auto data = readFile(file_name);
+        auto header = tl::TensorMeshHeader{};
+        std::memcpy(&header, data.data(), sizeof(header));
+
+        SUBCASE("Wrong magic")
+        {
+            patchFile(file_name, 0, 'X');
+        }
+        SUBCASE("Points beyond the end of the file")
+        {
+            patchFile(file_name,
+                      offsetof(tl::TensorMeshHeader, num_points),
+                      uint64_t{1} << 40);
+        }
+        SUBCASE("Misaligned cells")
+        {
+            patchFile(file_name,
+                      offsetof(tl::TensorMeshHeader, cells_offset),
+                      header.cells_offset + 8);
+        }
+        SUBCASE("Truncated file")
+        {
+            auto out = std::ofstream{file_name,
+                                     std::ios::binary | std::ios::trunc};
+            out.write(data.data(), std::streamsize(data.size() - 8));
+        }
+        REQUIRE_THROWS_AS(tl::readTensorMesh(file_name), std::runtime_error);
+    }
+
+    SUBCASE("Cells with point ids out of range are detected")
+    {
+        tl::writeTensorMesh(grid, file_name, false);
+        auto header = tl::TensorMeshHeader{};
+        std::memcpy(&header, readFile(file_name).data(), sizeof(header));
+        // The last point id of the second cell
+        const auto offset = header.cells_offset + 9 * sizeof(int64_t);
+
+        for(auto id : {int64_t{5}, int64_t{-1}})
+        {
+            patchFile(file_name, offset, id);
+            REQUIRE_THROWS_AS(tl::readTensorMesh(file_name),
+                              std::runtime_error);
+        }
+        patchFile(file_name, offset, int64_t{4});
+        REQUIRE_NOTHROW(tl::readTensorMesh(file_name));
+    }
+
+    SUBCASE("A grid without tetrahedra is not written")
+    {
+        std::remove(file_name.c_str());
+        auto empty = vtkSmartPointer<vtkUnstructuredGrid>::New();
+        REQUIRE_THROWS_AS(tl::writeTensorMesh(empty, file_name, false),
+                          std::runtime_error);
+        REQUIRE_FALSE(std::ifstream{file_name});
+    }
+
+    std::remove(file_name.c_str());
+}
+
+TEST_CASE("Test the tag scanner of the VTK XML reader")
+{
+    using tl::detail::nextTag;
+
+    const auto text = std::string{
+            "<?xml version=\"1.0\"?>\n<!-- <Comment a=\"1\"> -->\n"
+            "<VTKFile type=\"UnstructuredGrid\" header_type = 'UInt64'>\n"
+            "  text <Piece NumberOfPoints=\"4\"/>\n"
+            "</VTKFile>"};
+    auto pos = std::size_t{0};
+
+    auto tag = nextTag(text.data(), text.size(), pos);
+    REQUIRE(tag);
+    REQUIRE(tag->name == "VTKFile");
+    REQUIRE_FALSE(tag->closing);
+    REQUIRE_FALSE(tag->self_closing);
+    REQUIRE(tag->attributes.size() == 2);
+    REQUIRE(tag->attribute("type") == "UnstructuredGrid");
+    REQUIRE(tag->attribute("header_type") == "UInt64");
+    REQUIRE(tag->attribute("compressor", "none") == "none");
+
+    tag = nextTag(text.data(), text.size(), pos);
+    REQUIRE(tag);
+    REQUIRE(tag->name == "Piece");
+    REQUIRE(tag->self_closing);
+    REQUIRE(tag->attribute("NumberOfPoints") == "4");
+
+    tag = nextTag(text.data(), text.size(), pos);
+    REQUIRE(tag);
+    REQUIRE(tag->name == "VTKFile");
+    REQUIRE(tag->closing);
+    REQUIRE(pos == text.size());
+    REQUIRE_FALSE(nextTag(text.data(), text.size(), pos));
+
+    // Malformed or cut off tags end the scan
+    for(const auto& bad : {std::string{"<Piece NumberOfPoints=4>"},
+                           std::string{"<Piece NumberOfPoints>"},
+                           std::string{"<Piece NumberOfPoints=\"4>"},
+                           std::string{"<Piece"},
+                           std::string{"<"}})
+    {
+        pos = 0;
+        REQUIRE_FALSE(nextTag(bad.data(), bad.size(), pos));
+    }
+}
+
+namespace
+{
+template <typename T>
+std::string toBytes(const std::vector<T>& values)
+{
+    return {reinterpret_cast<const char*>(values.data()),
+            values.size() * sizeof(T)};
+}
+
+
+/**
+ * Encode an array for the appended data section with 64 bit headers,
+ * optionally zlib compressed in blocks of @a block_size bytes.
+ */
+std::string encodeArray(const std::string& raw,
+                        bool compressed,
+                        std::size_t block_size)
+{
+    auto headers = std::vector<uint64_t>{};
+    auto data = std::string{};
+    if(!compressed)
+    {
+        headers.push_back(raw.size());
+        data = raw;
+    }
+    else
+    {
+        const auto num_blocks = (raw.size() + block_size - 1) / block_size;
+        headers = {num_blocks, block_size, raw.size() % block_size};
+        for(auto b : range(num_blocks))
+        {
+            const auto block = raw.substr(b * block_size, block_size);
+            auto size = compressBound(uLong(block.size()));
+            auto out = std::string(size, '\0');
+            REQUIRE(compress(reinterpret_cast<Bytef*>(&out[0]),
+                             &size,
+                             reinterpret_cast<const Bytef*>(block.data()),
+                             uLong(block.size()))
+                    == Z_OK);
+            headers.push_back(size);
+            data += out.substr(0, size);
+        }
+    }
+    return toBytes(headers) + data;
+}
+
+
+/**
+ * Tetrahedra to write as the pieces of a .vtu file. Each piece has the
+ * tensor field S, whose components depend on the position only.
+ */
+using TetPiece = std::vector<std::array<double, 3>>;
+
+std::array<double, 9> positionTensor(const std::array<double, 3>& p)
+{
+    auto t = std::array<double, 9>{};
+    for(auto j : range(t.size()))
+    {
+        t[j] = p[0] + 10. * p[1] + 100. * p[2] + 1000. * double(j);
+    }
+    return t;
+}
+
+
+std::string vtuFile(const std::vector<TetPiece>& pieces,
+                    bool compressed,
+                    std::size_t block_size = 64)
+{
+    auto xml = std::string{
+            "<?xml version=\"1.0\"?>\n<VTKFile type=\"UnstructuredGrid\" "
+            "version=\"1.0\" byte_order=\"LittleEndian\" "
+            "header_type=\"UInt64\""};
+    if(compressed)
+    {
+        xml += " compressor=\"vtkZLibDataCompressor\"";
+    }
+    xml += ">\n<UnstructuredGrid>\n";
+
+    auto appended = std::string{};
+    auto array = [&](const std::string& type,
+                     const std::string& name,
+                     int num_components,
+                     const std::string& raw) {
+        xml += "<DataArray type=\"" + type + "\" Name=\"" + name
+               + "\" NumberOfComponents=\"" + std::to_string(num_components)
+               + "\" format=\"appended\" offset=\""
+               + std::to_string(appended.size()) + "\"/>\n";
+        appended += encodeArray(raw, compressed, block_size);
+    };
+
+    for(const auto& piece : pieces)
+    {
+        auto coords = std::vector<double>{};
+        auto tensors = std::vector<double>{};
+        for(const auto& p : piece)
+        {
+            coords.insert(coords.end(), p.begin(), p.end());
+            const auto t = positionTensor(p);
+            tensors.insert(tensors.end(), t.begin(), t.end());
+        }
+        auto connectivity = std::vector<int64_t>{};
+        auto offsets = std::vector<int64_t>{};
+        for(auto c : range(piece.size() / 4))
+        {
+            for(auto j : range(4))
+            {
+                connectivity.push_back(int64_t(4 * c + std::size_t(j)));
+            }
+            offsets.push_back(int64_t(connectivity.size()));
+        }
+        const auto types = std::string(piece.size() / 4, char(VTK_TETRA));
+
+        xml += "<Piece NumberOfPoints=\"" + std::to_string(piece.size())
+               + "\" NumberOfCells=\"" + std::to_string(piece.size() / 4)
+               + "\">\n<PointData Tensors=\"S\">\n";
+        array("Float64", "S", 9, toBytes(tensors));
+        xml += "</PointData>\n<Points>\n";
+        array("Float64", "Points", 3, toBytes(coords));
+        xml += "</Points>\n<Cells>\n";
+        array("Int64", "connectivity", 1, toBytes(connectivity));
+        array("Int64", "offsets", 1, toBytes(offsets));
+        array("UInt8", "types", 1, types);
+        xml += "</Cells>\n</Piece>\n";
+    }
+    return xml + "</UnstructuredGrid>\n<AppendedData encoding=\"raw\">\n_"
+           + appended + "\n</AppendedData>\n</VTKFile>\n";
+}
+
+
+void writeFile(const std::string& file_name, const std::string& data)
+{
+    auto out = std::ofstream{file_name, std::ios::binary | std::ios::trunc};
+    out.write(data.data(), std::streamsize(data.size()));
+}
+} // namespace
+
+TEST_CASE("Test the parallel VTK XML reader")
+{
+    auto file_name = std::string{"vtu_reader_test.vtu"};
+    // Two tetrahedra sharing a face, each in its own piece
+    const auto pieces = std::vector<TetPiece>{
+            {{0., 0., 0.}, {1., 0., 0.}, {0., 1., 0.}, {0., 0., 1.}},
+            {{1., 0., 0.}, {0., 1., 0.}, {0., 0., 1.}, {1., 1., 1.}}};
+
+    auto check_grid = [&](vtkUnstructuredGrid* grid,
+                          std::size_t num_points,
+                          const std::vector<TetPiece>& cells) {
+        REQUIRE(grid);
+        REQUIRE(grid->GetNumberOfPoints() == vtkIdType(num_points));
+        REQUIRE(grid->GetNumberOfCells() == vtkIdType(cells.size()));
+        auto* tensors = grid->GetPointData()->GetTensors();
+        REQUIRE(tensors);
+        REQUIRE(std::string{tensors->GetName()} == "S");
+
+        auto ids = vtkSmartPointer<vtkIdList>::New();
+        auto p = std::array<double, 3>{};
+        auto t = std::array<double, 9>{};
+        for(auto c : range(cells.size()))
+        {
+            REQUIRE(grid->GetCellType(vtkIdType(c)) == VTK_TETRA);
+            grid->GetCellPoints(vtkIdType(c), ids);
+            REQUIRE(ids->GetNumberOfIds() == 4);
+            for(auto j : range(4))
+            {
+                grid->GetPoint(ids->GetId(j), p.data());
+                REQUIRE(p == cells[c][std::size_t(j)]);
+                tensors->GetTuple(ids->GetId(j), t.data());
+                REQUIRE(t == positionTensor(p));
+            }
+        }
+    };
+
+    SUBCASE("A single piece is read")
+    {
+        for(auto compressed : {false, true})
+        {
+            writeFile(file_name, vtuFile({pieces[0]}, compressed));
+            check_grid(tl::readVtu(file_name), 4, {pieces[0]});
+        }
+    }
+
+    SUBCASE("Compressed arrays of several blocks are read")
+    {
+        // The blocks split values, the tensors take 5 blocks with a short
+        // last one, the types fit a single block.
+        writeFile(file_name, vtuFile(pieces, true, 60));
+        check_grid(tl::readVtu(file_name), 5, pieces);
+    }
+
+    SUBCASE("The points shared by pieces are merged")
+    {
+        for(auto compressed : {false, true})
+        {
+            writeFile(file_name, vtuFile(pieces, compressed));
+            check_grid(tl::readVtu(file_name), 5, pieces);
+        }
+    }
+
+    SUBCASE("Damaged appended data is detected")
+    {
+        auto data = vtuFile({pieces[0]}, true, 60);
+        const auto start = data.find("\n_") + 2;
+        // The header of the tensors, which are the first array
+        auto header = std::array<uint64_t, 3>{};
+        std::memcpy(header.data(), data.data() + start, sizeof(header));
+        REQUIRE(header[0] == 5);
+        REQUIRE(header[1] == 60);
+        REQUIRE(header[2] == 48);
+
+        auto patch = [&](std::size_t index, uint64_t value) {
+            std::memcpy(&data[start + 8 * index], &value, sizeof(value));
+        };
+        SUBCASE("Too many blocks")
+        {
+            patch(0, uint64_t{1} << 60);
+        }
+        SUBCASE("Blocks that do not add up to the array")
+        {
+            patch(0, 4);
+        }
+        SUBCASE("A last block larger than the others")
+        {
+            patch(2, 61);
+        }
+        SUBCASE("A block size of zero")
+        {
+            patch(1, 0);
+        }
+        SUBCASE("A compressed size beyond the end of the file")
+        {
+            patch(3, data.size());
+        }
+        SUBCASE("Corrupted compressed data")
+        {
+            data[start + 8 * 8 + 2] ^= 0x55;
+        }
+        writeFile(file_name, data);
+        REQUIRE_THROWS_AS(tl::readVtu(file_name), std::runtime_error);
+    }
+
+    SUBCASE("Cells with point ids out of range are detected")
+    {
+        auto data = vtuFile({pieces[0]}, false);
+        // The first id of the connectivity follows the tensors, the points
+        // and its own header
+        const auto start = data.find("\n_") + 2 + (8 + 4 * 9 * 8)
+                           + (8 + 4 * 3 * 8) + 8;
+        auto id = int64_t{4};
+        std::memcpy(&data[start], &id, sizeof(id));
+        writeFile(file_name, data);
+        REQUIRE_THROWS_AS(tl::readVtu(file_name), std::runtime_error);
+    }
+
+    std::remove(file_name.c_str());
+}
+
+TEST_CASE("Test the face queues of the NUMA nodes")
+{
+    // Faces in reverse order, one thread on node 0, none on node 1 and three
+    // on node 2
+    auto order = std::vector<std::size_t>(10);
+    for(auto i : range(order.size()))
+    {
+        order[i] = order.size() - 1 - i;
+    }
+    auto queues = tl::NumaFaceQueues{order, {1, 0, 3}};
+
+    SUBCASE("The nodes own contiguous ranges sized by their threads")
+    {
+        using Range = std::pair<std::size_t, std::size_t>;
+        REQUIRE(queues.faceRange(0) == Range{0, 2});
+        REQUIRE(queues.faceRange(1) == Range{2, 2});
+        REQUIRE(queues.faceRange(2) == Range{2, 10});
+    }
+
+    SUBCASE("A node takes its faces in order, then those of the others")
+    {
+        auto face = std::size_t{0};
+        auto taken = std::vector<std::size_t>{};
+        while(queues.next(0, face))
+        {
+            taken.push_back(face);
+        }
+        REQUIRE(taken
+                == std::vector<std::size_t>{1, 0, 9, 8, 7, 6, 5, 4, 3, 2});
+        REQUIRE_FALSE(queues.next(1, face));
+        REQUIRE_FALSE(queues.next(2, face));
+    }
+
+    SUBCASE("Each face is taken once by concurrent threads")
+    {
+        auto counts = std::vector<int>(order.size(), 0);
+#pragma omp parallel for
+        for(auto t = 0; t < 8; ++t)
+        {
+            auto face = std::size_t{0};
+            while(queues.next(std::size_t(t % 3), face))
+            {
+#pragma omp atomic
+                ++counts[face];
+            }
+        }
+        REQUIRE(std::all_of(
+                counts.begin(), counts.end(), [](int n) { return n == 1; }));
+    }
+
+    SUBCASE("Each face is searched once with its own input")
+    {
+        for(auto numa_local : {false, true})
+        {
+            auto searched = std::vector<int>(order.size(), 0);
+            tl::forEachFace(
+                    order,
+                    numa_local,
+                    [](std::size_t i) { return 2 * i; },
+                    [&](std::size_t i, std::size_t input) {
+                        REQUIRE(input == 2 * i);
+#pragma omp atomic
+                        ++searched[i];
+                    });
+            REQUIRE(std::all_of(searched.begin(),
+                                searched.end(),
+                                [](int n) { return n == 1; }));
+        }
+    }
+
+    SUBCASE("Threads are assigned to the nodes in contiguous groups")
+    {
+        const auto num_nodes = tl::numNumaNodes();
+        auto previous = std::size_t{0};
+        for(auto thread : range(std::size_t{64}))
+        {
+            const auto node = tl::threadNumaNode(thread, 64);
+            REQUIRE(node < num_nodes);
+            REQUIRE(node >= previous);
+            previous = node;
+        }
+    }
+}
@@ -16,6 +16,33 @@
 
 #define BOOST_RESULT_OF_USE_DECLTYPE
 
+/**
+ * Compile a function for several instruction sets and select the best one
+ * supported by the CPU when the program is loaded. Used for the subdivision
+ * kernels, so that a single binary uses AVX2 or AVX-512 where available.
+ *
+ * All calls inside the function are inlined, so that the called templates
+ * are compiled for the same instruction set. Must only be used for non-template
+ * functions, since the compiler silently ignores it for templates that are
+ * instantiated before their definition.
+ */
+#if defined(TL_ENABLE_TARGET_CLONES) && defined(__GNUC__) \
+        && defined(__x86_64__) && defined(__linux__)
+#define TL_TARGET_CLONES \
+    __attribute__((target_clones("avx512f", "avx2", "default"), flatten))
+#else
+#define TL_TARGET_CLONES
+#endif
+
+/**
+ * Defined if the compiler supports vector types with element-wise operators
+ * (GCC and Clang). They are used to process several subdivision candidates
+ * at once (see Lanes).
+ */
+#if defined(__GNUC__)
+#define TL_HAS_VECTOR_TYPES
+#endif
+
 namespace tl
 {
 
@@ -1,5 +1,8 @@
 #include "vtkTensorLines.h"
 
+#include "CandidateCache.hh"
+#include "LineWriter.hh"
+#include "NumaScheduling.hh"
 #include "TensorLines.hh"
 #include "utils.hh"
 
@@ -30,9 +33,15 @@
 #include <algorithm>
 #include <array>
 #include <chrono>
+#include <cmath>
+#include <iomanip>
 #include <iostream>
+#include <limits>
 #include <list>
 #include <map>
+#include <memory>
+#include <numeric>
+#include <sstream>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -54,6 +63,79 @@ struct TriFace
 };
 
 
+/**
+ * Spread the lowest 21 bits of a number to every third bit
+ */
+uint64_t spreadBits(uint64_t x)
+{
+    x &= 0x1fffff;
+    x = (x | x << 32) & 0x1f00000000ffff;
+    x = (x | x << 16) & 0x1f0000ff0000ff;
+    x = (x | x << 8) & 0x100f00f00f00f00f;
+    x = (x | x << 4) & 0x10c30c30c30c30c3;
+    x = (x | x << 2) & 0x1249249249249249;
+    return x;
+}
+
+
+/**
+ * @brief Order of the faces along a Morton (Z-order) curve of their centroids.
+ *
+ * @param faces Faces to order
+ * @param dataset Dataset containing the points of the faces
+ * @return Indices of the faces in Morton order
+ */
+std::vector<std::size_t> mortonOrder(const std::vector<TriFace>& faces,
+                                     vtkDataSet* dataset)
+{
+    auto centroids = std::vector<Vec3d>(faces.size());
+#pragma omp parallel for
+    for(auto i = std::size_t{0}; i < faces.size(); ++i)
+    {
+        auto sum = Vec3d{Vec3d::Zero()};
+        for(auto id : faces[i].points)
+        {
+            auto p = Vec3d{};
+            dataset->GetPoint(id, p.data());
+            sum += p;
+        }
+        centroids[i] = sum / 3.;
+    }
+
+    auto lower = Vec3d{Vec3d::Constant(std::numeric_limits<double>::max())};
+    auto upper = Vec3d{Vec3d::Constant(-std::numeric_limits<double>::max())};
+    for(const auto& c : centroids)
+    {
+        lower = lower.cwiseMin(c);
+        upper = upper.cwiseMax(c);
+    }
+    const auto extent = (upper - lower).maxCoeff();
+    const auto scale = extent > 0. ? double(0x1fffff) / extent : 0.;
+
+    auto codes = std::vector<uint64_t>(faces.size());
+#pragma omp parallel for
+    for(auto i = std::size_t{0}; i < faces.size(); ++i)
+    {
+        const auto q = ((centroids[i] - lower) * scale).eval();
+        codes[i] = spreadBits(uint64_t(q[0])) | spreadBits(uint64_t(q[1])) << 1
+                   | spreadBits(uint64_t(q[2])) << 2;
+    }
+
+    auto order = std::vector<std::size_t>(faces.size());
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    std::stable_sort(order.begin(), order.end(), [&](auto a, auto b) {
+        return codes[a] < codes[b];
+    });
+    return order;
+}
+
+
+/**
+ * @brief Collect the four faces of each tetrahedron.
+ * @details The faces are sorted along a Morton curve of their centroids, so
+ *      that faces close in the list are close in space. The threads searching
+ *      consecutive faces then read nearby points and tensors.
+ */
 std::vector<TriFace> buildFaceList(vtkDataSet* dataset)
 {
     auto face_list = std::vector<TriFace>{};
@@ -88,7 +170,15 @@ std::vector<TriFace> buildFaceList(vtkDataSet* dataset)
         add_face(point_ids, cid, 0, 3, 1);
         add_face(point_ids, cid, 0, 2, 3);
     }
-    return face_list;
+
+    const auto order = mortonOrder(face_list, dataset);
+    auto sorted = std::vector<TriFace>{};
+    sorted.reserve(face_list.size());
+    for(auto i : order)
+    {
+        sorted.push_back(face_list[i]);
+    }
+    return sorted;
 }
 
 
@@ -168,52 +258,328 @@ computeCellDerivatives(vtkDataSet* dataset,
 }
 
 
-std::vector<tl::TLResult> computePEVPoints(const std::vector<TriFace>& faces,
-                                             vtkPoints* points,
-                                             vtkDataArray* array1,
-                                             vtkDataArray* array2,
-                                             vtkAlgorithm* progress_alg,
-                                             const tl::TLOptions& opts)
+/**
+ * Read the tensors of all points and compute the per-point quantities shared
+ * by the incident faces.
+ */
+tl::PointTensors computePointTensors(vtkDataArray* tensors)
+{
+    const auto n = tensors->GetNumberOfTuples();
+    auto result = tl::PointTensors(as_unsigned(n));
+#pragma omp parallel for
+    for(auto i = vtkIdType{0}; i < n; ++i)
+    {
+        auto t = Mat3d{};
+        tensors->GetTuple(i, t.data());
+        result.set(as_unsigned(i), t);
+    }
+    return result;
+}
+
+
+std::array<std::size_t, 3> pointIds(const TriFace& face)
+{
+    return {as_unsigned(face.points[0]),
+            as_unsigned(face.points[1]),
+            as_unsigned(face.points[2])};
+}
+
+
+/**
+ * @brief Order in which to search the faces, the most expensive first.
+ * @details The search cost of a face varies by orders of magnitude and is hard
+ *      to predict from the tensors, so it is estimated by the number of splits
+ *      of the face in the last run. Searching the expensive faces first keeps
+ *      them from delaying the end of the search. Faces of equal cost keep
+ *      their order, without statistics all of them.
+ *
+ * @param num_faces Number of faces to search
+ * @param last_splits Number of splits of each face in the last run, or empty
+ * @return Indices of the faces in search order
+ */
+std::vector<std::size_t> searchOrder(std::size_t num_faces,
+                                     const std::vector<uint64_t>& last_splits)
+{
+    auto order = std::vector<std::size_t>(num_faces);
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    if(!last_splits.empty())
+    {
+        std::stable_sort(order.begin(), order.end(), [&](auto a, auto b) {
+            return last_splits[a] > last_splits[b];
+        });
+    }
+    return order;
+}
+
+
+/**
+ * Copy the coordinates of all points.
+ */
+std::vector<double> pointCoordinates(vtkPoints* points)
+{
+    const auto n = points->GetNumberOfPoints();
+    auto coords = std::vector<double>(as_unsigned(3 * n));
+    for(auto i : range(n))
+    {
+        points->GetPoint(i, &coords[as_unsigned(3 * i)]);
+    }
+    return coords;
+}
+
+
+/**
+ * Check whether the points have the given coordinates.
+ */
+bool samePoints(const std::vector<double>& coords, vtkPoints* points)
+{
+    if(coords.size() != as_unsigned(3 * points->GetNumberOfPoints()))
+    {
+        return false;
+    }
+    auto p = std::array<double, 3>{};
+    for(auto i : range(points->GetNumberOfPoints()))
+    {
+        points->GetPoint(i, p.data());
+        if(!std::equal(p.begin(), p.end(), &coords[as_unsigned(3 * i)]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/**
+ * @brief Flag the points whose tensor changed since the last run.
+ *
+ * @param previous Tensors of the last run
+ * @param current Tensors of this run
+ * @param threshold Largest change of a tensor component that is ignored
+ * @param changed Flags of the changed points
+ */
+void flagChangedPoints(const tl::PointTensors& previous,
+                       const tl::PointTensors& current,
+                       double threshold,
+                       std::vector<char>& changed)
+{
+    const auto n = current.tensors.size();
+#pragma omp parallel for
+    for(auto i = std::size_t{0}; i < n; ++i)
+    {
+        auto diff = current.tensors[i] - previous.tensors[i];
+        if(diff.cwiseAbs().maxCoeff() > threshold)
+        {
+            changed[i] = 1;
+        }
+    }
+}
+
+
+/**
+ * @brief Flag the cells whose tensor derivatives changed since the last run.
+ *
+ * @param previous Derivatives of the last run
+ * @param current Derivatives of this run
+ * @param threshold Largest change of a derivative component that is ignored
+ * @param changed Flags of the changed cells
+ */
+void flagChangedCells(
+        const std::array<vtkSmartPointer<vtkDoubleArray>, 3>& previous,
+        const std::array<vtkSmartPointer<vtkDoubleArray>, 3>& current,
+        double threshold,
+        std::vector<char>& changed)
+{
+    for(auto d : range(3))
+    {
+        const auto ncomps = current[d]->GetNumberOfComponents();
+        const auto ncells = current[d]->GetNumberOfTuples();
+#pragma omp parallel for
+        for(auto c = vtkIdType{0}; c < ncells; ++c)
+        {
+            for(auto j = vtkIdType{0}; j < ncomps; ++j)
+            {
+                auto v = c * ncomps + j;
+                if(std::abs(current[d]->GetValue(v) - previous[d]->GetValue(v))
+                   > threshold)
+                {
+                    changed[as_unsigned(c)] = 1;
+                }
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief Replace the tensors of the flagged points.
+ * @details The other points keep the tensors of the last run in which they
+ *      were flagged, so that changes below the threshold are still detected
+ *      once they add up.
+ *
+ * @param current Tensors of this run
+ * @param changed Flags of the changed points
+ * @param previous Tensors to compare the next run with
+ */
+void updateChangedPoints(const tl::PointTensors& current,
+                         const std::vector<char>& changed,
+                         tl::PointTensors& previous)
+{
+    const auto n = current.tensors.size();
+#pragma omp parallel for
+    for(auto i = std::size_t{0}; i < n; ++i)
+    {
+        if(changed[i])
+        {
+            previous.tensors[i] = current.tensors[i];
+            previous.operator_norms[i] = current.operator_norms[i];
+        }
+    }
+}
+
+
+/**
+ * @brief Replace the tensor derivatives of the flagged cells.
+ *
+ * @param current Derivatives of this run
+ * @param changed Flags of the changed cells
+ * @param previous Derivatives to compare the next run with
+ */
+void updateChangedCells(
+        const std::array<vtkSmartPointer<vtkDoubleArray>, 3>& current,
+        const std::vector<char>& changed,
+        std::array<vtkSmartPointer<vtkDoubleArray>, 3>& previous)
+{
+    for(auto d : range(3))
+    {
+        const auto ncomps = current[d]->GetNumberOfComponents();
+        const auto ncells = current[d]->GetNumberOfTuples();
+#pragma omp parallel for
+        for(auto c = vtkIdType{0}; c < ncells; ++c)
+        {
+            if(changed[as_unsigned(c)])
+            {
+                for(auto j = vtkIdType{0}; j < ncomps; ++j)
+                {
+                    auto v = c * ncomps + j;
+                    previous[d]->SetValue(v, current[d]->GetValue(v));
+                }
+            }
+        }
+    }
+}
+
+
+/// Unclustered candidates of each face
+using CandidateList = std::vector<tl::TLCandidates>;
+
+
+/**
+ * @brief Prepare the list of candidates for the face loop.
+ * @details If the list holds the candidates of all faces, they are clustered
+ *      without searching again. Otherwise it is resized to store the
+ *      candidates of the search.
+ *
+ * @param candidates The candidates or nullptr if they are not kept
+ * @param num_faces Number of faces
+ * @return Whether the faces have to be searched
+ */
+bool prepareCandidates(CandidateList* candidates, std::size_t num_faces)
+{
+    if(candidates && candidates->size() == num_faces)
+    {
+        return false;
+    }
+    if(candidates)
+    {
+        candidates->assign(num_faces, tl::TLCandidates{});
+    }
+    return true;
+}
+
+
+/// Corners of a face
+std::array<Vec3d, 3> faceCorners(vtkPoints* points, const TriFace& face)
+{
+    auto corners = std::array<Vec3d, 3>{};
+    for(auto i : range(3))
+    {
+        points->GetPoint(face.points[i], corners[i].data());
+    }
+    return corners;
+}
+
+
+/// Input of the search for parallel eigenvectors on a face
+struct PEVFaceInput
+{
+    std::array<Vec3d, 3> corners;
+    tl::VertexTensors s;
+    tl::VertexTensors t;
+};
+
+
+/// Input of the search for tensor core lines on a face
+struct TCLFaceInput
+{
+    std::array<Vec3d, 3> corners;
+    tl::VertexTensors t;
+    std::array<tl::Mat3d, 3> dt;
+};
+
+
+/// Input of the search for degenerate lines on a face
+struct TopoFaceInput
+{
+    std::array<Vec3d, 3> corners;
+    tl::VertexTensors t;
+};
+
+
+std::vector<tl::TLResult> computePEVPoints(
+        const std::vector<TriFace>& faces,
+        const std::vector<std::size_t>& order,
+        bool numa_local,
+        vtkPoints* points,
+        const tl::PointTensors& s,
+        const tl::PointTensors& t,
+        tl::FaceResultCache* cache,
+        CandidateList* candidates,
+        vtkAlgorithm* progress_alg,
+        const tl::TLOptions& opts)
 {
     const auto step = 1. / double(faces.size());
     progress_alg->UpdateProgress(0);
     auto results = std::vector<tl::TLResult>(faces.size());
     auto terminate = false;
-#pragma omp parallel for schedule(guided, 1)
-    for(auto i = std::size_t{0}; i < faces.size(); ++i)
-    {
+    const auto search = prepareCandidates(candidates, faces.size());
+    auto gather = [&](std::size_t i) {
+        const auto ids = pointIds(faces[i]);
+        return PEVFaceInput{
+                faceCorners(points, faces[i]), s.face(ids), t.face(ids)};
+    };
+    auto search_face = [&](std::size_t i, const PEVFaceInput& face) {
 #pragma omp flush(terminate)
-        if(terminate) continue;
-
-        auto face = faces[i];
-
-        auto p1 = Vec3d{};
-        points->GetPoint(face.points[0], p1.data());
-        auto p2 = Vec3d{};
-        points->GetPoint(face.points[1], p2.data());
-        auto p3 = Vec3d{};
-        points->GetPoint(face.points[2], p3.data());
-
-        auto s1 = Mat3d{};
-        array1->GetTuple(face.points[0], s1.data());
-        auto s2 = Mat3d{};
-        array1->GetTuple(face.points[1], s2.data());
-        auto s3 = Mat3d{};
-        array1->GetTuple(face.points[2], s3.data());
-
-        auto t1 = Mat3d{};
-        array2->GetTuple(face.points[0], t1.data());
-        auto t2 = Mat3d{};
-        array2->GetTuple(face.points[1], t2.data());
-        auto t3 = Mat3d{};
-        array2->GetTuple(face.points[2], t3.data());
-
-        auto points = tl::findParallelEigenvectors(
-                {s1, s2, s3},
-                {t1, t2, t3},
-                {p1, p2, p3},
-                opts);
-        results[i] = points;
+        if(terminate) return;
+
+        auto result = tl::TLResult{};
+        if(candidates)
+        {
+            auto& cands = (*candidates)[i];
+            if(search)
+            {
+                cands = tl::searchParallelEigenvectors(face.s, face.t, opts);
+            }
+            result = tl::clusterParallelEigenvectors(
+                    cands, face.s, face.t, face.corners, opts);
+        }
+        else
+        {
+            result = cache ? cache->findParallelEigenvectors(
+                                     face.s, face.t, face.corners, opts)
+                           : tl::findParallelEigenvectors(
+                                     face.s, face.t, face.corners, opts);
+        }
+        results[i] = result;
 #pragma omp critical(progress)
         {
             progress_alg->UpdateProgress(progress_alg->GetProgress() + step);
@@ -223,46 +589,35 @@ std::vector<tl::TLResult> computePEVPoints(const std::vector<TriFace>& faces,
                 terminate = true;
             }
         }
-    }
+    };
+    // Each face only writes its own result, so the results and the output
+    // built from them in face order do not depend on the order or schedule
+    tl::forEachFace(order, numa_local, gather, search_face);
     return results;
 }
 
 
-std::vector<tl::TLResult> computeTCLPoints(const std::vector<TriFace>& faces,
-                                             vtkPoints* points,
-                                             vtkDataArray* tensors,
-                                             vtkDataArray* tx,
-                                             vtkDataArray* ty,
-                                             vtkDataArray* tz,
-                                             vtkAlgorithm* progress_alg,
-                                             const tl::TLOptions& opts)
+std::vector<tl::TLResult> computeTCLPoints(
+        const std::vector<TriFace>& faces,
+        const std::vector<std::size_t>& order,
+        bool numa_local,
+        vtkPoints* points,
+        const tl::PointTensors& tensors,
+        vtkDataArray* tx,
+        vtkDataArray* ty,
+        vtkDataArray* tz,
+        tl::FaceResultCache* cache,
+        CandidateList* candidates,
+        vtkAlgorithm* progress_alg,
+        const tl::TLOptions& opts)
 {
     const auto step = 1. / double(faces.size());
     progress_alg->UpdateProgress(0);
     auto results = std::vector<tl::TLResult>(faces.size());
     auto terminate = false;
-#pragma omp parallel for
-    for(auto i = std::size_t{0}; i < faces.size(); ++i)
-    {
-#pragma omp flush(terminate)
-        if(terminate) continue;
-
-        auto face = faces[i];
-
-        auto p1 = Vec3d{};
-        points->GetPoint(face.points[0], p1.data());
-        auto p2 = Vec3d{};
-        points->GetPoint(face.points[1], p2.data());
-        auto p3 = Vec3d{};
-        points->GetPoint(face.points[2], p3.data());
-
-        auto s1 = Mat3d{};
-        tensors->GetTuple(face.points[0], s1.data());
-        auto s2 = Mat3d{};
-        tensors->GetTuple(face.points[1], s2.data());
-        auto s3 = Mat3d{};
-        tensors->GetTuple(face.points[2], s3.data());
-
+    const auto search = prepareCandidates(candidates, faces.size());
+    auto gather = [&](std::size_t i) {
+        const auto& face = faces[i];
         auto sx = Mat3d{};
         tx->GetTuple(face.cellId, sx.data());
 
@@ -272,12 +627,33 @@ std::vector<tl::TLResult> computeTCLPoints(const std::vector<TriFace>& faces,
         auto sz = Mat3d{};
         tz->GetTuple(face.cellId, sz.data());
 
-        auto points = tl::findTensorCoreLines(
-                {s1, s2, s3},
-                {sx, sy, sz},
-                {p1, p2, p3},
-                opts);
-        results[i] = points;
+        return TCLFaceInput{faceCorners(points, face),
+                            tensors.face(pointIds(face)),
+                            {sx, sy, sz}};
+    };
+    auto search_face = [&](std::size_t i, const TCLFaceInput& face) {
+#pragma omp flush(terminate)
+        if(terminate) return;
+
+        auto result = tl::TLResult{};
+        if(candidates)
+        {
+            auto& cands = (*candidates)[i];
+            if(search)
+            {
+                cands = tl::searchTensorCoreLines(face.t, face.dt, opts);
+            }
+            result = tl::clusterTensorCoreLines(
+                    cands, face.t, face.dt, face.corners, opts);
+        }
+        else
+        {
+            result = cache ? cache->findTensorCoreLines(
+                                     face.t, face.dt, face.corners, opts)
+                           : tl::findTensorCoreLines(
+                                     face.t, face.dt, face.corners, opts);
+        }
+        results[i] = result;
 #pragma omp critical(progress)
         {
             progress_alg->UpdateProgress(progress_alg->GetProgress() + step);
@@ -287,47 +663,53 @@ std::vector<tl::TLResult> computeTCLPoints(const std::vector<TriFace>& faces,
                 terminate = true;
             }
         }
-    }
+    };
+    tl::forEachFace(order, numa_local, gather, search_face);
     return results;
 }
 
-std::vector<tl::TLResult> computeTopoPoints(const std::vector<TriFace>& faces,
-                                            vtkPoints* points,
-                                            vtkDataArray* tensors,
-                                            vtkAlgorithm* progress_alg,
-                                            const tl::TLOptions& opts)
+std::vector<tl::TLResult> computeTopoPoints(
+        const std::vector<TriFace>& faces,
+        const std::vector<std::size_t>& order,
+        bool numa_local,
+        vtkPoints* points,
+        const tl::PointTensors& tensors,
+        tl::FaceResultCache* cache,
+        CandidateList* candidates,
+        vtkAlgorithm* progress_alg,
+        const tl::TLOptions& opts)
 {
     const auto step = 1. / double(faces.size());
     progress_alg->UpdateProgress(0);
     auto results = std::vector<tl::TLResult>(faces.size());
     auto terminate = false;
-#pragma omp parallel for
-    for(auto i = std::size_t{0}; i < faces.size(); ++i)
-    {
+    const auto search = prepareCandidates(candidates, faces.size());
+    auto gather = [&](std::size_t i) {
+        return TopoFaceInput{faceCorners(points, faces[i]),
+                             tensors.face(pointIds(faces[i]))};
+    };
+    auto search_face = [&](std::size_t i, const TopoFaceInput& face) {
 #pragma omp flush(terminate)
-        if(terminate) continue;
-
-        auto face = faces[i];
-
-        auto p1 = Vec3d{};
-        points->GetPoint(face.points[0], p1.data());
-        auto p2 = Vec3d{};
-        points->GetPoint(face.points[1], p2.data());
-        auto p3 = Vec3d{};
-        points->GetPoint(face.points[2], p3.data());
-
-        auto s1 = Mat3d{};
-        tensors->GetTuple(face.points[0], s1.data());
-        auto s2 = Mat3d{};
-        tensors->GetTuple(face.points[1], s2.data());
-        auto s3 = Mat3d{};
-        tensors->GetTuple(face.points[2], s3.data());
-
-        auto points = tl::findTensorTopology(
-                {s1, s2, s3},
-                {p1, p2, p3},
-                opts);
-        results[i] = points;
+        if(terminate) return;
+
+        auto result = tl::TLResult{};
+        if(candidates)
+        {
+            auto& cands = (*candidates)[i];
+            if(search)
+            {
+                cands = tl::searchTensorTopology(face.t, opts);
+            }
+            result = tl::clusterTensorTopology(cands, face.corners, opts);
+        }
+        else
+        {
+            result = cache ? cache->findTensorTopology(
+                                     face.t, face.corners, opts)
+                           : tl::findTensorTopology(
+                                     face.t, face.corners, opts);
+        }
+        results[i] = result;
 #pragma omp critical(progress)
         {
             progress_alg->UpdateProgress(progress_alg->GetProgress() + step);
@@ -337,12 +719,166 @@ std::vector<tl::TLResult> computeTopoPoints(const std::vector<TriFace>& faces,
                 terminate = true;
             }
         }
-    }
+    };
+    tl::forEachFace(order, numa_local, gather, search_face);
     return results;
 }
+
+
+/**
+ * Keys of the point attributes in the output: the selected ones, or all if
+ * none are selected, without those the options do not compute
+ */
+std::vector<std::string> outputAttributes(
+        const std::vector<std::string>& selected,
+        const tl::TLOptions& opts)
+{
+    auto keys = selected.empty() ? tl::lineAttributeKeys() : selected;
+    auto not_computed = [&](const std::string& key) {
+        return (!opts.compute_eigenvalues
+                && (key == "eigenvalue1" || key == "eigenvalue2"))
+               || (!opts.compute_ranks
+                   && (key == "rank1" || key == "rank2"
+                       || key == "imaginary1" || key == "imaginary2"))
+               || (!opts.compute_line_stability && key == "line_stability");
+    };
+    keys.erase(std::remove_if(keys.begin(), keys.end(), not_computed),
+               keys.end());
+    return keys;
 }
 
 
+/**
+ * @brief Fill the output with the points found on the faces and connect the
+ *      points of each cell to line segments.
+ * @details The points are ordered by face, then by their order in the result
+ *      of the face. The cells are ordered by cell ID, then by the order of
+ *      connectCellPoints(). The output is thus the same for any number of
+ *      threads and schedule of the searches.
+ */
+void buildLines(vtkPolyData* output,
+                const std::vector<TriFace>& faces,
+                const std::vector<tl::TLResult>& fresults)
+{
+    // Point and CellArrays for output dataset
+    output->SetPoints(vtkPoints::New());
+    output->SetVerts(vtkCellArray::New());
+    output->SetPolys(vtkCellArray::New());
+
+    // Output arrays for point information
+    auto eig_rank1 = vtkSmartPointer<vtkDoubleArray>::New();
+    eig_rank1->SetName("Rank1");
+    output->GetPointData()->AddArray(eig_rank1);
+    auto eig_rank2 = vtkSmartPointer<vtkDoubleArray>::New();
+    eig_rank2->SetName("Rank2");
+    output->GetPointData()->AddArray(eig_rank2);
+    auto eival1 = vtkSmartPointer<vtkDoubleArray>::New();
+    eival1->SetName("Eigenvalue 1");
+    output->GetPointData()->AddArray(eival1);
+    auto eival2 = vtkSmartPointer<vtkDoubleArray>::New();
+    eival2->SetName("Eigenvalue 2");
+    output->GetPointData()->AddArray(eival2);
+    auto eivec = vtkSmartPointer<vtkDoubleArray>::New();
+    eivec->SetName("Eigenvector");
+    eivec->SetNumberOfComponents(3);
+    output->GetPointData()->SetVectors(eivec);
+    auto imag1 = vtkSmartPointer<vtkDoubleArray>::New();
+    imag1->SetName("Imaginary 1");
+    output->GetPointData()->AddArray(imag1);
+    auto imag2 = vtkSmartPointer<vtkDoubleArray>::New();
+    imag2->SetName("Imaginary 2");
+    output->GetPointData()->AddArray(imag2);
+    auto csize = vtkSmartPointer<vtkUnsignedLongLongArray>::New();
+    csize->SetName("Cluster Size");
+    output->GetPointData()->AddArray(csize);
+    auto pos_unc = vtkSmartPointer<vtkDoubleArray>::New();
+    pos_unc->SetName("Position Uncertainty");
+    output->GetPointData()->AddArray(pos_unc);
+    auto dir_unc = vtkSmartPointer<vtkDoubleArray>::New();
+    dir_unc->SetName("Direction Uncertainty");
+    output->GetPointData()->AddArray(dir_unc);
+    auto stability = vtkSmartPointer<vtkDoubleArray>::New();
+    stability->SetName("Line Stability");
+    output->GetPointData()->AddArray(stability);
+
+    // map cell IDs to parallel eigenvector points found on their faces
+    auto cell_map = std::map<vtkIdType, vtkSmartPointer<vtkIdList>>{};
+
+    for(auto i : range(faces.size()))
+    {
+        const auto& pev_points = fresults[i];
+        auto cid = faces[i].cellId;
+        for(const auto& p : pev_points.points)
+        {
+            auto pid = output->GetPoints()->InsertNextPoint(p.pos.data());
+            eig_rank1->InsertValue(pid, double(p.s_rank));
+            eig_rank2->InsertValue(pid, double(p.t_rank));
+            eival1->InsertValue(pid, p.s_eival);
+            eival2->InsertValue(pid, p.t_eival);
+            eivec->InsertTuple(pid, p.eivec.data());
+            imag1->InsertValue(pid, p.s_has_imaginary ? 1. : 0.);
+            imag2->InsertValue(pid, p.t_has_imaginary ? 1. : 0.);
+            csize->InsertValue(pid, p.cluster_size);
+            pos_unc->InsertValue(pid, p.pos_uncertainty);
+            dir_unc->InsertValue(pid, p.dir_uncertainty);
+            stability->InsertValue(pid, p.line_stability);
+
+            if(!cell_map[cid].Get())
+            {
+                cell_map[cid] = vtkSmartPointer<vtkIdList>::New();
+            }
+            cell_map[cid]->InsertNextId(pid);
+        }
+    }
+
+    output->SetLines(vtkCellArray::New());
+
+    for(const auto& c : cell_map)
+    {
+        auto point_list = c.second;
+        auto npoints = point_list->GetNumberOfIds();
+        // Match points by eigenvector direction
+        auto eigdirs = std::vector<Vec3d>(std::size_t(npoints));
+        for(auto i : range(npoints))
+        {
+            eigdirs[std::size_t(i)] =
+                    Vec3dm{eivec->GetTuple(point_list->GetId(i))};
+        }
+        const auto connections = tl::connectCellPoints(eigdirs);
+        for(const auto& l : connections.lines)
+        {
+            auto line = std::array<vtkIdType, 2>{
+                    point_list->GetId(vtkIdType(l[0])),
+                    point_list->GetId(vtkIdType(l[1]))};
+            output->InsertNextCell(VTK_LINE, 2, line.data());
+        }
+
+        // Add vertices for unlinked points
+        for(auto i : connections.vertices)
+        {
+            output->InsertNextCell(
+                    VTK_VERTEX, 1, point_list->GetPointer(vtkIdType(i)));
+        }
+    }
+}
+}
+
+
+/// Data of the last run kept for incremental updates
+struct vtkTensorLines::IncrementalState
+{
+    // Options the results depend on
+    std::string key;
+    vtkIdType num_cells = 0;
+    std::vector<double> points;
+    std::vector<TriFace> faces;
+    tl::PointTensors tensors1;
+    tl::PointTensors tensors2;
+    std::array<vtkSmartPointer<vtkDoubleArray>, 3> derivs;
+    std::vector<tl::TLResult> results;
+};
+
+
 vtkStandardNewMacro(vtkTensorLines)
 
 
@@ -363,6 +899,9 @@ vtkTensorLines::vtkTensorLines()
 }
 
 
+vtkTensorLines::~vtkTensorLines() = default;
+
+
 vtkPolyData* vtkTensorLines::GetOutput()
 {
     return this->GetOutput(0);
@@ -550,47 +1089,6 @@ int vtkTensorLines::RequestData(vtkInformation* vtkNotUsed(request),
         return 0;
     }
 
-    // Point and CellArrays for output dataset
-    output->SetPoints(vtkPoints::New());
-    output->SetVerts(vtkCellArray::New());
-    output->SetPolys(vtkCellArray::New());
-
-    // Output arrays for point information
-    auto eig_rank1 = vtkSmartPointer<vtkDoubleArray>::New();
-    eig_rank1->SetName("Rank1");
-    output->GetPointData()->AddArray(eig_rank1);
-    auto eig_rank2 = vtkSmartPointer<vtkDoubleArray>::New();
-    eig_rank2->SetName("Rank2");
-    output->GetPointData()->AddArray(eig_rank2);
-    auto eival1 = vtkSmartPointer<vtkDoubleArray>::New();
-    eival1->SetName("Eigenvalue 1");
-    output->GetPointData()->AddArray(eival1);
-    auto eival2 = vtkSmartPointer<vtkDoubleArray>::New();
-    eival2->SetName("Eigenvalue 2");
-    output->GetPointData()->AddArray(eival2);
-    auto eivec = vtkSmartPointer<vtkDoubleArray>::New();
-    eivec->SetName("Eigenvector");
-    eivec->SetNumberOfComponents(3);
-    output->GetPointData()->SetVectors(eivec);
-    auto imag1 = vtkSmartPointer<vtkDoubleArray>::New();
-    imag1->SetName("Imaginary 1");
-    output->GetPointData()->AddArray(imag1);
-    auto imag2 = vtkSmartPointer<vtkDoubleArray>::New();
-    imag2->SetName("Imaginary 2");
-    output->GetPointData()->AddArray(imag2);
-    auto csize = vtkSmartPointer<vtkUnsignedLongLongArray>::New();
-    csize->SetName("Cluster Size");
-    output->GetPointData()->AddArray(csize);
-    auto pos_unc = vtkSmartPointer<vtkDoubleArray>::New();
-    pos_unc->SetName("Position Uncertainty");
-    output->GetPointData()->AddArray(pos_unc);
-    auto dir_unc = vtkSmartPointer<vtkDoubleArray>::New();
-    dir_unc->SetName("Direction Uncertainty");
-    output->GetPointData()->AddArray(dir_unc);
-    auto stability = vtkSmartPointer<vtkDoubleArray>::New();
-    stability->SetName("Line Stability");
-    output->GetPointData()->AddArray(stability);
-
     // // List of faces that might have non-line structures in separate output
     // output2->SetPoints(vtkPoints::New());
     // output2->GetPoints()->DeepCopy(input->GetPoints());
@@ -601,142 +1099,297 @@ int vtkTensorLines::RequestData(vtkInformation* vtkNotUsed(request),
     // direction->SetName("Direction");
     // output2->GetCellData()->AddArray(direction);
 
+    auto opts = tl::TLOptions{this->GetTolerance(),
+                                this->GetClusterEpsilon(),
+                                this->GetMaxCandidates(),
+                                this->GetCoarseLevels(),
+                                tl::StartMesh(this->GetStartMesh()),
+                                this->GetStartMeshLevel(),
+                                this->GetSeededSearch(),
+                                this->GetComputeEigenvalues(),
+                                this->GetComputeRanks(),
+                                this->GetComputeLineStability()};
+    auto search_key = this->SearchKey(array1, array2, opts);
+
+    // In incremental mode, the faces and results of the last run are kept if
+    // the mesh and the options did not change
+    auto results_key = std::ostringstream{};
+    results_key << std::hexfloat << search_key << "cluster epsilon "
+                << opts.cluster_epsilon << '\n'
+                << "context info " << opts.compute_eigenvalues
+                << opts.compute_ranks << opts.compute_line_stability << '\n';
+    auto* state = _incremental_state.get();
+    auto incremental = this->GetIncremental() && state
+                       && state->key == results_key.str()
+                       && state->num_cells == input->GetNumberOfCells()
+                       && samePoints(state->points, input->GetPoints());
+    if(!incremental)
+    {
+        _incremental_state.reset();
+        state = nullptr;
+    }
+
     // Copy faces to array for parallel looping
-    auto faces = buildFaceList(input);
+    auto faces = incremental ? std::move(state->faces) : buildFaceList(input);
     auto start = high_resolution_clock::now();
 
-    auto opts = tl::TLOptions{this->GetTolerance(),
-                                this->GetClusterEpsilon(),
-                                this->GetMaxCandidates()};
+    auto tensors1 = computePointTensors(array1);
+    auto tensors2 = _line_type == LineType::ParallelEigenvectors
+                            ? computePointTensors(array2)
+                            : tl::PointTensors{};
+    auto derivs = _line_type == LineType::TensorCoreLines
+                          ? computeCellDerivatives(input, array1->GetName())
+                          : std::array<vtkSmartPointer<vtkDoubleArray>, 3>{};
+
+    // Only search the faces whose tensors changed since the last run
+    auto search_ids = std::vector<std::size_t>{};
+    auto changed_faces = std::vector<TriFace>{};
+    auto changed_points = std::vector<char>{};
+    auto changed_cells = std::vector<char>{};
+    if(incremental)
+    {
+        const auto threshold = this->GetIncrementalThreshold();
+        changed_points.assign(tensors1.tensors.size(), 0);
+        flagChangedPoints(
+                state->tensors1, tensors1, threshold, changed_points);
+        flagChangedPoints(
+                state->tensors2, tensors2, threshold, changed_points);
+        changed_cells.assign(as_unsigned(input->GetNumberOfCells()), 0);
+        if(_line_type == LineType::TensorCoreLines)
+        {
+            flagChangedCells(state->derivs, derivs, threshold, changed_cells);
+        }
+
+        for(auto i : range(faces.size()))
+        {
+            const auto& face = faces[i];
+            if(changed_cells[as_unsigned(face.cellId)]
+               || changed_points[as_unsigned(face.points[0])]
+               || changed_points[as_unsigned(face.points[1])]
+               || changed_points[as_unsigned(face.points[2])])
+            {
+                search_ids.push_back(i);
+                changed_faces.push_back(face);
+            }
+        }
+    }
+    const auto& search_faces = incremental ? changed_faces : faces;
 
     auto fresults = std::vector<tl::TLResult>{};
 
+    auto cache = std::unique_ptr<tl::FaceResultCache>{};
+    if(this->GetCacheFaceResults())
+    {
+        cache.reset(new tl::FaceResultCache{});
+    }
+
+    // The candidates only depend on the input and the search options. If
+    // they match the last run, e.g. when only the cluster epsilon changed,
+    // the candidates are clustered again without searching.
+    auto input_time = std::ostringstream{};
+    input_time << "input time " << input->GetMTime() << ' '
+               << array1->GetMTime() << ' '
+               << (array2 ? array2->GetMTime() : 0) << '\n';
+    auto last_run_key = input_time.str() + search_key;
+    auto reused_candidates = false;
+    if(!incremental && _last_candidates_key == last_run_key
+       && _last_candidates.size() == faces.size())
+    {
+        reused_candidates = true;
+        std::cout << "Reusing the candidates of the last run, skipping the "
+                     "search" << std::endl;
+    }
+    else
+    {
+        _last_candidates.clear();
+        _last_candidates_key.clear();
+    }
+
+    // Otherwise load the candidates of a previous run on the same input file
+    auto cache_key = "input " + _candidate_cache_input + '\n' + search_key;
+    if(!incremental && !reused_candidates && !_candidate_cache_file.empty())
+    {
+        auto loaded = tl::readCandidates(_candidate_cache_file, cache_key);
+        if(loaded && loaded->size() == faces.size())
+        {
+            _last_candidates = std::move(loaded.value());
+            reused_candidates = true;
+            std::cout << "Loaded candidates from " << _candidate_cache_file
+                      << ", skipping the search" << std::endl;
+        }
+    }
+    // The face result cache memoizes the clustered results instead, and an
+    // incremental run only searches part of the faces
+    auto keep_candidates = this->GetKeepCandidates() && !cache && !incremental;
+    auto* candidates_ptr =
+            keep_candidates
+                            || (!incremental && !_candidate_cache_file.empty())
+                    ? &_last_candidates
+                    : nullptr;
+
+    // Search the expensive faces first if the last run searched the same
+    // faces
+    auto last_splits = std::vector<uint64_t>{};
+    if(_last_face_splits.size() == faces.size()
+       && std::any_of(_last_face_splits.begin(),
+                      _last_face_splits.end(),
+                      [](uint64_t n) { return n > 0; }))
+    {
+        if(incremental)
+        {
+            for(auto i : search_ids)
+            {
+                last_splits.push_back(_last_face_splits[i]);
+            }
+        }
+        else
+        {
+            last_splits = _last_face_splits;
+        }
+    }
+    const auto order = searchOrder(search_faces.size(), last_splits);
+    if(this->GetNumaLocal() && !tl::numaPinningAvailable())
+    {
+        vtkWarningMacro(<< "The threads can not be pinned to NUMA nodes on "
+                           "this machine, the faces are scheduled without "
+                           "NUMA locality");
+    }
+
     if(_line_type == LineType::TensorCoreLines)
     {
-        auto derivs = computeCellDerivatives(input, array1->GetName());
-        fresults = computeTCLPoints(faces,
+        fresults = computeTCLPoints(search_faces,
+                                   order,
+                                   this->GetNumaLocal(),
                                    input->GetPoints(),
-                                   array1,
+                                   tensors1,
                                    derivs[0],
                                    derivs[1],
                                    derivs[2],
+                                   cache.get(),
+                                   candidates_ptr,
                                    this,
                                    opts);
     }
     else if(_line_type == LineType::ParallelEigenvectors)
     {
-        fresults = computePEVPoints(
-                faces, input->GetPoints(), array1, array2, this, opts);
+        fresults = computePEVPoints(search_faces,
+                                    order,
+                                    this->GetNumaLocal(),
+                                    input->GetPoints(),
+                                    tensors1,
+                                    tensors2,
+                                    cache.get(),
+                                    candidates_ptr,
+                                    this,
+                                    opts);
     }
     else if(_line_type == LineType::TensorTopology)
     {
-        fresults = computeTopoPoints(
-                faces, input->GetPoints(), array1, this, opts);
+        fresults = computeTopoPoints(search_faces,
+                                     order,
+                                     this->GetNumaLocal(),
+                                     input->GetPoints(),
+                                     tensors1,
+                                     cache.get(),
+                                     candidates_ptr,
+                                     this,
+                                     opts);
     }
 
-    auto end_pointsearch = high_resolution_clock::now();
-
-    // map cell IDs to parallel eigenvector points found on their faces
-    auto cell_map = std::map<vtkIdType, vtkSmartPointer<vtkIdList>>{};
-
-    for(auto i : range(faces.size()))
+    if(incremental)
     {
-        auto pev_points = fresults[i];
-        auto cid = faces[i].cellId;
-        for(const auto& p : pev_points.points)
+        auto all_results = std::move(state->results);
+        for(auto i : range(search_ids.size()))
         {
-            auto pid = output->GetPoints()->InsertNextPoint(p.pos.data());
-            eig_rank1->InsertValue(pid, double(p.s_rank));
-            eig_rank2->InsertValue(pid, double(p.t_rank));
-            eival1->InsertValue(pid, p.s_eival);
-            eival2->InsertValue(pid, p.t_eival);
-            eivec->InsertTuple(pid, p.eivec.data());
-            imag1->InsertValue(pid, p.s_has_imaginary ? 1. : 0.);
-            imag2->InsertValue(pid, p.t_has_imaginary ? 1. : 0.);
-            csize->InsertValue(pid, p.cluster_size);
-            pos_unc->InsertValue(pid, p.pos_uncertainty);
-            dir_unc->InsertValue(pid, p.dir_uncertainty);
-            stability->InsertValue(pid, p.line_stability);
-
-            if(!cell_map[cid].Get())
-            {
-                cell_map[cid] = vtkSmartPointer<vtkIdList>::New();
-            }
-            cell_map[cid]->InsertNextId(pid);
+            all_results[search_ids[i]] = std::move(fresults[i]);
         }
+        fresults = std::move(all_results);
+
+        const auto reused = faces.size() - search_ids.size();
+        std::cout << "Incremental update: searched " << search_ids.size()
+                  << " changed faces, reused the results of " << reused
+                  << " faces ("
+                  << 100. * double(reused)
+                             / double(std::max<std::size_t>(faces.size(), 1))
+                  << "%)" << std::endl;
     }
 
-    output->SetLines(vtkCellArray::New());
-
-    auto cell_points = vtkSmartPointer<vtkIdList>::New();
+    auto end_pointsearch = high_resolution_clock::now();
 
-    for(const auto& c : cell_map)
+    if(this->GetAbortExecute())
     {
-        auto point_list = c.second;
-        auto npoints = point_list->GetNumberOfIds();
-        // For cells with exactly two parallel eigenvector points, connect them
-        // with a line
-        if(npoints == 2)
-        {
-            output->InsertNextCell(VTK_LINE, point_list);
-        }
-        else
+        // Only part of the faces were searched
+        _last_candidates.clear();
+        _last_candidates_key.clear();
+    }
+    else if(candidates_ptr)
+    {
+        if(!reused_candidates && !_candidate_cache_file.empty())
         {
-            // Match points by eigenvector direction
-
-            using Matrix3X = Eigen::Matrix3Xd;
-            using MatrixX = Eigen::MatrixXd;
-
-            // Get eigenvectors of cell points
-            auto eigdirs = Matrix3X(3, npoints).eval();
-            for(auto i : range(npoints))
+            try
             {
-                eigdirs.col(i) = Vec3dm{eivec->GetTuple(point_list->GetId(i))};
+                tl::writeCandidates(
+                        _candidate_cache_file, cache_key, _last_candidates);
             }
-
-            // Compute pairwise vector deviations
-            auto dist = MatrixX::Ones(npoints, npoints).eval();
-            for(auto i : range(npoints))
+            catch(const std::exception& e)
             {
-                for(auto j : range(i + 1, npoints))
-                {
-                    dist(i, j) =
-                            eigdirs.col(i).cross(eigdirs.col(j)).squaredNorm();
-                }
+                vtkWarningMacro(<< "Could not store the candidates: "
+                                << e.what());
             }
+        }
+        if(keep_candidates)
+        {
+            _last_candidates_key = last_run_key;
+        }
+        else
+        {
+            _last_candidates = CandidateList{};
+        }
+    }
 
-            // Greedily find closest two vectors and connect
-            auto unlinked = std::unordered_set<vtkIdType>{};
-            for(auto i : range(npoints))
-            {
-                unlinked.insert(i);
-            }
-            if(npoints < 10)
+    const auto attributes = outputAttributes(_output_attributes, opts);
+    if(!_stream_output_file.empty())
+    {
+        // Write the points face by face instead of building the output. The
+        // points are not needed afterwards unless kept for the next step.
+        const auto keep_results = this->GetIncremental()
+                                  && !this->GetAbortExecute();
+        output->Initialize();
+        try
+        {
+            auto writer = tl::StreamingLineWriter{_stream_output_file,
+                                                 _stream_output_format,
+                                                 attributes};
+            for(auto i : range(faces.size()))
             {
-                while(dist.sum() < double(npoints * npoints))
+                writer.addPoints(uint64_t(faces[i].cellId),
+                                 fresults[i].points);
+                if(!keep_results)
                 {
-                    auto row = Matrix3X::Index{};
-                    auto col = Matrix3X::Index{};
-                    dist.minCoeff(&row, &col);
-                    auto line = vtkSmartPointer<vtkIdList>::New();
-                    line->SetNumberOfIds(2);
-                    line->InsertId(0, point_list->GetId(row));
-                    line->InsertId(1, point_list->GetId(col));
-                    output->InsertNextCell(VTK_LINE, line);
-                    dist.col(col).setOnes();
-                    dist.col(row).setOnes();
-                    dist.row(col).setOnes();
-                    dist.row(row).setOnes();
-                    unlinked.erase(row);
-                    unlinked.erase(col);
+                    fresults[i].points = tl::PointList{};
                 }
             }
-
-            // Add vertex for last unlinked point if any
-            for(auto i : unlinked)
+            writer.finish();
+        }
+        catch(const std::exception& e)
+        {
+            // The faces and results were moved out of the incremental state
+            _incremental_state.reset();
+            vtkErrorMacro(<< e.what());
+            return 0;
+        }
+    }
+    else
+    {
+        buildLines(output, faces, fresults);
+        for(const auto& key : tl::lineAttributeKeys())
+        {
+            if(key != "pos"
+               && std::find(attributes.begin(), attributes.end(), key)
+                          == attributes.end())
             {
-                output->InsertNextCell(
-                        VTK_VERTEX, 1, point_list->GetPointer(i));
+                output->GetPointData()->RemoveArray(
+                        tl::lineAttributeName(key).c_str());
             }
         }
     }
@@ -772,7 +1425,99 @@ int vtkTensorLines::RequestData(vtkInformation* vtkNotUsed(request),
               << (milliseconds(duration_pointsearch) / faces.size()).count()
               << " milliseconds" << std::endl;
 
+    // Only count the faces searched in this run, not the reused results
+    auto num_splits = uint64_t{0};
+    auto max_level = uint64_t{0};
+    for(auto i : range(search_faces.size()))
+    {
+        const auto& r = fresults[incremental ? search_ids[i] : i];
+        num_splits += r.num_splits;
+        max_level = std::max(max_level, r.max_level);
+    }
+    // Keep the number of splits of each face to order the next search
+    _last_face_splits.clear();
+    if(!this->GetAbortExecute())
+    {
+        for(const auto& r : fresults)
+        {
+            _last_face_splits.push_back(r.num_splits);
+        }
+    }
+    std::cout << "Number of subdivision cells evaluated: " << num_splits
+              << std::endl;
+    std::cout << "Maximum subdivision level: " << max_level << std::endl;
+    if(cache)
+    {
+        auto lookups = std::max<uint64_t>(cache->hits() + cache->misses(), 1);
+        std::cout << "Face result cache: " << cache->hits() << " hits, "
+                  << cache->misses() << " misses ("
+                  << 100. * double(cache->hits()) / double(lookups)
+                  << "% hit rate)" << std::endl;
+    }
+
+    // Keep the state for the next time step
+    if(this->GetIncremental() && !this->GetAbortExecute())
+    {
+        if(!state)
+        {
+            _incremental_state.reset(new IncrementalState{});
+            state = _incremental_state.get();
+            state->key = results_key.str();
+            state->num_cells = input->GetNumberOfCells();
+            state->points = pointCoordinates(input->GetPoints());
+            state->tensors1 = std::move(tensors1);
+            state->tensors2 = std::move(tensors2);
+            state->derivs = derivs;
+        }
+        else
+        {
+            // Only the faces of the flagged points and cells were searched
+            // again, the others keep the results of the compared tensors
+            updateChangedPoints(tensors1, changed_points, state->tensors1);
+            updateChangedPoints(tensors2, changed_points, state->tensors2);
+            if(_line_type == LineType::TensorCoreLines)
+            {
+                updateChangedCells(derivs, changed_cells, state->derivs);
+            }
+        }
+        state->faces = std::move(faces);
+        state->results = std::move(fresults);
+    }
+    else
+    {
+        _incremental_state.reset();
+    }
+
     this->UpdateProgress(1.);
 
     return 1;
 }
+
+
+std::string vtkTensorLines::SearchKey(vtkDataArray* array1,
+                                      vtkDataArray* array2,
+                                      const tl::TLOptions& opts) const
+{
+    // The clustering options do not change the candidates. The coarse
+    // levels and the seeding change the split counts and which faces
+    // exceed the maximum number of candidates.
+    auto key = std::ostringstream{};
+    key << std::hexfloat;
+    // The candidates are stored per face, in the order of buildFaceList()
+    key << "face order morton\n";
+    key << "line type " << _line_type << '\n';
+    key << "fields " << (array1 && array1->GetName() ? array1->GetName() : "")
+        << ' ';
+    if(_line_type == LineType::ParallelEigenvectors)
+    {
+        key << (array2 && array2->GetName() ? array2->GetName() : "");
+    }
+    key << '\n';
+    key << "tolerance " << opts.tolerance << '\n';
+    key << "max candidates " << opts.max_candidates << '\n';
+    key << "start mesh " << int(opts.start_mesh) << ' '
+        << opts.start_mesh_level << '\n';
+    key << "coarse levels " << opts.coarse_levels << '\n';
+    key << "seeded search " << opts.seeded_search << '\n';
+    return key.str();
+}
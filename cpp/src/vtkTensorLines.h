@@ -1,10 +1,25 @@
 #ifndef CPP_VTK_TENSOR_LINES_HH
 #define CPP_VTK_TENSOR_LINES_HH
 
+#include "TensorLineDefinitions.hh"
+
 #include "vtkAlgorithm.h"
 
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class vtkDataArray;
 class vtkPolyData;
 
+namespace tl
+{
+struct TLCandidates;
+struct TLOptions;
+enum class LineFileFormat : int;
+}
+
 class VTK_EXPORT vtkTensorLines : public vtkAlgorithm
 {
 public:
@@ -51,6 +66,189 @@ public:
         this->Modified();
     }
 
+    std::size_t GetCoarseLevels() const
+    {
+        return _coarse_levels;
+    }
+    void SetCoarseLevels(int value)
+    {
+        _coarse_levels = value;
+        this->Modified();
+    }
+
+    int GetStartMesh() const
+    {
+        return static_cast<int>(_start_mesh);
+    }
+    void SetStartMesh(int value)
+    {
+        _start_mesh = tl::StartMesh(value);
+        this->Modified();
+    }
+
+    std::size_t GetStartMeshLevel() const
+    {
+        return _start_mesh_level;
+    }
+    void SetStartMeshLevel(int value)
+    {
+        _start_mesh_level = value;
+        this->Modified();
+    }
+
+    bool GetSeededSearch() const
+    {
+        return _seeded_search;
+    }
+    void SetSeededSearch(bool value)
+    {
+        _seeded_search = value;
+        this->Modified();
+    }
+
+    // Context info computed for the found points. Output arrays of
+    // attributes that are not computed are omitted.
+    bool GetComputeEigenvalues() const
+    {
+        return _compute_eigenvalues;
+    }
+    void SetComputeEigenvalues(bool value)
+    {
+        _compute_eigenvalues = value;
+        this->Modified();
+    }
+
+    bool GetComputeRanks() const
+    {
+        return _compute_ranks;
+    }
+    void SetComputeRanks(bool value)
+    {
+        _compute_ranks = value;
+        this->Modified();
+    }
+
+    bool GetComputeLineStability() const
+    {
+        return _compute_line_stability;
+    }
+    void SetComputeLineStability(bool value)
+    {
+        _compute_line_stability = value;
+        this->Modified();
+    }
+
+    bool GetCacheFaceResults() const
+    {
+        return _cache_face_results;
+    }
+    void SetCacheFaceResults(bool value)
+    {
+        _cache_face_results = value;
+        this->Modified();
+    }
+
+    // Partition the faces by NUMA node and pin each thread to the CPUs of a
+    // node (Linux only), so that the threads of each node search faces whose
+    // input lies in its memory. Ignored with a warning on a single node.
+    bool GetNumaLocal() const
+    {
+        return _numa_local;
+    }
+    void SetNumaLocal(bool value)
+    {
+        _numa_local = value;
+        this->Modified();
+    }
+
+    // Keep the unclustered candidates of the last run in memory, so that a
+    // run on the same input with other clustering options skips the search
+    bool GetKeepCandidates() const
+    {
+        return _keep_candidates;
+    }
+    void SetKeepCandidates(bool value)
+    {
+        _keep_candidates = value;
+        this->Modified();
+    }
+
+    // Keep the faces, derivatives and face results between runs on the same
+    // mesh and only search the faces whose tensors changed (time series)
+    bool GetIncremental() const
+    {
+        return _incremental;
+    }
+    void SetIncremental(bool value)
+    {
+        _incremental = value;
+        this->Modified();
+    }
+
+    // Largest change of a tensor component that does not trigger a new
+    // search of the incident faces in incremental mode
+    double GetIncrementalThreshold() const
+    {
+        return _incremental_threshold;
+    }
+    void SetIncrementalThreshold(double value)
+    {
+        _incremental_threshold = value;
+        this->Modified();
+    }
+
+    // File storing the unclustered candidates between runs on the same input,
+    // identified by input_key. An empty file name disables the cache.
+    const std::string& GetCandidateCacheFile() const
+    {
+        return _candidate_cache_file;
+    }
+    void SetCandidateCache(const std::string& file,
+                           const std::string& input_key)
+    {
+        _candidate_cache_file = file;
+        _candidate_cache_input = input_key;
+        this->Modified();
+    }
+
+    // VTK XML poly data file (.vtp) the points and lines are streamed to
+    // instead of building the output dataset, which then stays empty. An
+    // empty file name disables streaming. The points of all faces are held
+    // until the search ends and are written and freed afterwards.
+    const std::string& GetStreamOutputFile() const
+    {
+        return _stream_output_file;
+    }
+    void SetStreamOutputFile(const std::string& file)
+    {
+        _stream_output_file = file;
+        this->Modified();
+    }
+
+    // Format of the streamed output (tl::LineFileFormat). With the .npy
+    // format, the stream output file is the prefix of the column files.
+    int GetStreamOutputFormat() const
+    {
+        return int(_stream_output_format);
+    }
+    void SetStreamOutputFormat(int value)
+    {
+        _stream_output_format = tl::LineFileFormat(value);
+        this->Modified();
+    }
+
+    // Keys of the point attributes in the output (see tl::lineAttributeKeys),
+    // all if empty. The points are always part of VTK outputs.
+    const std::vector<std::string>& GetOutputAttributes() const
+    {
+        return _output_attributes;
+    }
+    void SetOutputAttributes(const std::vector<std::string>& keys)
+    {
+        _output_attributes = keys;
+        this->Modified();
+    }
+
     int GetLineType() const
     {
         return _line_type;
@@ -72,7 +270,7 @@ public:
 
 protected:
     vtkTensorLines();
-    ~vtkTensorLines() VTK_OVERRIDE {}
+    ~vtkTensorLines() VTK_OVERRIDE;
 
     // This is called by the superclass.
     // This is the method you should override.
@@ -102,11 +300,38 @@ protected:
     int FillInputPortInformation(int port,
                                  vtkInformation* info) override;
 
+    // Key of the options that change the unclustered candidates
+    std::string SearchKey(vtkDataArray* array1,
+                          vtkDataArray* array2,
+                          const tl::TLOptions& opts) const;
+
 private:
     //BTX
     double _tolerance = 1e-6;
     double _cluster_epsilon = 1e-4;
     std::size_t _max_candidates = 100;
+    std::size_t _coarse_levels = 0;
+    tl::StartMesh _start_mesh = tl::StartMesh::Octants;
+    std::size_t _start_mesh_level = 1;
+    bool _seeded_search = false;
+    bool _compute_eigenvalues = true;
+    bool _compute_ranks = true;
+    bool _compute_line_stability = true;
+    bool _cache_face_results = false;
+    bool _numa_local = false;
+    std::string _candidate_cache_file;
+    std::string _candidate_cache_input;
+    bool _keep_candidates = true;
+    std::vector<tl::TLCandidates> _last_candidates;
+    std::string _last_candidates_key;
+    std::vector<uint64_t> _last_face_splits;
+    bool _incremental = false;
+    double _incremental_threshold = 0.;
+    struct IncrementalState;
+    std::unique_ptr<IncrementalState> _incremental_state;
+    std::string _stream_output_file;
+    tl::LineFileFormat _stream_output_format = tl::LineFileFormat(0);
+    std::vector<std::string> _output_attributes;
     LineType _line_type = LineType::TensorCoreLines;
     //ETX
 };